@@ -0,0 +1,209 @@
+// Measures address lookups of CoreAddressIndex on a synthetic set of ranges, in both layouts, one by one and in
+//   batches, against a linear scan of the segments (for small sets)
+//   Usage: addressIndexBenchmark [rangeCount] [lookupCount]
+
+#include <cstdio>
+#include <cstdlib>
+
+#include <chrono>
+#include <functional>
+#include <memory>
+#include <random>
+#include <vector>
+
+#include "MMD/CoreAddressIndex.hpp"
+
+namespace {
+
+using MMD::CoreAddressIndex;
+
+constexpr uint64_t PageSize		  = 4096;
+constexpr uint64_t FileSize		  = 1024 * 1024; // Ranges share the data of this "file", as deduplicated segments do
+constexpr size_t   LinearScanLimit = 4096;		   // Range count above which the linear scan is not measured
+
+struct Setup {
+	std::vector<char>					 fileData;
+	std::vector<CoreAddressIndex::Range> ranges;
+	std::vector<uint64_t>				 addresses;
+};
+
+// Ranges of 1-16 pages, some adjacent, some separated by gaps; 90% of the addresses are within ranges
+void CreateSetup (size_t rangeCount, size_t lookupCount, Setup* pSetupOut)
+{
+	std::mt19937_64 random (rangeCount);
+
+	pSetupOut->fileData.assign (FileSize, 0);
+	for (size_t i = 0; i < FileSize; ++i)
+		pSetupOut->fileData[i] = char (random ());
+
+	uint64_t address = 0x100000000;
+	for (size_t i = 0; i < rangeCount; ++i) {
+		const uint64_t size		  = (1 + random () % 16) * PageSize;
+		const uint64_t fileOffset = random () % ((FileSize - size) / PageSize) * PageSize;
+		pSetupOut->ranges.push_back ({ address, size, fileOffset });
+
+		address += size + (random () % 2 == 0 ? 0 : random () % 16 * PageSize);
+	}
+
+	const uint64_t lowest  = pSetupOut->ranges.front ().address;
+	const uint64_t highest = address;
+	for (size_t i = 0; i < lookupCount; ++i) {
+		if (random () % 10 == 0) {
+			pSetupOut->addresses.push_back (lowest - PageSize + random () % (highest - lowest + 2 * PageSize));
+		} else {
+			const CoreAddressIndex::Range& range = pSetupOut->ranges[random () % rangeCount];
+			pSetupOut->addresses.push_back (range.address + random () % range.size);
+		}
+	}
+}
+
+// Returns a checksum of the results, so that they can be compared, and the work is not optimized away
+uint64_t Measure (const char*						pMethodName,
+				  const char*						pOperationName,
+				  size_t							lookupCount,
+				  const std::function<uint64_t ()>& function)
+{
+	const auto	   start	= std::chrono::steady_clock::now ();
+	const uint64_t checksum = function ();
+	const auto	   end		= std::chrono::steady_clock::now ();
+
+	const double nanoseconds = std::chrono::duration<double, std::nano> (end - start).count ();
+	printf ("  %-12s %-10s %8.2f ns/lookup %10.2f M lookups/s\n",
+			pMethodName,
+			pOperationName,
+			nanoseconds / lookupCount,
+			lookupCount / nanoseconds * 1000.0);
+
+	return checksum;
+}
+
+// Sum of the indices of the ranges found (plus one, so that misses count as zero)
+uint64_t SumOfIndices (const size_t* pRangeIndices, size_t count)
+{
+	uint64_t sum = 0;
+	for (size_t i = 0; i < count; ++i)
+		sum += pRangeIndices[i] == CoreAddressIndex::NotFound ? 0 : pRangeIndices[i] + 1;
+
+	return sum;
+}
+
+bool Run (size_t rangeCount, size_t lookupCount)
+{
+	Setup setup;
+	CreateSetup (rangeCount, lookupCount, &setup);
+
+	const CoreAddressIndex sortedIndex (setup.fileData.data (),
+										setup.fileData.size (),
+										setup.ranges.data (),
+										setup.ranges.size (),
+										CoreAddressIndex::Layout::Sorted);
+	const CoreAddressIndex eytzingerIndex (setup.fileData.data (),
+										   setup.fileData.size (),
+										   setup.ranges.data (),
+										   setup.ranges.size (),
+										   CoreAddressIndex::Layout::Eytzinger);
+	if (!sortedIndex.IsValid () || !eytzingerIndex.IsValid () || sortedIndex.GetRangeCount () != rangeCount) {
+		printf ("Failed to build the indices\n");
+
+		return false;
+	}
+
+	printf ("%zu ranges, %zu lookups:\n", rangeCount, lookupCount);
+
+	const std::vector<uint64_t>& addresses = setup.addresses;
+	std::vector<uint64_t>		 lookupChecksums;
+	std::vector<uint64_t>		 readChecksums;
+
+	if (rangeCount <= LinearScanLimit) {
+		lookupChecksums.push_back (Measure ("Linear scan", "Find", lookupCount, [&] () {
+			uint64_t sum = 0;
+			for (uint64_t address : addresses) {
+				for (size_t i = 0; i < setup.ranges.size (); ++i) {
+					const CoreAddressIndex::Range& range = setup.ranges[i];
+					if (address >= range.address && address - range.address < range.size) {
+						sum += i + 1;
+						break;
+					}
+				}
+			}
+
+			return sum;
+		}));
+	}
+
+	for (const CoreAddressIndex* pIndex : { &sortedIndex, &eytzingerIndex }) {
+		const char* pLayoutName = pIndex == &sortedIndex ? "Sorted" : "Eytzinger";
+
+		lookupChecksums.push_back (Measure (pLayoutName, "Find", lookupCount, [&] () {
+			uint64_t sum = 0;
+			for (uint64_t address : addresses) {
+				const size_t rangeIndex = pIndex->Find (address);
+				sum += rangeIndex == CoreAddressIndex::NotFound ? 0 : rangeIndex + 1;
+			}
+
+			return sum;
+		}));
+
+		std::vector<size_t> rangeIndices (lookupCount);
+		lookupChecksums.push_back (Measure (pLayoutName, "FindBatch", lookupCount, [&] () {
+			pIndex->FindBatch (addresses.data (), lookupCount, rangeIndices.data ());
+
+			return SumOfIndices (rangeIndices.data (), lookupCount);
+		}));
+
+		// Reads of 8 bytes (e.g. of pointers, while walking stacks); the checksum is the sum of the values read
+		std::vector<uint64_t> values (lookupCount);
+		readChecksums.push_back (Measure (pLayoutName, "Read", lookupCount, [&] () {
+			uint64_t sum = 0;
+			for (size_t i = 0; i < lookupCount; ++i)
+				sum += pIndex->Read (addresses[i], sizeof (uint64_t), &values[i]) ? values[i] : 0;
+
+			return sum;
+		}));
+
+		std::vector<CoreAddressIndex::ReadRequest> requests;
+		for (size_t i = 0; i < lookupCount; ++i)
+			requests.push_back ({ addresses[i], sizeof (uint64_t), &values[i] });
+
+		std::unique_ptr<bool[]> pResults (new bool[lookupCount]);
+		readChecksums.push_back (Measure (pLayoutName, "ReadBatch", lookupCount, [&] () {
+			pIndex->ReadBatch (requests.data (), requests.size (), pResults.get ());
+
+			uint64_t sum = 0;
+			for (size_t i = 0; i < lookupCount; ++i)
+				sum += pResults[i] ? values[i] : 0;
+
+			return sum;
+		}));
+	}
+
+	for (const std::vector<uint64_t>* pChecksums : { &lookupChecksums, &readChecksums }) {
+		for (uint64_t checksum : *pChecksums) {
+			if (checksum != pChecksums->front ()) {
+				printf ("Results differ\n");
+
+				return false;
+			}
+		}
+	}
+
+	return true;
+}
+
+} // namespace
+
+int main (int argc, char* argv[])
+{
+	const size_t lookupCount = argc > 2 ? strtoull (argv[2], nullptr, 10) : 4 * 1000 * 1000;
+
+	std::vector<size_t> rangeCounts = { 64, 4096, 262144 };
+	if (argc > 1)
+		rangeCounts = { size_t (strtoull (argv[1], nullptr, 10)) };
+
+	for (size_t rangeCount : rangeCounts) {
+		if (rangeCount == 0 || lookupCount == 0 || !Run (rangeCount, lookupCount))
+			return 1;
+	}
+
+	return 0;
+}
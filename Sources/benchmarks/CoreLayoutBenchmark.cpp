@@ -0,0 +1,136 @@
+// Measures how laying out the payloads of MachOCoreDumpBuilder scales with the number of segments: the time per segment
+//   should stay the same as the segment count grows. Nothing is read from a process, segments share a static buffer.
+//   Measure Release builds: Debug builds check every write against all previous ones, which makes Build quadratic.
+//   Usage: coreLayoutBenchmark [segmentCount]
+
+#include <cstdio>
+#include <cstdlib>
+
+#include <algorithm>
+#include <chrono>
+#include <functional>
+#include <vector>
+
+#include "MMD/IRandomAccessBinaryOStream.hpp"
+#include "MachOCoreDumpBuilder.hpp"
+
+namespace {
+
+using MMD::DataProvider;
+using MMD::MachOCoreDumpBuilder;
+using MMD::PlainDataPtr;
+
+constexpr size_t   SegmentSize = 256;
+constexpr uint64_t PageSize	   = 4096;
+
+char g_segmentData[SegmentSize];
+
+// Counts the bytes written, so that only the work of the builder is measured
+class DiscardingOStream : public MMD::IRandomAccessBinaryOStream {
+public:
+	DiscardingOStream (): m_position (0), m_size (0) {}
+
+	virtual bool Write (const void* /*pData*/, size_t size) override
+	{
+		m_position += size;
+		m_size = std::max (m_size, m_position);
+
+		return true;
+	}
+
+	virtual bool Flush () override { return true; }
+
+	virtual size_t GetPosition () override { return m_position; }
+	virtual void   SetPosition (size_t newPos) override { m_position = newPos; }
+
+	virtual size_t GetSize () override { return m_size; }
+	virtual bool   SetSize (size_t newSize) override
+	{
+		m_size = newSize;
+
+		return true;
+	}
+
+private:
+	size_t m_position;
+	size_t m_size;
+};
+
+double Measure (const char* pOperationName, size_t segmentCount, const std::function<bool ()>& function)
+{
+	const auto start	 = std::chrono::steady_clock::now ();
+	const bool succeeded = function ();
+	const auto end		 = std::chrono::steady_clock::now ();
+
+	const double nanoseconds = std::chrono::duration<double, std::nano> (end - start).count ();
+	printf ("  %-14s %10.2f ms %8.2f ns/segment\n", pOperationName, nanoseconds / 1e6, nanoseconds / segmentCount);
+
+	return succeeded ? nanoseconds : -1.0;
+}
+
+bool Run (size_t segmentCount)
+{
+	printf ("%zu segments:\n", segmentCount);
+
+	MachOCoreDumpBuilder builder;
+
+	const double addTime = Measure ("Add", segmentCount, [&] () {
+		for (size_t i = 0; i < segmentCount; ++i) {
+			auto pDataProvider = std::make_unique<DataProvider> (new PlainDataPtr (g_segmentData), SegmentSize);
+			if (!builder.AddSegmentCommand (0x100000000 + i * PageSize, VM_PROT_READ, std::move (pDataProvider)))
+				return false;
+		}
+
+		return true;
+	});
+
+	const double layoutTime = Measure ("Finalize", segmentCount, [&] () {
+		builder.FinalizeLoadCommands ();
+
+		return builder.GetNumberOfSegmentCommands () == segmentCount;
+	});
+
+	// Every payload follows the previous one, so the offsets must be increasing
+	const double lookupTime = Measure ("Offset lookups", segmentCount, [&] () {
+		uint64_t previousOffset = 0;
+		for (size_t i = 0; i < segmentCount; ++i) {
+			uint64_t offset = 0;
+			if (!builder.GetOffsetForSegmentCommandPayload (i, &offset) || offset < previousOffset + SegmentSize)
+				return false;
+
+			previousOffset = offset;
+		}
+
+		return true;
+	});
+
+	DiscardingOStream oStream;
+
+	const double buildTime = Measure ("Build", segmentCount, [&] () {
+		return builder.Build (&oStream) && oStream.GetSize () == builder.GetCoreFileSize ();
+	});
+
+	if (addTime < 0.0 || layoutTime < 0.0 || lookupTime < 0.0 || buildTime < 0.0) {
+		printf ("Failed to build the core\n");
+
+		return false;
+	}
+
+	return true;
+}
+
+} // namespace
+
+int main (int argc, char* argv[])
+{
+	std::vector<size_t> segmentCounts = { 1000, 10000, 100000 };
+	if (argc > 1)
+		segmentCounts = { size_t (strtoull (argv[1], nullptr, 10)) };
+
+	for (size_t segmentCount : segmentCounts) {
+		if (segmentCount == 0 || !Run (segmentCount))
+			return 1;
+	}
+
+	return 0;
+}
@@ -0,0 +1,146 @@
+// Measures how much overlapping the reads and the writes of segment payloads (MachOCoreDumpBuilder pipelining) saves.
+//   Reading and writing are simulated by sleeping for a fixed time per MiB, so results don't depend on the machine: the
+//   serial loop should take about the sum of both, pipelining about the larger of the two.
+//   Usage: payloadPipelineBenchmark [segmentCount] [readMicrosecondsPerMiB] [writeMicrosecondsPerMiB]
+
+#include <cstdio>
+#include <cstdlib>
+
+#include <algorithm>
+#include <chrono>
+#include <thread>
+#include <vector>
+
+#include "MMD/IRandomAccessBinaryOStream.hpp"
+#include "MachOCoreDumpBuilder.hpp"
+
+namespace {
+
+using MMD::DataProvider;
+using MMD::MachOCoreDumpBuilder;
+
+constexpr size_t SegmentSize = 4 * 1024 * 1024;
+constexpr size_t ChunkSize	 = 1024 * 1024;
+constexpr size_t MiB		 = 1024 * 1024;
+
+std::vector<char> g_segmentData (SegmentSize, 'x');
+
+void SimulateLatency (size_t size, size_t microsecondsPerMiB)
+{
+	std::this_thread::sleep_for (std::chrono::microseconds (size * microsecondsPerMiB / MiB));
+}
+
+// Reads as slowly as configured, like reading the memory of another process would
+class SlowDataPtr : public MMD::IDataPtr {
+public:
+	explicit SlowDataPtr (size_t microsecondsPerMiB): m_microsecondsPerMiB (microsecondsPerMiB) {}
+
+	virtual const char* Get (size_t offset, size_t size) override
+	{
+		SimulateLatency (size, m_microsecondsPerMiB);
+
+		return g_segmentData.data () + offset;
+	}
+
+	virtual const char* Get () override { return Get (0, SegmentSize); }
+
+private:
+	size_t m_microsecondsPerMiB;
+};
+
+// Discards what is written, as slowly as configured
+class SlowOStream : public MMD::IRandomAccessBinaryOStream {
+public:
+	explicit SlowOStream (size_t microsecondsPerMiB):
+		m_microsecondsPerMiB (microsecondsPerMiB),
+		m_position (0),
+		m_size (0)
+	{
+	}
+
+	virtual bool Write (const void* /*pData*/, size_t size) override
+	{
+		SimulateLatency (size, m_microsecondsPerMiB);
+
+		m_position += size;
+		m_size = std::max (m_size, m_position);
+
+		return true;
+	}
+
+	virtual bool Flush () override { return true; }
+
+	virtual size_t GetPosition () override { return m_position; }
+	virtual void   SetPosition (size_t newPos) override { m_position = newPos; }
+
+	virtual size_t GetSize () override { return m_size; }
+	virtual bool   SetSize (size_t newSize) override
+	{
+		m_size = newSize;
+
+		return true;
+	}
+
+private:
+	size_t m_microsecondsPerMiB;
+	size_t m_position;
+	size_t m_size;
+};
+
+// Returns the time Build took in milliseconds, or a negative value on failure
+double Run (size_t segmentCount, size_t pipelineDepth, size_t readMicrosecondsPerMiB, size_t writeMicrosecondsPerMiB)
+{
+	MachOCoreDumpBuilder builder;
+	builder.SetPayloadPipelining (ChunkSize, pipelineDepth);
+
+	for (size_t i = 0; i < segmentCount; ++i) {
+		auto pDataProvider = std::make_unique<DataProvider> (new SlowDataPtr (readMicrosecondsPerMiB), SegmentSize);
+		if (!builder.AddSegmentCommand (0x100000000 + i * SegmentSize, VM_PROT_READ, std::move (pDataProvider)))
+			return -1.0;
+	}
+
+	SlowOStream oStream (writeMicrosecondsPerMiB);
+
+	const auto start	 = std::chrono::steady_clock::now ();
+	const bool succeeded = builder.Build (&oStream);
+	const auto end		 = std::chrono::steady_clock::now ();
+
+	if (!succeeded || oStream.GetSize () != builder.GetCoreFileSize ())
+		return -1.0;
+
+	return std::chrono::duration<double, std::milli> (end - start).count ();
+}
+
+} // namespace
+
+int main (int argc, char* argv[])
+{
+	const size_t segmentCount			 = argc > 1 ? strtoull (argv[1], nullptr, 10) : 64;
+	const size_t readMicrosecondsPerMiB	 = argc > 2 ? strtoull (argv[2], nullptr, 10) : 1000;
+	const size_t writeMicrosecondsPerMiB = argc > 3 ? strtoull (argv[3], nullptr, 10) : 1000;
+	if (segmentCount == 0)
+		return 1;
+
+	printf ("%zu segments of %zu MiB, reading %zu us/MiB, writing %zu us/MiB:\n",
+			segmentCount,
+			SegmentSize / MiB,
+			readMicrosecondsPerMiB,
+			writeMicrosecondsPerMiB);
+
+	double serialTime = 0.0;
+	for (size_t pipelineDepth : { 1, 2, 4, 8 }) {
+		const double time = Run (segmentCount, pipelineDepth, readMicrosecondsPerMiB, writeMicrosecondsPerMiB);
+		if (time < 0.0) {
+			printf ("Failed to build the core\n");
+
+			return 1;
+		}
+
+		if (pipelineDepth == 1)
+			serialTime = time;
+
+		printf ("  depth %zu %10.2f ms %6.2fx\n", pipelineDepth, time, serialTime / time);
+	}
+
+	return 0;
+}
@@ -0,0 +1,148 @@
+// Measures writing a file through MmapOStream against FileOStream: front to back with small and with large writes, and
+//   with large positional writes from several threads at once (like the parallel payload writer). Flushing is part of
+//   the measurement, as MmapOStream only writes back dirty pages then. Use a path on the file system of interest.
+//   Usage: streamBenchmark [filePath] [sizeInMiB]
+
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <cstdio>
+#include <cstdlib>
+
+#include <algorithm>
+#include <chrono>
+#include <functional>
+#include <memory>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#include "MMD/FileOStream.hpp"
+#include "MMD/MmapOStream.hpp"
+
+namespace {
+
+constexpr size_t MiB			= 1024 * 1024;
+constexpr size_t SmallWriteSize = 4096;
+constexpr size_t LargeWriteSize = MiB;
+constexpr size_t ThreadCount	= 4;
+
+using CreateStream = std::function<std::unique_ptr<MMD::IRandomAccessBinaryOStream> (int fd)>;
+using WriteFile	   = std::function<bool (MMD::IRandomAccessBinaryOStream* pOStream)>;
+
+bool WriteSequentially (MMD::IRandomAccessBinaryOStream* pOStream, const std::vector<char>& data, size_t fileSize)
+{
+	for (size_t offset = 0; offset < fileSize; offset += data.size ()) {
+		if (!pOStream->Write (data.data (), data.size ()))
+			return false;
+	}
+
+	return true;
+}
+
+// Thread i writes every ThreadCount-th block, starting with block i
+bool WriteInParallel (MMD::IRandomAccessBinaryOStream* pOStream, const std::vector<char>& data, size_t fileSize)
+{
+	std::vector<std::thread> threads;
+	std::vector<char>		 results (ThreadCount, 0);
+	for (size_t i = 0; i < ThreadCount; ++i) {
+		threads.emplace_back ([&, i] () {
+			for (size_t offset = i * data.size (); offset < fileSize; offset += ThreadCount * data.size ()) {
+				if (!pOStream->WriteAt (data.data (), data.size (), offset))
+					return;
+			}
+
+			results[i] = 1;
+		});
+	}
+
+	for (std::thread& thread : threads)
+		thread.join ();
+
+	return std::find (results.begin (), results.end (), 0) == results.end ();
+}
+
+bool Measure (const char*		  pStreamName,
+			  const char*		  pWriteName,
+			  const char*		  pFilePath,
+			  size_t			  fileSize,
+			  const CreateStream& createStream,
+			  const WriteFile&	  writeFile)
+{
+	const int fd = open (pFilePath, O_RDWR | O_CREAT | O_TRUNC, 0666);
+	if (fd < 0) {
+		printf ("Failed to create %s\n", pFilePath);
+
+		return false;
+	}
+
+	const auto start = std::chrono::steady_clock::now ();
+	{
+		std::unique_ptr<MMD::IRandomAccessBinaryOStream> pOStream = createStream (fd);
+		if (!writeFile (pOStream.get ()) || !pOStream->Flush ()) {
+			printf ("Failed to write %s\n", pFilePath);
+
+			return false;
+		}
+	}
+	const auto end = std::chrono::steady_clock::now ();
+
+	struct stat fileInfo;
+	if (stat (pFilePath, &fileInfo) != 0 || size_t (fileInfo.st_size) != fileSize) {
+		printf ("%s wrote a file of the wrong size\n", pStreamName);
+
+		return false;
+	}
+
+	unlink (pFilePath);
+
+	const double seconds = std::chrono::duration<double> (end - start).count ();
+	printf ("  %-12s %-18s %10.2f ms %10.2f MiB/s\n", pStreamName, pWriteName, seconds * 1e3, fileSize / MiB / seconds);
+
+	return true;
+}
+
+} // namespace
+
+int main (int argc, char* argv[])
+{
+	const char*	 pFilePath = argc > 1 ? argv[1] : "streamBenchmark.tmp";
+	const size_t fileSize  = (argc > 2 ? strtoull (argv[2], nullptr, 10) : 256) * MiB;
+	if (fileSize == 0)
+		return 1;
+
+	const std::vector<char> smallWrite (SmallWriteSize, 'x');
+	const std::vector<char> largeWrite (LargeWriteSize, 'x');
+
+	const std::pair<const char*, CreateStream> streams[] = {
+		{ "FileOStream", [] (int fd) { return std::make_unique<MMD::FileOStream> (fd); } },
+		{ "MmapOStream", [] (int fd) { return std::make_unique<MMD::MmapOStream> (fd); } },
+	};
+
+	const std::pair<const char*, WriteFile> writes[] = {
+		{ "Sequential 4 KiB",
+		  [&] (MMD::IRandomAccessBinaryOStream* pOStream) {
+			  return WriteSequentially (pOStream, smallWrite, fileSize);
+		  } },
+		{ "Sequential 1 MiB",
+		  [&] (MMD::IRandomAccessBinaryOStream* pOStream) {
+			  return WriteSequentially (pOStream, largeWrite, fileSize);
+		  } },
+		{ "Parallel 1 MiB",
+		  [&] (MMD::IRandomAccessBinaryOStream* pOStream) {
+			  return WriteInParallel (pOStream, largeWrite, fileSize);
+		  } },
+	};
+
+	printf ("%zu MiB to %s:\n", fileSize / MiB, pFilePath);
+
+	for (const auto& write : writes) {
+		for (const auto& stream : streams) {
+			if (!Measure (stream.first, write.first, pFilePath, fileSize, stream.second, write.second))
+				return 1;
+		}
+	}
+
+	return 0;
+}
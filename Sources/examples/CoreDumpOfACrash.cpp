@@ -1,11 +1,15 @@
-#include <fcntl.h>
 #include <mach/mach.h>
 #include <pthread.h>
 #include <unistd.h>
 
-#include "MMD/FileOStream.hpp"
+#include <algorithm>
+
+#include "MMD/DumpFilePool.hpp"
 #include "MMD/MacMiniDump.hpp"
 
+// Slot files are created up front, so that the signal handler does not have to create (or grow) a file
+MMD::DumpFilePool* g_pDumpFilePool = nullptr;
+
 void SignalHandler (int /*signal*/, siginfo_t* /*pSigInfo*/, void* pContext)
 {
 	__darwin_ucontext* ucontext		= (__darwin_ucontext*) pContext;
@@ -13,15 +17,14 @@ void SignalHandler (int /*signal*/, siginfo_t* /*pSigInfo*/, void* pContext)
 	crashContext.mcontext			= *reinterpret_cast<__darwin_mcontext64*> (ucontext->uc_mcontext);
 	pthread_threadid_np (NULL, &crashContext.crashedTID);
 
-	const char* pCorePath = "/tmp/test.core";
-	// Make sure the destination file exists and is empty
-	int fd = open (pCorePath, O_WRONLY | O_CREAT | O_TRUNC, 0666);
-	if (fd >= 0)
-		close (fd);
-
-	MMD::FileOStream fos (pCorePath);
-
-	MiniDumpWriteDump (mach_task_self (), &fos);
+	MMD::IRandomAccessBinaryOStream* pOStream = g_pDumpFilePool->AcquireSlot ();
+	if (pOStream != nullptr && MiniDumpWriteDump (mach_task_self (), pOStream, &crashContext)) {
+		g_pDumpFilePool->CommitSlot ();
+	} else {
+		// write is async-signal-safe, unlike stdio
+		const char message[] = "Failed to write the core file (is it larger than a slot?)\n";
+		write (STDERR_FILENO, message, sizeof message - 1);
+	}
 
 	kill (getpid (), SIGKILL);
 }
@@ -42,6 +45,22 @@ void SetupSignalHandler (void (*handler) (int, siginfo_t*, void*))
 
 int main ()
 {
+	// The capacity of a slot has to exceed the size of the core file written into it, otherwise writing fails (silently,
+	//   in the signal handler). It's estimated from the current state of the process, leaving room for it to grow.
+	MMDStatistics statistics = {};
+	if (!MMD::MiniDumpEstimateSize (mach_task_self (), &statistics))
+		return 1;
+
+	const size_t slotSize = std::max<size_t> (4 * statistics.coreFileSize, 64 * 1'024 * 1'024);
+
+	// Two slots in /tmp: the core files of the last two crashes are kept. The most recent one can be retrieved on the
+	//   next launch with GetSlotInfo and CopySlot.
+	static MMD::DumpFilePool dumpFilePool ("/tmp", 2, slotSize);
+	if (!dumpFilePool.IsValid ())
+		return 1;
+
+	g_pDumpFilePool = &dumpFilePool;
+
 	SetupSignalHandler (SignalHandler);
 
 	[[maybe_unused]] int i = *(volatile int*) 0;
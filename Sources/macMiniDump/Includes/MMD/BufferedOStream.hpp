@@ -0,0 +1,54 @@
+#ifndef MMD_BUFFEREDOSTREAM
+#define MMD_BUFFEREDOSTREAM
+
+#pragma once
+
+#include <cstddef>
+
+#include "MMD/IRandomAccessBinaryOStream.hpp"
+
+namespace MMD {
+
+// Decorator coalescing small writes to another stream: consecutive writes are collected in a buffer, which is written
+//   to the underlying stream in one go when it is full, when a write does not continue where the previous one ended
+//   (e.g. after seeking elsewhere), and on Flush. Writes at least as large as the buffer bypass it.
+//   Data still in the buffer is written on destruction too, but errors are only reported by Flush.
+class BufferedOStream : public IRandomAccessBinaryOStream {
+public:
+	static const size_t DefaultBufferSize = 256 * 1'024;
+
+	// Constructors
+	BufferedOStream () = delete;
+	explicit BufferedOStream (IRandomAccessBinaryOStream* pOStream, size_t bufferSize = DefaultBufferSize);
+
+	// Inherited from IRandomAccessBinaryOStream
+	virtual bool Write (const void* pData, size_t size) override;
+
+	virtual bool Flush () override;
+
+	virtual size_t GetPosition () override;
+	virtual void   SetPosition (size_t newPos) override;
+
+	virtual size_t GetSize () override;
+	virtual bool   SetSize (size_t newSize) override;
+
+	virtual bool WriteAt (const void* pData, size_t size, size_t offset) override;
+	virtual bool PunchHole (size_t offset, size_t size) override;
+	virtual bool Preallocate (size_t size) override;
+
+	virtual ~BufferedOStream ();
+
+private:
+	IRandomAccessBinaryOStream* m_pOStream;
+	char*						m_pBuffer;
+	size_t						m_bufferSize;
+	size_t						m_bufferedSize;
+	size_t						m_bufferOffset; // Offset of the buffered data in the underlying stream
+	size_t						m_position;
+
+	bool FlushBuffer ();
+};
+
+} // namespace MMD
+
+#endif // MMD_BUFFEREDOSTREAM
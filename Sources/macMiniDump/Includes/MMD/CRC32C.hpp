@@ -0,0 +1,25 @@
+#ifndef MMD_CRC32C
+#define MMD_CRC32C
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+namespace MMD {
+
+// CRC-32C (Castagnoli), as used by e.g. iSCSI and ext4. Uses the CRC instructions of the CPU (SSE4.2 on x86-64, ARMv8
+//   CRC extension on arm64) if available, falls back to a table-driven implementation otherwise.
+//   crc is the checksum of the preceding data, so checksums can be calculated piece by piece.
+uint32_t CRC32C (const void* pData, size_t size, uint32_t crc = 0);
+
+// Checksum of the concatenation of two pieces of data, from their checksums (and the size of the second one), without
+//   the data itself
+uint32_t CRC32CCombine (uint32_t crc1, uint32_t crc2, uint64_t size2);
+
+// Checksum of the data checksummed by crc, followed by size zero bytes
+uint32_t CRC32CZeroes (uint64_t size, uint32_t crc = 0);
+
+} // namespace MMD
+
+#endif // MMD_CRC32C
@@ -0,0 +1,89 @@
+#ifndef MMD_CHECKSUMOSTREAM
+#define MMD_CHECKSUMOSTREAM
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+
+#include "MMD/IRandomAccessBinaryOStream.hpp"
+
+namespace MMD {
+
+// Decorator calculating the CRC-32C checksum (see CRC32C.hpp) of everything written to another stream. Writes might
+//   come in any order (e.g. after seeking, or from multiple threads): the checksum of every written range is kept, and
+//   adjacent ranges are merged, so the checksum of the whole stream is only assembled on request. Bytes never written
+//   count as zeroes.
+//   Data can't be read back, so the checksum becomes invalid if a byte is written twice, or if written data is cut by
+//   SetSize or PunchHole (SetSize (0) starts over).
+class ChecksumOStream : public IRandomAccessBinaryOStream {
+public:
+	// Constructors
+	ChecksumOStream () = delete;
+	explicit ChecksumOStream (IRandomAccessBinaryOStream* pOStream);
+
+	// Inherited from IRandomAccessBinaryOStream
+	virtual bool Write (const void* pData, size_t size) override;
+	virtual bool WriteV (const iovec* pIOVecs, size_t count) override;
+
+	virtual bool Flush () override;
+
+	virtual size_t GetPosition () override;
+	virtual void   SetPosition (size_t newPos) override;
+
+	virtual size_t GetSize () override;
+	virtual bool   SetSize (size_t newSize) override;
+
+	virtual bool WriteAt (const void* pData, size_t size, size_t offset) override;
+	virtual bool SupportsConcurrentWriteAt () const override;
+	virtual bool PunchHole (size_t offset, size_t size) override;
+	virtual bool Preallocate (size_t size) override;
+
+	virtual ~ChecksumOStream ();
+
+	// Checksum of the first size bytes of the stream. Returns false if the checksum is invalid, or if anything has been
+	//   written beyond size.
+	bool GetCRC32C (size_t size, uint32_t* pCRCOut);
+
+private:
+	struct Regions;
+
+	IRandomAccessBinaryOStream* m_pOStream;
+	std::unique_ptr<Regions>	m_pRegions;
+	std::mutex					m_regionsMutex; // Concurrent positional writes add regions in parallel
+
+	void AddRegion (size_t offset, size_t size, uint32_t crc);
+	void AddRegions (const iovec* pIOVecs, size_t count, size_t offset);
+	void Invalidate ();
+};
+
+// Sequential variant: data is written strictly in order, so a running checksum is enough
+class SequentialChecksumOStream : public ISequentialBinaryOStream {
+public:
+	// Constructors
+	SequentialChecksumOStream () = delete;
+	explicit SequentialChecksumOStream (ISequentialBinaryOStream* pOStream);
+
+	// Inherited from ISequentialBinaryOStream
+	virtual bool Write (const void* pData, size_t size) override;
+	virtual bool WriteV (const iovec* pIOVecs, size_t count) override;
+
+	virtual bool Flush () override;
+
+	virtual ~SequentialChecksumOStream ();
+
+	// Checksum of everything written so far, and its size
+	uint32_t GetCRC32C () const;
+	uint64_t GetSize () const;
+
+private:
+	ISequentialBinaryOStream* m_pOStream;
+	uint32_t				  m_crc;
+	uint64_t				  m_size;
+};
+
+} // namespace MMD
+
+#endif // MMD_CHECKSUMOSTREAM
@@ -0,0 +1,52 @@
+#ifndef MMD_COMPRESSEDFILEREADER
+#define MMD_COMPRESSEDFILEREADER
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+
+namespace MMD {
+
+// Random access to the uncompressed contents of a container written by CompressedOStream. Only the frames covering the
+//   requested range are read and decompressed (and their checksums verified); the last decompressed frame is kept, so
+//   reading a frame piece by piece decompresses it once.
+//   Not thread-safe.
+class CompressedFileReader {
+public:
+	// Constructors
+	CompressedFileReader () = delete;
+	explicit CompressedFileReader (int fd);				  // fd must be opened for reading
+	explicit CompressedFileReader (const char* filePath); // The file at this path must exist
+
+	CompressedFileReader (const CompressedFileReader& rhs)			  = delete;
+	CompressedFileReader& operator= (const CompressedFileReader& rhs) = delete;
+
+	~CompressedFileReader ();
+
+	// The file could be opened, and it is a container with an intact index
+	bool IsValid () const;
+
+	// Size of the uncompressed data
+	uint64_t GetSize () const;
+
+	// Fails if the range is out of bounds, or if a frame covering it is corrupted
+	bool Read (uint64_t offset, size_t size, void* pOut);
+
+	uint64_t GetDecompressedFrameCount () const;
+
+private:
+	struct State;
+
+	int					   m_fd;
+	std::unique_ptr<State> m_pState;
+
+	bool Open ();
+	bool LoadFrame (size_t frameIndex);
+	void Cleanup ();
+};
+
+} // namespace MMD
+
+#endif // MMD_COMPRESSEDFILEREADER
@@ -0,0 +1,67 @@
+#ifndef MMD_COMPRESSEDOSTREAM
+#define MMD_COMPRESSEDOSTREAM
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+
+#include "MMD/ISequentialBinaryOStream.hpp"
+
+namespace MMD {
+
+// Compresses everything written into a self-contained container, written to another stream. The data is cut into
+//   fixed-size frames, which are compressed independently on a pool of worker threads (while the next frames are being
+//   filled), and written out in order. The container ends with an index of the frames, so that CompressedFileReader
+//   can decompress only the frames covering the range it is asked for.
+//   Pass it to the sequential overload of MiniDumpWriteDump, then call Finish.
+class CompressedOStream : public ISequentialBinaryOStream {
+public:
+	static const size_t DefaultFrameSize = 256 * 1'024;
+
+	// Constructors
+	CompressedOStream () = delete;
+	// If no worker thread can be started, frames are compressed on the writing thread
+	explicit CompressedOStream (ISequentialBinaryOStream* pOStream,
+								size_t					  nWorkerThreads = 4,
+								size_t					  frameSize		 = DefaultFrameSize);
+
+	// Inherited from ISequentialBinaryOStream
+	virtual bool Write (const void* pData, size_t size) override;
+
+	// Writes out every full frame (waiting for their compression), then flushes the underlying stream. The frame
+	//   being filled is kept, so frames stay the same size.
+	virtual bool Flush () override;
+
+	virtual ~CompressedOStream ();
+
+	// Writes out the last frame, the index, and the footer; nothing can be written afterwards. Called by the destructor
+	//   if it has not been called, but errors are only reported by calling it.
+	bool Finish ();
+
+	// Bytes written to this stream, and bytes of the container written to the underlying stream so far
+	uint64_t GetUncompressedSize () const;
+	uint64_t GetCompressedSize () const;
+
+private:
+	struct Frame;
+	struct State;
+
+	std::unique_ptr<State> m_pState;
+
+	Frame& GetSlot (uint64_t frameIndex);
+	bool   SubmitFrame ();
+	bool   WriteFrames (uint64_t minFrameCount);
+	bool   WriteFrame (const Frame& frame);
+	bool   WriteToOStream (const void* pData, size_t size);
+
+	static void	 CompressFrame (Frame& frame);
+	static void* WorkerThreadMain (void* pThis);
+	void		 RunWorker ();
+	void		 StopWorkers ();
+};
+
+} // namespace MMD
+
+#endif // MMD_COMPRESSEDOSTREAM
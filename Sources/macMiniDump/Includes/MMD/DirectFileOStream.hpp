@@ -0,0 +1,75 @@
+#ifndef MMD_DIRECTFILEOSTREAM
+#define MMD_DIRECTFILEOSTREAM
+
+#pragma once
+
+#include <cstddef>
+
+#include "MMD/IRandomAccessBinaryOStream.hpp"
+
+namespace MMD {
+
+// File stream bypassing the page cache (O_DIRECT on Linux, F_NOCACHE on macOS), so that writing a large core file does
+//   not evict pages other processes need. Direct I/O requires buffers, offsets, and sizes aligned to blocks, so writes
+//   are staged in an aligned bounce buffer, covering a window of the file. Contiguous writes fill it up and are written
+//   out block by block; a write elsewhere (e.g. the headers written after seeking) flushes it first. Partially written
+//   blocks at the edges are completed with the data already in the file (read-modify-write). The file is padded to a
+//   whole block while writing, and truncated to its real size by Flush and on destruction.
+//   Not suitable for concurrent positional writes, since the buffer is shared. Holes are not supported (they would
+//   have to be whole blocks), so sparse output falls back to writing zeroes.
+class DirectFileOStream : public IRandomAccessBinaryOStream {
+public:
+	static const size_t BlockSize		  = 4'096;
+	static const size_t DefaultBufferSize = 1'024 * 1'024;
+
+	// Constructors
+	DirectFileOStream () = delete;
+	// fd must be opened for reading and writing (partial blocks are read back)
+	explicit DirectFileOStream (int fd, size_t bufferSize = DefaultBufferSize);
+	// The file at this path must exist
+	explicit DirectFileOStream (const char* filePath, size_t bufferSize = DefaultBufferSize);
+
+	// Inherited from IRandomAccessBinaryOStream
+	virtual bool Write (const void* pData, size_t size) override;
+
+	virtual bool Flush () override;
+
+	virtual size_t GetPosition () override;
+	virtual void   SetPosition (size_t newPos) override;
+
+	virtual size_t GetSize () override;
+	virtual bool   SetSize (size_t newSize) override;
+
+	virtual bool WriteAt (const void* pData, size_t size, size_t offset) override;
+	virtual bool Preallocate (size_t size) override;
+
+	virtual ~DirectFileOStream ();
+
+	// Miscellaneous
+	bool IsValid () const;
+	// False if the file system does not support bypassing the cache; the stream still works, through the cache
+	bool IsDirect () const;
+
+private:
+	int	   m_fd;
+	bool   m_direct;
+	char*  m_pBuffer;	   // Aligned to BlockSize, holds the file from m_bufferOffset
+	char*  m_pBlock;		   // Aligned to BlockSize, for reading back partial blocks
+	size_t m_bufferSize;   // Multiple of BlockSize
+	size_t m_bufferOffset; // Multiple of BlockSize
+	size_t m_dirtyBegin;   // The range of the buffer written to, as offsets in the file; empty if the buffer is unused
+	size_t m_dirtyEnd;
+	size_t m_position;
+	size_t m_size;	   // Size of the file, as written (the file itself might be longer, up to a whole block)
+	size_t m_fileSize; // Size of the file on disk
+
+	void Init (size_t bufferSize);
+	bool FlushBuffer ();
+	bool CompleteBlock (size_t blockOffset);
+	bool TruncateToSize ();
+	void Cleanup ();
+};
+
+} // namespace MMD
+
+#endif // MMD_DIRECTFILEOSTREAM
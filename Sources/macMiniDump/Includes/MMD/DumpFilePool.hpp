@@ -0,0 +1,65 @@
+#ifndef MMD_DUMPFILEPOOL
+#define MMD_DUMPFILEPOOL
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+
+#include "MMD/IRandomAccessBinaryOStream.hpp"
+#include "MMD/ISequentialBinaryOStream.hpp"
+
+namespace MMD {
+
+// A fixed set of slot files for core files, created and allocated up front (e.g. at startup), so that writing a core
+//   file at crash time needs no allocation, and no file system metadata operation (no open, no file growth): it cannot
+//   fail for a full disk either. Slots are reused oldest first. Every slot file starts with a header (HeaderSize bytes,
+//   keeping the core file page-aligned) recording the size of the core file in it, and when it was written, so the
+//   core files survive the process, and can be retrieved later (e.g. on the next launch).
+class DumpFilePool {
+public:
+	static const size_t HeaderSize = 4'096;
+
+	// Constructors
+	DumpFilePool () = delete;
+	// Slot files (slot0.mmdslot, slot1.mmdslot, ...) are created in the existing directory, or reused with the core
+	//   files in them. slotSize is the capacity of a slot: larger core files can't be written (see memoryBudget).
+	DumpFilePool (const char* directoryPath, size_t slotCount, size_t slotSize);
+
+	DumpFilePool (const DumpFilePool& rhs)			  = delete;
+	DumpFilePool& operator= (const DumpFilePool& rhs) = delete;
+
+	~DumpFilePool ();
+
+	// Every slot file could be created and allocated
+	bool IsValid () const;
+
+	// Crash time
+	// Hands out the stream of the oldest slot (empty ones first), discarding the core file in it. Its contents are
+	//   only considered valid once CommitSlot succeeds. Only one slot can be acquired at a time.
+	IRandomAccessBinaryOStream* AcquireSlot ();
+	// Records the size of what has been written to the acquired slot in its header, and syncs the slot file
+	bool CommitSlot ();
+
+	// Retrieval
+	size_t GetSlotCount () const;
+	// Returns false if the slot holds no core file. Larger sequence numbers mean more recent core files.
+	bool GetSlotInfo (size_t slotIndex, uint64_t* pSequenceOut, uint64_t* pSizeOut) const;
+	bool CopySlot (size_t slotIndex, ISequentialBinaryOStream* pOStream) const;
+	bool DiscardSlot (size_t slotIndex);
+
+private:
+	class SlotOStream;
+	struct Slot;
+	struct State;
+
+	std::unique_ptr<State> m_pState;
+
+	bool Open (const char* directoryPath, size_t slotCount);
+	bool WriteHeader (const Slot& slot);
+};
+
+} // namespace MMD
+
+#endif // MMD_DUMPFILEPOOL
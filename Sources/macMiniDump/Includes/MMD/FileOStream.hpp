@@ -6,7 +6,7 @@
 #include <cstdio>
 #include <string>
 
-#include "IRandomAccessBinaryOStream.hpp"
+#include "MMD/IRandomAccessBinaryOStream.hpp"
 
 namespace MMD {
 
@@ -20,6 +20,7 @@ public:
 
 	// Inherited from IRandomAccessBinaryOStream
 	virtual bool Write (const void* pData, size_t size) override;
+	virtual bool WriteV (const iovec* pIOVecs, size_t count) override;
 
 	virtual bool Flush () override;
 
@@ -29,6 +30,11 @@ public:
 	virtual size_t GetSize () override;
 	virtual bool   SetSize (size_t newSize) override;
 
+	virtual bool WriteAt (const void* pData, size_t size, size_t offset) override;
+	virtual bool SupportsConcurrentWriteAt () const override;
+	virtual bool PunchHole (size_t offset, size_t size) override;
+	virtual bool Preallocate (size_t size) override;
+
 	virtual ~FileOStream ();
 
 	// Miscellaneous
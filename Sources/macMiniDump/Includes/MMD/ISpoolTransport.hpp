@@ -0,0 +1,29 @@
+#ifndef MMD_ISPOOLTRANSPORT
+#define MMD_ISPOOLTRANSPORT
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+namespace MMD {
+
+// Destination of a spool (see SpoolOStream), used by SpoolUploader (e.g. an HTTP client). Chunks are sent in order,
+//   then the manifest. A chunk may be sent again after a failed (or interrupted) upload, so receiving one has to be
+//   idempotent. Calls return true if the data was acknowledged (i.e. the receiver stored it).
+class ISpoolTransport {
+public:
+	ISpoolTransport ();
+	ISpoolTransport (const ISpoolTransport& rhs)			= delete;
+	ISpoolTransport& operator= (const ISpoolTransport& rhs) = delete;
+
+	// crc32c is the checksum of the chunk, as recorded in the manifest
+	virtual bool SendChunk (uint64_t spoolId, uint64_t chunkIndex, const void* pData, size_t size, uint32_t crc32c) = 0;
+	virtual bool SendManifest (uint64_t spoolId, const void* pData, size_t size)									= 0;
+
+	virtual ~ISpoolTransport ();
+};
+
+} // namespace MMD
+
+#endif // MMD_ISPOOLTRANSPORT
@@ -0,0 +1,39 @@
+#ifndef MMD_LOCALDIRECTORYSPOOLTRANSPORT
+#define MMD_LOCALDIRECTORYSPOOLTRANSPORT
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+
+#include "ISpoolTransport.hpp"
+
+namespace MMD {
+
+// "Uploads" a spool into a local directory (e.g. a mounted network share), with the same layout as the spool, so the
+//   received copy can be read with AssembleSpool. Every file is written atomically, and chunks are checked against
+//   their checksum before being acknowledged.
+class LocalDirectorySpoolTransport : public ISpoolTransport {
+public:
+	// Constructors
+	LocalDirectorySpoolTransport () = delete;
+	// The directory must exist
+	explicit LocalDirectorySpoolTransport (const char* directoryPath);
+
+	// Inherited from ISpoolTransport
+	virtual bool SendChunk (uint64_t spoolId, uint64_t chunkIndex, const void* pData, size_t size, uint32_t crc32c)
+		override;
+	virtual bool SendManifest (uint64_t spoolId, const void* pData, size_t size) override;
+
+	virtual ~LocalDirectorySpoolTransport ();
+
+private:
+	struct State;
+
+	std::unique_ptr<State> m_pState;
+};
+
+} // namespace MMD
+
+#endif // MMD_LOCALDIRECTORYSPOOLTRANSPORT
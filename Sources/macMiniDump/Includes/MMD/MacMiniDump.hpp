@@ -14,7 +14,8 @@
 #include <stdio.h>
 
 #ifdef __cplusplus
-	#include "IRandomAccessBinaryOStream.hpp"
+	#include "MMD/IRandomAccessBinaryOStream.hpp"
+	#include "MMD/ISequentialBinaryOStream.hpp"
 #endif // __cplusplus
 
 #if !defined __x86_64__ && !defined __arm64__
@@ -27,14 +28,88 @@ struct MMDCrashContext {
 	uint64_t crashedTID;
 };
 
+// Statistics about a created core file
+struct MMDStatistics {
+	uint64_t coreFileSize;
+	uint64_t segmentCount;
+	// Bytes of padding (or holes) inserted between segment payloads because of segmentPageAlignment
+	uint64_t segmentAlignmentOverhead;
+	// Bytes of memory not written because of pageDeduplication
+	uint64_t deduplicatedBytes;
+	// Memory ranges (and their total size) left out because of memoryBudget. They are also listed in the core file,
+	//   in the "dropped ranges" LC_NOTE.
+	uint64_t droppedRangeCount;
+	uint64_t droppedBytes;
+	// CRC-32C checksum of the core file, if checksum was set (also stored in the core file, see MMDOptions)
+	uint32_t crc32c;
+};
+
+// Optional settings for core file creation. Zero-initialize (zero means default everywhere), then set fields of
+//   interest.
+struct MMDOptions {
+	// Memory is read and written in chunks of this many bytes (0: default, 4 MiB)
+	uint64_t payloadChunkSize;
+	// If greater than 1, memory is read on a separate thread while previously read chunks are being written; at most
+	//   this many chunks are held in memory at once (0 or 1: no pipelining)
+	uint32_t payloadPipelineDepth;
+	// If greater than 1, memory is written on this many threads in parallel, using positional writes. Only has an
+	//   effect if the stream supports concurrent positional writes (e.g. FileOStream); takes precedence over
+	//   pipelining. (0 or 1: single-threaded)
+	uint32_t writerThreadCount;
+	// If not zero, the file offset of every segment payload has the same offset within a page of this size as the
+	//   address of the segment, so that readers can map segments directly from the core file. 4'096 or 16'384 (the page
+	//   size of the target is a sensible choice), at the cost of some padding (see MMDStatistics).
+	//   (0: payloads are packed back to back)
+	uint32_t segmentPageAlignment;
+	// If not zero, whole pages of zeroes in memory are skipped instead of being written, leaving holes in the core file
+	//   (on file systems supporting sparse files). The contents of the file are the same either way. Only has an effect
+	//   with seekable streams.
+	uint32_t sparseOutput;
+	// If not zero, pages of memory with identical content (e.g. stacks of pooled threads, zero pages) are written only
+	//   once: segments are split, and the pieces refer to the first occurrence of their data in the core file. This
+	//   requires reading memory twice (see MMDStatistics for the savings).
+	uint32_t pageDeduplication;
+	// If not zero, storage for the whole core file is allocated before writing starts (if the stream supports it), so
+	//   running out of space is detected up front, and the file is less fragmented
+	uint32_t preallocate;
+	// If not zero, at most this many bytes of memory are included in the core file. Candidate ranges are ranked (the
+	//   stack of the crashing thread first, then code around its frames, then the topmost pages of other stacks, then
+	//   the rest), and admitted in that order until the budget is exhausted; the ones left out are recorded
+	//   (see MMDStatistics). (0: unlimited)
+	uint64_t memoryBudget;
+	// If not zero, the CRC-32C checksum of the core file is calculated while writing it, and stored at its very end, in
+	//   the payload of the "crc32c digest" LC_NOTE: version (uint32_t), checksum (uint32_t), and the number of bytes
+	//   checksummed (uint64_t), which is everything before the payload (see MMDStatistics)
+	uint32_t checksum;
+	// If not nullptr, filled in with statistics about the core file
+	struct MMDStatistics* pStatistics;
+};
+
 #ifdef __cplusplus
 namespace MMD {
 
 using CrashContext = MMDCrashContext;
+using Options	   = MMDOptions;
+using Statistics   = MMDStatistics;
 
 bool MiniDumpWriteDump (mach_port_t					taskPort,
 						IRandomAccessBinaryOStream* pOStream,
-						MMDCrashContext*			pCrashContext = nullptr);
+						MMDCrashContext*			pCrashContext = nullptr,
+						const MMDOptions*			pOptions	  = nullptr);
+
+// Writes the core file strictly front to back, without seeking (e.g. into a pipe or a socket)
+bool MiniDumpWriteDump (mach_port_t				  taskPort,
+						ISequentialBinaryOStream* pOStream,
+						MMDCrashContext*		  pCrashContext = nullptr,
+						const MMDOptions*		  pOptions		= nullptr);
+
+// Dry run: does everything MiniDumpWriteDump would do with the same options (thread enumeration, stack walking,
+//   layout), except for writing. The statistics (e.g. the size of the core file) are exact for the state of the
+//   process at the time of the call.
+bool MiniDumpEstimateSize (mach_port_t		 taskPort,
+						   MMDStatistics*	 pStatisticsOut,
+						   MMDCrashContext*	 pCrashContext = nullptr,
+						   const MMDOptions* pOptions	   = nullptr);
 
 } // namespace MMD
 #endif // __cplusplus
@@ -0,0 +1,62 @@
+#ifndef MMD_MEMORYOSTREAM
+#define MMD_MEMORYOSTREAM
+
+#pragma once
+
+#include <sys/uio.h>
+
+#include <cstddef>
+#include <memory>
+
+#include "MMD/IRandomAccessBinaryOStream.hpp"
+
+namespace MMD {
+
+// Keeps the written data in memory, in fixed-size chunks allocated from the dedicated heap of the library. Growing
+//   never reallocates or copies already written data. The content can be handed to a sender (e.g. writev, sendmsg)
+//   without copying, see GetIOVecs.
+class MemoryOStream : public IRandomAccessBinaryOStream {
+public:
+	static const size_t DefaultChunkSize = 1'024 * 1'024;
+
+	// Constructors
+	explicit MemoryOStream (size_t chunkSize = DefaultChunkSize);
+
+	// Inherited from IRandomAccessBinaryOStream
+	virtual bool Write (const void* pData, size_t size) override;
+
+	virtual bool Flush () override;
+
+	virtual size_t GetPosition () override;
+	virtual void   SetPosition (size_t newPos) override;
+
+	virtual size_t GetSize () override;
+	virtual bool   SetSize (size_t newSize) override;
+
+	virtual bool WriteAt (const void* pData, size_t size, size_t offset) override;
+	virtual bool Preallocate (size_t size) override;
+
+	virtual ~MemoryOStream ();
+
+	// Zero-copy view of the content: GetIOVecCount () buffers pointing into the chunks, in order, together covering
+	//   GetSize () bytes. Valid until the stream is modified.
+	const iovec* GetIOVecs () const;
+	size_t		 GetIOVecCount () const;
+
+	size_t GetChunkSize () const;
+
+private:
+	struct Chunks;
+
+	std::unique_ptr<Chunks> m_pChunks;
+	size_t					m_chunkSize;
+	size_t					m_size;
+	size_t					m_position;
+
+	bool Reserve (size_t size);
+	void UpdateChunkLengths (size_t oldSize, size_t newSize);
+};
+
+} // namespace MMD
+
+#endif // MMD_MEMORYOSTREAM
@@ -0,0 +1,69 @@
+#ifndef MMD_MMAPOSTREAM
+#define MMD_MMAPOSTREAM
+
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <shared_mutex>
+
+#include "MMD/IRandomAccessBinaryOStream.hpp"
+
+namespace MMD {
+
+// Writes into a shared memory mapping of a file, so that writes are copies into the page cache instead of system calls.
+//   The file is extended to exactly the end of what has been written, and storage for it is allocated (in large steps)
+//   before it is mapped, so a store into the mapping never hits an unallocated page (which would raise SIGBUS when the
+//   disk is full). Writes fail instead if storage can't be allocated.
+//   WriteAt can be called from multiple threads at once, other member functions must not be called concurrently.
+class MmapOStream : public IRandomAccessBinaryOStream {
+public:
+	// Constructors
+	MmapOStream () = delete;
+	explicit MmapOStream (int fd);				 // fd must be opened for reading and writing
+	explicit MmapOStream (const char* filePath); // The file at this path must exist
+
+	// Inherited from IRandomAccessBinaryOStream
+	virtual bool Write (const void* pData, size_t size) override;
+
+	virtual bool Flush () override;
+
+	virtual size_t GetPosition () override;
+	virtual void   SetPosition (size_t newPos) override;
+
+	virtual size_t GetSize () override;
+	virtual bool   SetSize (size_t newSize) override;
+
+	virtual bool WriteAt (const void* pData, size_t size, size_t offset) override;
+	virtual bool SupportsConcurrentWriteAt () const override;
+	virtual bool Preallocate (size_t size) override;
+
+	virtual ~MmapOStream ();
+
+	// Miscellaneous
+	bool IsValid () const;
+
+private:
+	int		 m_fd;
+	uint8_t* m_pMapping;
+	size_t	 m_mappingSize;	 // Might extend past the end of the file, only the part within the file is written
+	size_t	 m_fileSize;	 // Never larger than the size of the stream
+	size_t	 m_reservedSize; // Bytes of the file with storage allocated by us (past its end as well)
+	size_t	 m_writableSize; // Part of the mapping within the file and with storage allocated
+	size_t	 m_position;
+
+	std::atomic<size_t> m_size;
+	std::shared_mutex	m_mappingMutex; // Writers hold it shared, growing the mapping holds it exclusively
+
+	bool Grow (size_t minSize);
+	bool Reserve (size_t minSize);
+	bool Map (size_t minSize);
+	bool Trim ();
+	void Unmap ();
+	void Cleanup ();
+};
+
+} // namespace MMD
+
+#endif // MMD_MMAPOSTREAM
@@ -0,0 +1,36 @@
+#ifndef MMD_PIPEOSTREAM
+#define MMD_PIPEOSTREAM
+
+#pragma once
+
+#include "MMD/ISequentialBinaryOStream.hpp"
+
+namespace MMD {
+
+// Stream for file descriptors that can't seek, such as pipes and sockets (regular files work as well)
+class PipeOStream : public ISequentialBinaryOStream {
+public:
+	// Constructors
+	PipeOStream () = delete;
+	explicit PipeOStream (int fd); // fd must be opened for writing
+
+	// Inherited from ISequentialBinaryOStream
+	virtual bool Write (const void* pData, size_t size) override;
+	virtual bool WriteV (const iovec* pIOVecs, size_t count) override;
+
+	virtual bool Flush () override;
+
+	virtual ~PipeOStream ();
+
+	// Miscellaneous
+	bool IsValid () const;
+
+private:
+	int m_fd;
+
+	void Cleanup ();
+};
+
+} // namespace MMD
+
+#endif // MMD_PIPEOSTREAM
@@ -0,0 +1,79 @@
+#ifndef MMD_RATELIMITEDOSTREAM
+#define MMD_RATELIMITEDOSTREAM
+
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+
+#include "MMD/IRandomAccessBinaryOStream.hpp"
+
+namespace MMD {
+
+// Decorator limiting the write throughput to another stream with a token bucket: on average at most bytesPerSecond
+//   bytes are written per second, with bursts of at most burstSize bytes. Larger writes (e.g. the 4 MiB payload chunks
+//   of the builder) are split into pieces of burstSize bytes, each waiting for its own tokens, so the rate holds within
+//   a single write too. Concurrent positional writes share the bucket.
+//   Optionally, writing is paused whenever a piece takes longer than latencyThresholdMs to write (a sign that the
+//   device is congested), for as long as that piece took.
+class RateLimitedOStream : public IRandomAccessBinaryOStream {
+public:
+	static const size_t DefaultBurstSize = 1'024 * 1'024;
+
+	// Constructors
+	RateLimitedOStream () = delete;
+	// latencyThresholdMs of 0 disables pausing
+	RateLimitedOStream (IRandomAccessBinaryOStream* pOStream,
+						uint64_t					bytesPerSecond,
+						size_t						burstSize		   = DefaultBurstSize,
+						uint32_t					latencyThresholdMs = 0);
+
+	// Inherited from IRandomAccessBinaryOStream
+	virtual bool Write (const void* pData, size_t size) override;
+
+	virtual bool Flush () override;
+
+	virtual size_t GetPosition () override;
+	virtual void   SetPosition (size_t newPos) override;
+
+	virtual size_t GetSize () override;
+	virtual bool   SetSize (size_t newSize) override;
+
+	virtual bool WriteAt (const void* pData, size_t size, size_t offset) override;
+	virtual bool SupportsConcurrentWriteAt () const override;
+	virtual bool PunchHole (size_t offset, size_t size) override;
+	virtual bool Preallocate (size_t size) override;
+
+	virtual ~RateLimitedOStream ();
+
+	// Total time writes have been held back, for tokens or because of pausing (summed over threads writing in parallel)
+	uint64_t GetThrottledNanoseconds () const;
+	// Number of times writing has been paused because of latency
+	uint64_t GetPauseCount () const;
+
+private:
+	using Clock = std::chrono::steady_clock;
+
+	IRandomAccessBinaryOStream* m_pOStream;
+	const double				m_nanosecondsPerByte;
+	const size_t				m_burstSize;
+	const Clock::duration		m_burstDuration; // Time needed to earn burstSize tokens
+	const Clock::duration		m_latencyThreshold;
+
+	std::mutex		  m_mutex;
+	Clock::time_point m_theoreticalArrival; // The bucket is full if this is burstDuration (or more) in the past
+	Clock::time_point m_pausedUntil;
+
+	std::atomic<uint64_t> m_throttledNanoseconds;
+	std::atomic<uint64_t> m_pauseCount;
+
+	void WaitForTokens (size_t size);
+	void CheckLatency (Clock::duration latency);
+};
+
+} // namespace MMD
+
+#endif // MMD_RATELIMITEDOSTREAM
@@ -0,0 +1,53 @@
+#ifndef MMD_SPOOLOSTREAM
+#define MMD_SPOOLOSTREAM
+
+#pragma once
+
+#include <cstddef>
+#include <memory>
+
+#include "MMD/ISequentialBinaryOStream.hpp"
+
+namespace MMD {
+
+// Writes everything into a spool directory: the data is cut into chunk files of a fixed size, each checksummed
+//   (CRC-32C), and Finish writes a manifest listing them. Chunks can then be uploaded (and their upload resumed) one by
+//   one, see SpoolUploader. Pass it to the sequential overload of MiniDumpWriteDump, then call Finish.
+class SpoolOStream : public ISequentialBinaryOStream {
+public:
+	static const size_t DefaultChunkSize = 4 * 1'024 * 1'024;
+
+	// Constructors
+	SpoolOStream () = delete;
+	// The directory must exist, and should be empty
+	explicit SpoolOStream (const char* directoryPath, size_t chunkSize = DefaultChunkSize);
+
+	// Inherited from ISequentialBinaryOStream
+	virtual bool Write (const void* pData, size_t size) override;
+
+	virtual bool Flush () override;
+
+	// Without Finish, the spool is incomplete (it has no manifest)
+	virtual ~SpoolOStream ();
+
+	// Closes the last chunk, and writes the manifest; nothing can be written afterwards
+	bool Finish ();
+
+	bool IsValid () const;
+
+private:
+	struct State;
+
+	std::unique_ptr<State> m_pState;
+
+	bool OpenChunk ();
+	bool CloseChunk ();
+};
+
+// Verifies a complete spool (the manifest, and the checksum of every chunk), and writes the data in it to pOStream.
+//   Works on spools received by LocalDirectorySpoolTransport too.
+bool AssembleSpool (const char* directoryPath, ISequentialBinaryOStream* pOStream);
+
+} // namespace MMD
+
+#endif // MMD_SPOOLOSTREAM
@@ -0,0 +1,48 @@
+#ifndef MMD_SPOOLUPLOADER
+#define MMD_SPOOLUPLOADER
+
+#pragma once
+
+#include <cstdint>
+#include <memory>
+
+#include "ISpoolTransport.hpp"
+
+namespace MMD {
+
+// Sends a complete spool (see SpoolOStream) through a transport: every chunk in order, then the manifest. The
+//   acknowledged chunks are recorded in the spool directory (progress.mmdspool) after every one of them, so an upload
+//   interrupted (by a failed send, or by the process exiting) resumes from the first chunk not acknowledged, even from
+//   another process. Chunks are checked against the manifest before being sent, so a damaged spool is never uploaded.
+class SpoolUploader {
+public:
+	// Constructors
+	SpoolUploader () = delete;
+	SpoolUploader (const char* spoolDirectoryPath, ISpoolTransport* pTransport);
+
+	SpoolUploader (const SpoolUploader& rhs)			= delete;
+	SpoolUploader& operator= (const SpoolUploader& rhs) = delete;
+
+	~SpoolUploader ();
+
+	// Sends what is left of the spool; returns true once everything (the manifest included) is acknowledged. Can be
+	//   called again after a failure.
+	bool Upload ();
+
+	uint64_t GetChunkCount () const;
+	uint64_t GetAcknowledgedChunkCount () const;
+	// Chunks sent (and acknowledged) by this uploader, i.e. not by an upload resumed here
+	uint64_t GetSentChunkCount () const;
+
+private:
+	struct State;
+
+	std::unique_ptr<State> m_pState;
+
+	bool LoadProgress ();
+	bool SaveProgress ();
+};
+
+} // namespace MMD
+
+#endif // MMD_SPOOLUPLOADER
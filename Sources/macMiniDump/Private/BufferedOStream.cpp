@@ -0,0 +1,117 @@
+#include "MMD/BufferedOStream.hpp"
+
+#include <algorithm>
+#include <cassert>
+#include <cstring>
+
+#include "ZoneAllocator.hpp"
+
+namespace MMD {
+
+BufferedOStream::BufferedOStream (IRandomAccessBinaryOStream* pOStream, size_t bufferSize /*= DefaultBufferSize*/):
+	m_pOStream (pOStream),
+	m_pBuffer (static_cast<char*> (Malloc (bufferSize))),
+	m_bufferSize (bufferSize),
+	m_bufferedSize (0),
+	m_bufferOffset (0),
+	m_position (0)
+{
+	assert (m_pOStream != nullptr);
+
+	// Without a buffer, every write goes straight through
+	if (m_pBuffer == nullptr)
+		m_bufferSize = 0;
+}
+
+bool BufferedOStream::Write (const void* pData, size_t size)
+{
+	if (!WriteAt (pData, size, m_position))
+		return false;
+
+	m_position += size;
+
+	return true;
+}
+
+bool BufferedOStream::Flush ()
+{
+	return FlushBuffer () && m_pOStream->Flush ();
+}
+
+size_t BufferedOStream::GetPosition ()
+{
+	return m_position;
+}
+
+void BufferedOStream::SetPosition (size_t newPos)
+{
+	// The buffer is flushed by the next write, if it is not contiguous with the buffered data
+	m_position = newPos;
+}
+
+size_t BufferedOStream::GetSize ()
+{
+	const size_t size = m_pOStream->GetSize ();
+	if (m_bufferedSize == 0)
+		return size;
+
+	return std::max (size, m_bufferOffset + m_bufferedSize);
+}
+
+bool BufferedOStream::SetSize (size_t newSize)
+{
+	return FlushBuffer () && m_pOStream->SetSize (newSize);
+}
+
+bool BufferedOStream::WriteAt (const void* pData, size_t size, size_t offset)
+{
+	if (size >= m_bufferSize) {
+		// Buffered data goes first, so that writes reach the underlying stream in order
+		return FlushBuffer () && m_pOStream->WriteAt (pData, size, offset);
+	}
+
+	const bool contiguous = offset == m_bufferOffset + m_bufferedSize;
+	if (m_bufferedSize > 0 && (!contiguous || m_bufferedSize + size > m_bufferSize)) {
+		if (!FlushBuffer ())
+			return false;
+	}
+
+	if (m_bufferedSize == 0)
+		m_bufferOffset = offset;
+
+	memcpy (m_pBuffer + m_bufferedSize, pData, size);
+	m_bufferedSize += size;
+
+	return true;
+}
+
+bool BufferedOStream::PunchHole (size_t offset, size_t size)
+{
+	return FlushBuffer () && m_pOStream->PunchHole (offset, size);
+}
+
+bool BufferedOStream::Preallocate (size_t size)
+{
+	return m_pOStream->Preallocate (size);
+}
+
+BufferedOStream::~BufferedOStream ()
+{
+	FlushBuffer ();
+
+	if (m_pBuffer != nullptr)
+		Free (m_pBuffer);
+}
+
+bool BufferedOStream::FlushBuffer ()
+{
+	if (m_bufferedSize == 0)
+		return true;
+
+	const size_t bufferedSize = m_bufferedSize;
+	m_bufferedSize			  = 0;
+
+	return m_pOStream->WriteAt (m_pBuffer, bufferedSize, m_bufferOffset);
+}
+
+} // namespace MMD
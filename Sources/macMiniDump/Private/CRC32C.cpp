@@ -0,0 +1,204 @@
+#include "MMD/CRC32C.hpp"
+
+#include <array>
+#include <cstring>
+
+#if defined __x86_64__
+	#include <nmmintrin.h>
+#elif defined __arm64__ && defined __ARM_FEATURE_CRC32
+	#include <arm_acle.h>
+#endif
+
+namespace MMD {
+namespace {
+
+// Bit-reversed Castagnoli polynomial (0x1EDC6F41)
+constexpr uint32_t Polynomial = 0x82F63B78;
+
+// Polynomials over GF(2) are represented the way the CRC register holds them: the highest bit is the coefficient of x^0
+constexpr uint32_t MultModP (uint32_t a, uint32_t b)
+{
+	uint32_t product = 0;
+	for (uint32_t mask = uint32_t (1) << 31; mask != 0; mask >>= 1) {
+		if ((a & mask) != 0)
+			product ^= b;
+
+		b = (b & 1) != 0 ? (b >> 1) ^ Polynomial : b >> 1;
+	}
+
+	return product;
+}
+
+// x^(2^k) mod P for every k
+constexpr std::array<uint32_t, 64> MakeX2NTable ()
+{
+	std::array<uint32_t, 64> table = {};
+
+	uint32_t power = uint32_t (1) << 30; // x^1
+	for (size_t k = 0; k < table.size (); ++k) {
+		table[k] = power;
+		power	 = MultModP (power, power);
+	}
+
+	return table;
+}
+
+constexpr std::array<uint32_t, 64> X2NTable = MakeX2NTable ();
+
+// x^(8 * size) mod P: multiplying the CRC register by this has the same effect as feeding it size zero bytes
+constexpr uint32_t ShiftBytes (uint64_t size)
+{
+	uint32_t result = uint32_t (1) << 31; // x^0
+	for (size_t k = 3; size != 0 && k < X2NTable.size (); size >>= 1, ++k) {
+		if ((size & 1) != 0)
+			result = MultModP (X2NTable[k], result);
+	}
+
+	return result;
+}
+
+// Slicing-by-8 tables: Tables[0] is the classic byte-at-a-time table, Tables[k] advances a byte by k more zero bytes
+constexpr std::array<std::array<uint32_t, 256>, 8> MakeTables ()
+{
+	std::array<std::array<uint32_t, 256>, 8> tables = {};
+
+	for (uint32_t n = 0; n < 256; ++n) {
+		uint32_t crc = n;
+		for (int bit = 0; bit < 8; ++bit)
+			crc = (crc & 1) != 0 ? (crc >> 1) ^ Polynomial : crc >> 1;
+
+		tables[0][n] = crc;
+	}
+
+	for (size_t k = 1; k < tables.size (); ++k) {
+		for (size_t n = 0; n < 256; ++n)
+			tables[k][n] = (tables[k - 1][n] >> 8) ^ tables[0][tables[k - 1][n] & 0xFF];
+	}
+
+	return tables;
+}
+
+constexpr std::array<std::array<uint32_t, 256>, 8> Tables = MakeTables ();
+
+uint64_t Load64 (const uint8_t* pData)
+{
+	uint64_t word;
+	memcpy (&word, pData, sizeof word);
+
+	return word;
+}
+
+// The Update* functions work on the raw CRC register (without the initial and final inversion). All supported CPUs
+//   are little-endian, so 8 bytes can be processed as one word.
+uint32_t UpdateTable (uint32_t reg, const uint8_t* pData, size_t size)
+{
+	for (; size >= sizeof (uint64_t); pData += sizeof (uint64_t), size -= sizeof (uint64_t)) {
+		const uint64_t word = Load64 (pData) ^ reg;
+
+		reg = Tables[7][word & 0xFF] ^ Tables[6][(word >> 8) & 0xFF] ^ Tables[5][(word >> 16) & 0xFF] ^
+			  Tables[4][(word >> 24) & 0xFF] ^ Tables[3][(word >> 32) & 0xFF] ^ Tables[2][(word >> 40) & 0xFF] ^
+			  Tables[1][(word >> 48) & 0xFF] ^ Tables[0][word >> 56];
+	}
+
+	for (; size > 0; ++pData, --size)
+		reg = (reg >> 8) ^ Tables[0][(reg ^ *pData) & 0xFF];
+
+	return reg;
+}
+
+// The CRC instructions have a latency of several cycles, but can start every cycle, so large buffers are split into
+//   three lanes checksummed in an interleaved way. The checksums of the lanes are combined by shifting them over the
+//   lanes following them.
+[[maybe_unused]] constexpr size_t LaneSize = 8'192;
+
+[[maybe_unused]] uint32_t CombineLanes (uint32_t reg0, uint32_t reg1, uint32_t reg2)
+{
+	constexpr uint32_t OneLaneShift	 = ShiftBytes (LaneSize);
+	constexpr uint32_t TwoLanesShift = ShiftBytes (2 * LaneSize);
+
+	return MultModP (TwoLanesShift, reg0) ^ MultModP (OneLaneShift, reg1) ^ reg2;
+}
+
+#if defined __x86_64__
+__attribute__ ((target ("sse4.2"))) uint32_t UpdateSSE42 (uint32_t reg, const uint8_t* pData, size_t size)
+{
+	for (; size >= 3 * LaneSize; pData += 3 * LaneSize, size -= 3 * LaneSize) {
+		uint64_t reg0 = reg;
+		uint64_t reg1 = 0;
+		uint64_t reg2 = 0;
+		for (size_t i = 0; i < LaneSize; i += sizeof (uint64_t)) {
+			reg0 = _mm_crc32_u64 (reg0, Load64 (pData + i));
+			reg1 = _mm_crc32_u64 (reg1, Load64 (pData + LaneSize + i));
+			reg2 = _mm_crc32_u64 (reg2, Load64 (pData + 2 * LaneSize + i));
+		}
+
+		reg = CombineLanes (uint32_t (reg0), uint32_t (reg1), uint32_t (reg2));
+	}
+
+	for (; size >= sizeof (uint64_t); pData += sizeof (uint64_t), size -= sizeof (uint64_t))
+		reg = uint32_t (_mm_crc32_u64 (reg, Load64 (pData)));
+
+	for (; size > 0; ++pData, --size)
+		reg = _mm_crc32_u8 (reg, *pData);
+
+	return reg;
+}
+#elif defined __arm64__ && defined __ARM_FEATURE_CRC32
+uint32_t UpdateARMv8 (uint32_t reg, const uint8_t* pData, size_t size)
+{
+	for (; size >= 3 * LaneSize; pData += 3 * LaneSize, size -= 3 * LaneSize) {
+		uint32_t reg0 = reg;
+		uint32_t reg1 = 0;
+		uint32_t reg2 = 0;
+		for (size_t i = 0; i < LaneSize; i += sizeof (uint64_t)) {
+			reg0 = __crc32cd (reg0, Load64 (pData + i));
+			reg1 = __crc32cd (reg1, Load64 (pData + LaneSize + i));
+			reg2 = __crc32cd (reg2, Load64 (pData + 2 * LaneSize + i));
+		}
+
+		reg = CombineLanes (reg0, reg1, reg2);
+	}
+
+	for (; size >= sizeof (uint64_t); pData += sizeof (uint64_t), size -= sizeof (uint64_t))
+		reg = __crc32cd (reg, Load64 (pData));
+
+	for (; size > 0; ++pData, --size)
+		reg = __crc32cb (reg, *pData);
+
+	return reg;
+}
+#endif
+
+uint32_t Update (uint32_t reg, const uint8_t* pData, size_t size)
+{
+#if defined __x86_64__
+	static const bool hasSSE42 = __builtin_cpu_supports ("sse4.2");
+
+	return hasSSE42 ? UpdateSSE42 (reg, pData, size) : UpdateTable (reg, pData, size);
+#elif defined __arm64__ && defined __ARM_FEATURE_CRC32
+	return UpdateARMv8 (reg, pData, size);
+#else
+	return UpdateTable (reg, pData, size);
+#endif
+}
+
+} // namespace
+
+uint32_t CRC32C (const void* pData, size_t size, uint32_t crc /*= 0*/)
+{
+	return ~Update (~crc, static_cast<const uint8_t*> (pData), size);
+}
+
+uint32_t CRC32CCombine (uint32_t crc1, uint32_t crc2, uint64_t size2)
+{
+	// The initial and final inversions cancel out, so the register of the first piece can simply be shifted over the
+	//   second one
+	return MultModP (ShiftBytes (size2), crc1) ^ crc2;
+}
+
+uint32_t CRC32CZeroes (uint64_t size, uint32_t crc /*= 0*/)
+{
+	return ~MultModP (ShiftBytes (size), ~crc);
+}
+
+} // namespace MMD
@@ -0,0 +1,306 @@
+#include "MMD/ChecksumOStream.hpp"
+
+#include <cassert>
+#include <iterator>
+
+#include "MMD/CRC32C.hpp"
+#include "ZoneAllocator.hpp"
+
+namespace MMD {
+
+// Written ranges of the stream (keyed by their offset) with their checksums. Ranges never overlap, and adjacent ones
+//   are always merged, so sequential writing keeps a single range.
+struct ChecksumOStream::Regions : public ZoneAllocated {
+	struct Region {
+		size_t	 size;
+		uint32_t crc;
+	};
+
+	Map<size_t, Region> regions;
+	bool				valid = true;
+};
+
+ChecksumOStream::ChecksumOStream (IRandomAccessBinaryOStream* pOStream):
+	m_pOStream (pOStream),
+	m_pRegions (new Regions)
+{
+	assert (m_pOStream != nullptr);
+}
+
+bool ChecksumOStream::Write (const void* pData, size_t size)
+{
+	const size_t   offset = m_pOStream->GetPosition ();
+	const uint32_t crc	  = CRC32C (pData, size);
+
+	if (!m_pOStream->Write (pData, size))
+		return false;
+
+	AddRegion (offset, size, crc);
+
+	return true;
+}
+
+bool ChecksumOStream::WriteV (const iovec* pIOVecs, size_t count)
+{
+	const size_t offset = m_pOStream->GetPosition ();
+
+	if (!m_pOStream->WriteV (pIOVecs, count))
+		return false;
+
+	AddRegions (pIOVecs, count, offset);
+
+	return true;
+}
+
+bool ChecksumOStream::Flush ()
+{
+	return m_pOStream->Flush ();
+}
+
+size_t ChecksumOStream::GetPosition ()
+{
+	return m_pOStream->GetPosition ();
+}
+
+void ChecksumOStream::SetPosition (size_t newPos)
+{
+	m_pOStream->SetPosition (newPos);
+}
+
+size_t ChecksumOStream::GetSize ()
+{
+	return m_pOStream->GetSize ();
+}
+
+bool ChecksumOStream::SetSize (size_t newSize)
+{
+	if (!m_pOStream->SetSize (newSize))
+		return false;
+
+	std::lock_guard<std::mutex> lock (m_regionsMutex);
+
+	auto& regions = m_pRegions->regions;
+	if (newSize == 0) {
+		regions.clear ();
+		m_pRegions->valid = true;
+
+		return true;
+	}
+
+	// Ranges beyond the new size are gone (and read back as zeroes if the stream is extended again), but the checksum
+	//   of a range cut in two can't be recalculated
+	auto firstRemoved = regions.lower_bound (newSize);
+	if (firstRemoved != regions.begin ()) {
+		const auto& [offset, region] = *std::prev (firstRemoved);
+		if (offset + region.size > newSize)
+			Invalidate ();
+	}
+
+	if (m_pRegions->valid)
+		regions.erase (firstRemoved, regions.end ());
+
+	return true;
+}
+
+bool ChecksumOStream::WriteAt (const void* pData, size_t size, size_t offset)
+{
+	// The checksum is calculated without holding the lock, so concurrent writers only serialize on bookkeeping
+	const uint32_t crc = CRC32C (pData, size);
+
+	if (!m_pOStream->WriteAt (pData, size, offset))
+		return false;
+
+	AddRegion (offset, size, crc);
+
+	return true;
+}
+
+bool ChecksumOStream::SupportsConcurrentWriteAt () const
+{
+	return m_pOStream->SupportsConcurrentWriteAt ();
+}
+
+bool ChecksumOStream::PunchHole (size_t offset, size_t size)
+{
+	if (!m_pOStream->PunchHole (offset, size))
+		return false;
+
+	std::lock_guard<std::mutex> lock (m_regionsMutex);
+
+	// Holes in ranges never written don't change anything, as those count as zeroes anyway
+	const auto& regions = m_pRegions->regions;
+	const auto	next	= regions.lower_bound (offset);
+
+	bool overlaps = next != regions.end () && next->first < offset + size;
+	if (next != regions.begin ()) {
+		const auto& [prevOffset, prevRegion] = *std::prev (next);
+		overlaps |= prevOffset + prevRegion.size > offset;
+	}
+
+	if (overlaps)
+		Invalidate ();
+
+	return true;
+}
+
+bool ChecksumOStream::Preallocate (size_t size)
+{
+	return m_pOStream->Preallocate (size);
+}
+
+ChecksumOStream::~ChecksumOStream () = default;
+
+bool ChecksumOStream::GetCRC32C (size_t size, uint32_t* pCRCOut)
+{
+	std::lock_guard<std::mutex> lock (m_regionsMutex);
+
+	if (!m_pRegions->valid)
+		return false;
+
+	uint32_t crc	  = 0;
+	size_t	 position = 0;
+	for (const auto& [offset, region] : m_pRegions->regions) {
+		if (offset + region.size > size)
+			return false;
+
+		if (offset > position)
+			crc = CRC32CZeroes (offset - position, crc);
+
+		crc		 = CRC32CCombine (crc, region.crc, region.size);
+		position = offset + region.size;
+	}
+
+	if (size > position)
+		crc = CRC32CZeroes (size - position, crc);
+
+	*pCRCOut = crc;
+
+	return true;
+}
+
+// Records a written range. Failing to do so (running out of memory) invalidates the checksum, the write itself has
+//   succeeded already, so it's not an error.
+void ChecksumOStream::AddRegion (size_t offset, size_t size, uint32_t crc)
+{
+	if (size == 0)
+		return;
+
+	std::lock_guard<std::mutex> lock (m_regionsMutex);
+
+	if (!m_pRegions->valid)
+		return;
+
+	auto&		 regions = m_pRegions->regions;
+	const size_t end	 = offset + size;
+
+	auto next = regions.lower_bound (offset);
+	if (next != regions.end () && next->first < end) {
+		Invalidate (); // Overwritten data
+
+		return;
+	}
+
+	auto merged = regions.end ();
+	if (next != regions.begin ()) {
+		auto		 prev	 = std::prev (next);
+		const size_t prevEnd = prev->first + prev->second.size;
+		if (prevEnd > offset) {
+			Invalidate (); // Overwritten data
+
+			return;
+		}
+
+		if (prevEnd == offset) {
+			prev->second.crc = CRC32CCombine (prev->second.crc, crc, size);
+			prev->second.size += size;
+			merged = prev;
+		}
+	}
+
+	if (merged == regions.end ()) {
+		try {
+			merged = regions.emplace_hint (next, offset, Regions::Region { size, crc });
+		} catch (const std::bad_alloc&) {
+			Invalidate ();
+
+			return;
+		}
+	}
+
+	if (next != regions.end () && next->first == end) {
+		merged->second.crc = CRC32CCombine (merged->second.crc, next->second.crc, next->second.size);
+		merged->second.size += next->second.size;
+		regions.erase (next);
+	}
+}
+
+void ChecksumOStream::AddRegions (const iovec* pIOVecs, size_t count, size_t offset)
+{
+	// The buffers are contiguous in the stream, so they make up a single range
+	uint32_t crc  = 0;
+	size_t	 size = 0;
+	for (size_t i = 0; i < count; ++i) {
+		crc = CRC32C (pIOVecs[i].iov_base, pIOVecs[i].iov_len, crc);
+		size += pIOVecs[i].iov_len;
+	}
+
+	AddRegion (offset, size, crc);
+}
+
+// Must be called with m_regionsMutex held
+void ChecksumOStream::Invalidate ()
+{
+	m_pRegions->regions.clear ();
+	m_pRegions->valid = false;
+}
+
+SequentialChecksumOStream::SequentialChecksumOStream (ISequentialBinaryOStream* pOStream):
+	m_pOStream (pOStream),
+	m_crc (0),
+	m_size (0)
+{
+	assert (m_pOStream != nullptr);
+}
+
+bool SequentialChecksumOStream::Write (const void* pData, size_t size)
+{
+	if (!m_pOStream->Write (pData, size))
+		return false;
+
+	m_crc = CRC32C (pData, size, m_crc);
+	m_size += size;
+
+	return true;
+}
+
+bool SequentialChecksumOStream::WriteV (const iovec* pIOVecs, size_t count)
+{
+	if (!m_pOStream->WriteV (pIOVecs, count))
+		return false;
+
+	for (size_t i = 0; i < count; ++i) {
+		m_crc = CRC32C (pIOVecs[i].iov_base, pIOVecs[i].iov_len, m_crc);
+		m_size += pIOVecs[i].iov_len;
+	}
+
+	return true;
+}
+
+bool SequentialChecksumOStream::Flush ()
+{
+	return m_pOStream->Flush ();
+}
+
+SequentialChecksumOStream::~SequentialChecksumOStream () = default;
+
+uint32_t SequentialChecksumOStream::GetCRC32C () const
+{
+	return m_crc;
+}
+
+uint64_t SequentialChecksumOStream::GetSize () const
+{
+	return m_size;
+}
+
+} // namespace MMD
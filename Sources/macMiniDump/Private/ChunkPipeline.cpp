@@ -0,0 +1,136 @@
+#include "ChunkPipeline.hpp"
+
+#include <cassert>
+
+#include "Defer.hpp"
+
+namespace MMD {
+
+ChunkPipeline::ChunkPipeline (Vector<IDataProvider*> sources, size_t chunkSize, size_t depth):
+	m_sources (std::move (sources)),
+	m_chunkSize (chunkSize),
+	m_depth (depth),
+	m_slots (depth),
+	m_nProduced (0),
+	m_nConsumed (0),
+	m_producerDone (false),
+	m_stopRequested (false),
+	m_producerThread (),
+	m_started (false)
+{
+	assert (chunkSize > 0);
+	assert (depth > 0);
+
+	// Buffers are allocated upfront, and reused for the whole lifetime of the pipeline
+	m_buffers.reserve (depth);
+	for (size_t i = 0; i < depth; ++i)
+		m_buffers.push_back (MakeUniqueArray<char> (chunkSize));
+}
+
+ChunkPipeline::~ChunkPipeline ()
+{
+	if (!m_started)
+		return;
+
+	{
+		std::lock_guard<std::mutex> lock (m_mutex);
+		m_stopRequested = true;
+	}
+	m_cv.notify_all ();
+
+	pthread_join (m_producerThread, nullptr);
+}
+
+bool ChunkPipeline::Start ()
+{
+	assert (!m_started);
+
+	m_started = pthread_create (&m_producerThread, nullptr, &ProducerThreadMain, this) == 0;
+
+	return m_started;
+}
+
+const ChunkPipeline::Chunk* ChunkPipeline::Next ()
+{
+	assert (m_started);
+
+	std::unique_lock<std::mutex> lock (m_mutex);
+	m_cv.wait (lock, [this] () {
+		return m_nConsumed < m_nProduced || m_producerDone;
+	});
+
+	if (m_nConsumed == m_nProduced)
+		return nullptr;
+
+	return &m_slots[m_nConsumed % m_depth];
+}
+
+void ChunkPipeline::Release ()
+{
+	{
+		std::lock_guard<std::mutex> lock (m_mutex);
+		assert (m_nConsumed < m_nProduced);
+
+		++m_nConsumed;
+	}
+
+	m_cv.notify_all ();
+}
+
+void* ChunkPipeline::ProducerThreadMain (void* pThis)
+{
+	static_cast<ChunkPipeline*> (pThis)->Produce ();
+
+	return nullptr;
+}
+
+void ChunkPipeline::Produce ()
+{
+	defer {
+		{
+			std::lock_guard<std::mutex> lock (m_mutex);
+			m_producerDone = true;
+		}
+		m_cv.notify_all ();
+	};
+
+	for (size_t i = 0; i < m_sources.size (); ++i) {
+		IDataProvider* pSource	= m_sources[i];
+		const size_t   dataSize = pSource->GetSize ();
+
+		for (size_t offset = 0; offset < dataSize; offset += m_chunkSize) {
+			size_t slotIndex;
+			{
+				// Wait for a free slot (i.e. the consumer is done with the chunk that was read into it previously)
+				std::unique_lock<std::mutex> lock (m_mutex);
+				m_cv.wait (lock, [this] () {
+					return m_nProduced - m_nConsumed < m_depth || m_stopRequested;
+				});
+
+				if (m_stopRequested)
+					return;
+
+				slotIndex = m_nProduced % m_depth;
+			}
+
+			// The slot is exclusively ours until it's published
+			Chunk& chunk	  = m_slots[slotIndex];
+			chunk.sourceIndex = i;
+			chunk.offset	  = offset;
+			chunk.size		  = std::min (dataSize - offset, m_chunkSize);
+			chunk.pData		  = m_buffers[slotIndex].get ();
+
+			IDataPtr* pDataPtr = pSource->GetDataPtr ();
+
+			chunk.valid = pDataPtr != nullptr && pDataPtr->CopyTo (offset, chunk.size, m_buffers[slotIndex].get ());
+
+			{
+				std::lock_guard<std::mutex> lock (m_mutex);
+				++m_nProduced;
+			}
+			m_cv.notify_all ();
+		}
+	}
+}
+
+} // namespace MMD
@@ -0,0 +1,68 @@
+#ifndef MMD_CHUNKPIPELINE
+#define MMD_CHUNKPIPELINE
+
+#pragma once
+
+#include <pthread.h>
+
+#include <condition_variable>
+#include <cstddef>
+#include <mutex>
+
+#include "DataAccess.hpp"
+#include "ZoneAllocator.hpp"
+
+namespace MMD {
+
+// Reads the data of a list of data providers in fixed-size chunks on a separate (producer) thread, into a bounded set
+//   of reusable buffers. This way reading can overlap with whatever the consumer does with previously read chunks
+//   (e.g. writing them out). Chunks are handed out in order: sources one after another, offsets increasing.
+class ChunkPipeline {
+public:
+	struct Chunk {
+		size_t		sourceIndex;
+		size_t		offset; // Offset inside the data of the source
+		size_t		size;
+		bool		valid; // False if the data could not be read
+		const char* pData;
+	};
+
+	ChunkPipeline (Vector<IDataProvider*> sources, size_t chunkSize, size_t depth);
+	ChunkPipeline (const ChunkPipeline&)			= delete;
+	ChunkPipeline& operator= (const ChunkPipeline&) = delete;
+
+	~ChunkPipeline ();
+
+	// Launches the producer thread
+	bool Start ();
+
+	// Returns the next chunk, or nullptr if there are no more chunks; blocks until the chunk is read. The chunk stays
+	//   valid until Release is called, which must happen before calling Next again.
+	const Chunk* Next ();
+	void		 Release ();
+
+private:
+	static void* ProducerThreadMain (void* pThis);
+	void		 Produce ();
+
+	Vector<IDataProvider*> m_sources;
+	size_t				   m_chunkSize;
+	size_t				   m_depth;
+
+	Vector<UniquePtr<char[]>> m_buffers;
+	Vector<Chunk>			  m_slots; // Ring buffer of chunks; slot i always uses buffer i
+
+	std::mutex				m_mutex;
+	std::condition_variable m_cv;
+	size_t					m_nProduced;
+	size_t					m_nConsumed;
+	bool					m_producerDone;
+	bool					m_stopRequested;
+
+	pthread_t m_producerThread;
+	bool	  m_started;
+};
+
+} // namespace MMD
+
+#endif // MMD_CHUNKPIPELINE
@@ -0,0 +1,46 @@
+#ifndef MMD_COMPRESSEDCONTAINER
+#define MMD_COMPRESSEDCONTAINER
+
+#pragma once
+
+#include <cstdint>
+
+namespace MMD {
+namespace CompressedContainer {
+
+// Layout of the container written by CompressedOStream:
+//   [Header][frame 0][frame 1]...[frame N-1][FrameIndexEntry 0]...[FrameIndexEntry N-1][Footer]
+// The data is cut into frames of frameSize bytes (only the last one might be shorter), which are compressed
+//   independently (see LZCodec.hpp), so any of them can be decompressed on its own. Frames that would not get smaller
+//   are stored as they are. Readers start at the footer, which has a fixed size, to find the index.
+
+constexpr uint32_t Magic   = 0x5A444D4D; // "MMDZ"
+constexpr uint32_t Version = 1;
+
+struct Header {
+	uint32_t magic	   = Magic;
+	uint32_t version   = Version;
+	uint32_t frameSize = 0;
+	uint32_t reserved  = 0;
+};
+
+struct FrameIndexEntry {
+	uint64_t offset			  = 0; // Offset of the frame in the container
+	uint32_t compressedSize	  = 0; // Equal to uncompressedSize if the frame is stored uncompressed
+	uint32_t uncompressedSize = 0;
+	uint32_t crc32c			  = 0; // Checksum of the uncompressed data
+	uint32_t reserved		  = 0;
+};
+
+struct Footer {
+	uint64_t indexOffset	  = 0;
+	uint64_t frameCount		  = 0;
+	uint64_t uncompressedSize = 0;
+	uint32_t indexCRC32C	  = 0; // Checksum of the index entries
+	uint32_t magic			  = Magic;
+};
+
+} // namespace CompressedContainer
+} // namespace MMD
+
+#endif // MMD_COMPRESSEDCONTAINER
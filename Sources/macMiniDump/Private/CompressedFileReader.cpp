@@ -0,0 +1,188 @@
+#include "MMD/CompressedFileReader.hpp"
+
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <cstring>
+
+#include "CompressedContainer.hpp"
+#include "LZCodec.hpp"
+#include "MMD/CRC32C.hpp"
+#include "MMD/FileDescriptorIO.hpp"
+#include "ZoneAllocator.hpp"
+
+namespace MMD {
+
+struct CompressedFileReader::State : public ZoneAllocated {
+	CompressedContainer::Header					 header;
+	CompressedContainer::Footer					 footer;
+	Vector<CompressedContainer::FrameIndexEntry> index;
+
+	UniquePtr<char[]> pFrame;
+	UniquePtr<char[]> pCompressedFrame;
+	size_t			  cachedFrame = SIZE_MAX; // Index of the frame in pFrame
+
+	uint64_t nDecompressedFrames = 0;
+	bool	 valid				 = false;
+};
+
+CompressedFileReader::CompressedFileReader (int fd): m_fd (fd), m_pState (new State)
+{
+	m_pState->valid = Open ();
+}
+
+CompressedFileReader::CompressedFileReader (const char* filePath): m_pState (new State)
+{
+	m_fd			= open (filePath, O_RDONLY);
+	m_pState->valid = Open ();
+}
+
+CompressedFileReader::~CompressedFileReader ()
+{
+	Cleanup ();
+}
+
+bool CompressedFileReader::IsValid () const
+{
+	return m_pState->valid;
+}
+
+uint64_t CompressedFileReader::GetSize () const
+{
+	return m_pState->footer.uncompressedSize;
+}
+
+bool CompressedFileReader::Read (uint64_t offset, size_t size, void* pOut)
+{
+	State& state = *m_pState;
+	if (!state.valid || offset > state.footer.uncompressedSize || size > state.footer.uncompressedSize - offset)
+		return false;
+
+	char* pCurr = static_cast<char*> (pOut);
+	while (size > 0) {
+		const size_t frameIndex = offset / state.header.frameSize;
+		if (!LoadFrame (frameIndex))
+			return false;
+
+		const size_t offsetInFrame = offset % state.header.frameSize;
+		const size_t toCopy		   = std::min<size_t> (size, state.index[frameIndex].uncompressedSize - offsetInFrame);
+		memcpy (pCurr, state.pFrame.get () + offsetInFrame, toCopy);
+
+		pCurr += toCopy;
+		offset += toCopy;
+		size -= toCopy;
+	}
+
+	return true;
+}
+
+uint64_t CompressedFileReader::GetDecompressedFrameCount () const
+{
+	return m_pState->nDecompressedFrames;
+}
+
+// Everything read from the file is validated here, so that Read can rely on it: every frame but the last one is full,
+//   and the frames are within the file, before the index
+bool CompressedFileReader::Open ()
+{
+	State& state = *m_pState;
+
+	struct stat fileInfo;
+	if (m_fd == -1 || fstat (m_fd, &fileInfo) != 0)
+		return false;
+
+	const uint64_t fileSize = fileInfo.st_size;
+	if (fileSize < sizeof (CompressedContainer::Header) + sizeof (CompressedContainer::Footer))
+		return false;
+
+	if (!PReadAll (m_fd, &state.header, sizeof state.header, 0) ||
+		!PReadAll (m_fd, &state.footer, sizeof state.footer, fileSize - sizeof state.footer))
+		return false;
+
+	const CompressedContainer::Header& header = state.header;
+	const CompressedContainer::Footer& footer = state.footer;
+	if (header.magic != CompressedContainer::Magic || header.version != CompressedContainer::Version ||
+		header.frameSize == 0 || footer.magic != CompressedContainer::Magic)
+		return false;
+
+	const uint64_t indexEnd = fileSize - sizeof footer;
+	if (footer.indexOffset < sizeof header || footer.indexOffset > indexEnd)
+		return false;
+
+	const uint64_t indexSize		  = indexEnd - footer.indexOffset;
+	const uint64_t expectedFrameCount = footer.uncompressedSize / header.frameSize +
+										(footer.uncompressedSize % header.frameSize != 0 ? 1 : 0);
+	if (indexSize % sizeof (CompressedContainer::FrameIndexEntry) != 0 ||
+		indexSize / sizeof (CompressedContainer::FrameIndexEntry) != footer.frameCount ||
+		footer.frameCount != expectedFrameCount)
+		return false;
+
+	try {
+		state.index.resize (footer.frameCount);
+		state.pFrame		   = MakeUniqueArray<char> (header.frameSize);
+		state.pCompressedFrame = MakeUniqueArray<char> (header.frameSize);
+	} catch (const std::bad_alloc&) {
+		return false;
+	}
+
+	if (!PReadAll (m_fd, state.index.data (), indexSize, footer.indexOffset) ||
+		CRC32C (state.index.data (), indexSize) != footer.indexCRC32C)
+		return false;
+
+	for (size_t i = 0; i < state.index.size (); ++i) {
+		const CompressedContainer::FrameIndexEntry& entry = state.index[i];
+
+		const uint64_t remainingSize = footer.uncompressedSize - i * header.frameSize;
+		const uint64_t expectedSize	 = std::min<uint64_t> (header.frameSize, remainingSize);
+		if (entry.uncompressedSize != expectedSize || entry.compressedSize > entry.uncompressedSize ||
+			entry.offset > footer.indexOffset || entry.compressedSize > footer.indexOffset - entry.offset)
+			return false;
+	}
+
+	return true;
+}
+
+bool CompressedFileReader::LoadFrame (size_t frameIndex)
+{
+	State& state = *m_pState;
+	if (state.cachedFrame == frameIndex)
+		return true;
+
+	state.cachedFrame = SIZE_MAX;
+
+	const CompressedContainer::FrameIndexEntry& entry = state.index[frameIndex];
+
+	// Stored frames are read right into place
+	char* const pFrame = state.pFrame.get ();
+	if (entry.compressedSize == entry.uncompressedSize) {
+		if (!PReadAll (m_fd, pFrame, entry.compressedSize, entry.offset))
+			return false;
+	} else {
+		char* const pCompressedFrame = state.pCompressedFrame.get ();
+		if (!PReadAll (m_fd, pCompressedFrame, entry.compressedSize, entry.offset) ||
+			!LZDecompress (pCompressedFrame, entry.compressedSize, pFrame, entry.uncompressedSize))
+			return false;
+	}
+
+	++state.nDecompressedFrames;
+
+	if (CRC32C (pFrame, entry.uncompressedSize) != entry.crc32c)
+		return false;
+
+	state.cachedFrame = frameIndex;
+
+	return true;
+}
+
+void CompressedFileReader::Cleanup ()
+{
+	if (m_fd == -1)
+		return;
+
+	close (m_fd);
+	m_fd = -1;
+}
+
+} // namespace MMD
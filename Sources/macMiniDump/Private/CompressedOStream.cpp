@@ -0,0 +1,335 @@
+#include "MMD/CompressedOStream.hpp"
+
+#include <pthread.h>
+
+#include <algorithm>
+#include <cassert>
+#include <condition_variable>
+#include <cstring>
+#include <mutex>
+
+#include "CompressedContainer.hpp"
+#include "LZCodec.hpp"
+#include "Logging.hpp"
+#include "MMD/CRC32C.hpp"
+#include "ZoneAllocator.hpp"
+
+namespace MMD {
+
+struct CompressedOStream::Frame {
+	UniquePtr<char[]> pData;
+	UniquePtr<char[]> pCompressedData;
+	size_t			  size			 = 0;
+	size_t			  compressedSize = 0; // Equal to size if the frame is stored uncompressed
+	uint32_t		  crc32c		 = 0;
+	bool			  compressed	 = false;
+};
+
+// Frames live in a ring of slots: frame i uses slot i % slots.size (). Frames are numbered in the order they are
+//   filled (submitted), and are compressed (taken by workers) and written out in this order, too. Every frame
+//   in [nWritten, nSubmitted) is either waiting for or being compressed, or waiting to be written.
+struct CompressedOStream::State : public ZoneAllocated {
+	ISequentialBinaryOStream* pOStream;
+	size_t					  frameSize;
+
+	Vector<Frame>								 slots;
+	Vector<CompressedContainer::FrameIndexEntry> index;
+
+	uint64_t nSubmitted = 0;
+	uint64_t nTaken		= 0;
+	uint64_t nWritten	= 0;
+	size_t	 fillSize	= 0; // Bytes in the frame being filled (the one in the slot of frame nSubmitted)
+
+	Vector<pthread_t>		workers;
+	std::mutex				mutex; // Guards nSubmitted, nTaken, stopRequested, and the compressed flags of frames
+	std::condition_variable cv;
+	bool					stopRequested = false;
+
+	uint64_t uncompressedSize = 0;
+	uint64_t compressedSize	  = 0;
+	bool	 failed			  = false;
+	bool	 finished		  = false;
+};
+
+CompressedOStream::CompressedOStream (ISequentialBinaryOStream* pOStream,
+									  size_t					nWorkerThreads /*= 4*/,
+									  size_t					frameSize /*= DefaultFrameSize*/):
+	m_pState (new State)
+{
+	assert (pOStream != nullptr);
+	assert (frameSize > 0 && frameSize <= UINT32_MAX);
+
+	m_pState->pOStream	= pOStream;
+	m_pState->frameSize = frameSize;
+	// While every worker compresses a frame, the next ones can be filled, and the compressed ones written
+	m_pState->slots.resize (2 * std::max<size_t> (nWorkerThreads, 1));
+
+	for (size_t i = 0; i < nWorkerThreads; ++i) {
+		pthread_t thread;
+		if (pthread_create (&thread, nullptr, &WorkerThreadMain, this) != 0) {
+			MMD_DEBUGLOG_LINE << "Failed to start compression worker thread #" << i;
+
+			break;
+		}
+
+		m_pState->workers.push_back (thread);
+	}
+}
+
+bool CompressedOStream::Write (const void* pData, size_t size)
+{
+	State& state = *m_pState;
+	if (state.failed || state.finished)
+		return false;
+
+	const char* pCurr = static_cast<const char*> (pData);
+	while (size > 0) {
+		Frame& frame = GetSlot (state.nSubmitted);
+		if (frame.pData == nullptr) {
+			try {
+				frame.pData			  = MakeUniqueArray<char> (state.frameSize);
+				frame.pCompressedData = MakeUniqueArray<char> (state.frameSize);
+			} catch (const std::bad_alloc&) {
+				state.failed = true;
+
+				return false;
+			}
+		}
+
+		const size_t toCopy = std::min (size, state.frameSize - state.fillSize);
+		memcpy (frame.pData.get () + state.fillSize, pCurr, toCopy);
+
+		pCurr += toCopy;
+		size -= toCopy;
+		state.fillSize += toCopy;
+		state.uncompressedSize += toCopy;
+
+		if (state.fillSize == state.frameSize && !SubmitFrame ())
+			return false;
+	}
+
+	return true;
+}
+
+bool CompressedOStream::Flush ()
+{
+	State& state = *m_pState;
+	if (state.failed)
+		return false;
+
+	return WriteFrames (state.nSubmitted) && state.pOStream->Flush ();
+}
+
+CompressedOStream::~CompressedOStream ()
+{
+	if (!m_pState->finished)
+		Finish ();
+
+	StopWorkers ();
+}
+
+bool CompressedOStream::Finish ()
+{
+	State& state = *m_pState;
+	if (state.finished)
+		return !state.failed;
+
+	state.finished = true;
+
+	const bool lastFrameSubmitted = !state.failed && (state.fillSize == 0 || SubmitFrame ());
+	const bool framesWritten	  = lastFrameSubmitted && WriteFrames (state.nSubmitted);
+	StopWorkers ();
+
+	if (!framesWritten)
+		return false;
+
+	const size_t indexSize = state.index.size () * sizeof (CompressedContainer::FrameIndexEntry);
+	if (!WriteToOStream (state.index.data (), indexSize)) {
+		state.failed = true;
+
+		return false;
+	}
+
+	CompressedContainer::Footer footer;
+	footer.indexOffset		= state.compressedSize - indexSize;
+	footer.frameCount		= state.index.size ();
+	footer.uncompressedSize = state.uncompressedSize;
+	footer.indexCRC32C		= CRC32C (state.index.data (), indexSize);
+
+	if (!WriteToOStream (&footer, sizeof footer) || !state.pOStream->Flush ()) {
+		state.failed = true;
+
+		return false;
+	}
+
+	return true;
+}
+
+uint64_t CompressedOStream::GetUncompressedSize () const
+{
+	return m_pState->uncompressedSize;
+}
+
+uint64_t CompressedOStream::GetCompressedSize () const
+{
+	return m_pState->compressedSize;
+}
+
+CompressedOStream::Frame& CompressedOStream::GetSlot (uint64_t frameIndex)
+{
+	return m_pState->slots[frameIndex % m_pState->slots.size ()];
+}
+
+// Hands the frame being filled over to the workers (or compresses it right away, if there are none), then makes sure
+//   that the slot of the next frame is free
+bool CompressedOStream::SubmitFrame ()
+{
+	State& state = *m_pState;
+	Frame& frame = GetSlot (state.nSubmitted);
+	frame.size	 = state.fillSize;
+
+	state.fillSize = 0;
+
+	if (state.workers.empty ()) {
+		CompressFrame (frame);
+
+		frame.compressed = true;
+		++state.nSubmitted;
+	} else {
+		std::lock_guard<std::mutex> lock (state.mutex);
+
+		frame.compressed = false;
+		++state.nSubmitted;
+		state.cv.notify_all ();
+	}
+
+	const uint64_t nSlots = state.slots.size ();
+
+	return WriteFrames (state.nSubmitted >= nSlots ? state.nSubmitted - nSlots + 1 : 0);
+}
+
+// Writes out compressed frames in order: waits for the compression of the ones before minFrameCount, the ones after
+//   it are only written if they happen to be compressed already
+bool CompressedOStream::WriteFrames (uint64_t minFrameCount)
+{
+	State& state = *m_pState;
+	while (state.nWritten < state.nSubmitted) {
+		const Frame& frame = GetSlot (state.nWritten);
+		{
+			std::unique_lock<std::mutex> lock (state.mutex);
+			if (!frame.compressed && state.nWritten >= minFrameCount)
+				return true;
+
+			state.cv.wait (lock, [&frame] { return frame.compressed; });
+		}
+
+		if (!WriteFrame (frame)) {
+			state.failed = true;
+
+			return false;
+		}
+
+		++state.nWritten;
+	}
+
+	return true;
+}
+
+bool CompressedOStream::WriteFrame (const Frame& frame)
+{
+	State& state = *m_pState;
+
+	CompressedContainer::FrameIndexEntry entry;
+	entry.offset		   = std::max<uint64_t> (state.compressedSize, sizeof (CompressedContainer::Header));
+	entry.compressedSize   = uint32_t (frame.compressedSize);
+	entry.uncompressedSize = uint32_t (frame.size);
+	entry.crc32c		   = frame.crc32c;
+
+	try {
+		state.index.push_back (entry);
+	} catch (const std::bad_alloc&) {
+		return false;
+	}
+
+	const bool stored = frame.compressedSize == frame.size;
+
+	return WriteToOStream (stored ? frame.pData.get () : frame.pCompressedData.get (), frame.compressedSize);
+}
+
+// The header goes first, before anything else is written
+bool CompressedOStream::WriteToOStream (const void* pData, size_t size)
+{
+	State& state = *m_pState;
+	if (state.compressedSize == 0) {
+		CompressedContainer::Header header;
+		header.frameSize = uint32_t (state.frameSize);
+
+		if (!state.pOStream->Write (header))
+			return false;
+
+		state.compressedSize += sizeof header;
+	}
+
+	if (!state.pOStream->Write (pData, size))
+		return false;
+
+	state.compressedSize += size;
+
+	return true;
+}
+
+// Frames that would not get smaller are stored as they are
+void CompressedOStream::CompressFrame (Frame& frame)
+{
+	const char* pData = frame.pData.get ();
+	frame.crc32c	  = CRC32C (pData, frame.size);
+
+	const size_t compressedSize = LZCompress (pData, frame.size, frame.pCompressedData.get (), frame.size - 1);
+	frame.compressedSize		= compressedSize == 0 ? frame.size : compressedSize;
+}
+
+void* CompressedOStream::WorkerThreadMain (void* pThis)
+{
+	static_cast<CompressedOStream*> (pThis)->RunWorker ();
+
+	return nullptr;
+}
+
+void CompressedOStream::RunWorker ()
+{
+	State& state = *m_pState;
+
+	std::unique_lock<std::mutex> lock (state.mutex);
+	while (true) {
+		state.cv.wait (lock, [&state] { return state.stopRequested || state.nTaken < state.nSubmitted; });
+		if (state.stopRequested)
+			return;
+
+		Frame& frame = GetSlot (state.nTaken++);
+
+		lock.unlock ();
+		CompressFrame (frame);
+		lock.lock ();
+
+		frame.compressed = true;
+		state.cv.notify_all ();
+	}
+}
+
+void CompressedOStream::StopWorkers ()
+{
+	State& state = *m_pState;
+	{
+		std::lock_guard<std::mutex> lock (state.mutex);
+
+		state.stopRequested = true;
+		state.cv.notify_all ();
+	}
+
+	for (const pthread_t thread : state.workers)
+		pthread_join (thread, nullptr);
+
+	state.workers.clear ();
+}
+
+} // namespace MMD
@@ -1,5 +1,7 @@
 #include "DataAccess.hpp"
 
+#include <cassert>
+
 namespace MMD {
 
 CopiedDataPtr::CopiedDataPtr (const void* pData, size_t size): m_pData (MakeUniqueArray<char> (size))
@@ -7,4 +9,51 @@ CopiedDataPtr::CopiedDataPtr (const void* pData, size_t size): m_pData (MakeUniq
 	memcpy (m_pData.get (), pData, size);
 }
 
+DataProviderSlice::DataProviderSlice (IDataProvider* pParent, size_t offset, size_t size):
+	m_pParent (pParent),
+	m_offset (offset),
+	m_size (size)
+{
+	assert (offset + size <= pParent->GetSize ());
+}
+
+IDataPtr* DataProviderSlice::GetDataPtr ()
+{
+	IDataPtr* pParentDataPtr = m_pParent->GetDataPtr ();
+	if (pParentDataPtr == nullptr)
+		return nullptr;
+
+	m_dataPtr.Reset (pParentDataPtr, m_offset, m_size);
+
+	return &m_dataPtr;
+}
+
+void DataProviderSlice::SliceDataPtr::Reset (IDataPtr* pParent, size_t offset, size_t size)
+{
+	m_pParent = pParent;
+	m_offset  = offset;
+	m_size	  = size;
+}
+
+const char* DataProviderSlice::SliceDataPtr::Get (size_t offset, size_t size)
+{
+	if (offset + size > m_size)
+		return nullptr;
+
+	return m_pParent->Get (m_offset + offset, size);
+}
+
+const char* DataProviderSlice::SliceDataPtr::Get ()
+{
+	return m_pParent->Get (m_offset, m_size);
+}
+
+bool DataProviderSlice::SliceDataPtr::CopyTo (size_t offset, size_t size, void* pBuffer)
+{
+	if (offset + size > m_size)
+		return false;
+
+	return m_pParent->CopyTo (m_offset + offset, size, pBuffer);
+}
+
 } // namespace MMD
@@ -4,6 +4,7 @@
 #pragma once
 
 #include <cstddef>
+#include <cstring>
 
 #include "ZoneAllocator.hpp"
 
@@ -14,6 +15,18 @@ public:
 	virtual const char* Get (size_t offset, size_t size) = 0;
 	virtual const char* Get ()							 = 0;
 
+	// Copies a piece of the data into a caller-provided buffer. Returns true on success.
+	virtual bool CopyTo (size_t offset, size_t size, void* pBuffer)
+	{
+		const char* pData = Get (offset, size);
+		if (pData == nullptr)
+			return false;
+
+		memcpy (pBuffer, pData, size);
+
+		return true;
+	}
+
 	virtual ~IDataPtr () = default;
 };
 
@@ -60,6 +73,37 @@ private:
 	std::unique_ptr<IDataPtr> m_pDataPtr;
 };
 
+// Class for providing a piece of the data of another data provider (which must outlive it)
+class DataProviderSlice : public IDataProvider {
+public:
+	DataProviderSlice (IDataProvider* pParent, size_t offset, size_t size);
+
+	virtual size_t	  GetSize () override { return m_size; }
+	virtual IDataPtr* GetDataPtr () override;
+
+private:
+	class SliceDataPtr : public IDataPtr {
+	public:
+		SliceDataPtr (): m_pParent (nullptr), m_offset (0), m_size (0) {}
+
+		void Reset (IDataPtr* pParent, size_t offset, size_t size);
+
+		virtual const char* Get (size_t offset, size_t size) override;
+		virtual const char* Get () override;
+		virtual bool		CopyTo (size_t offset, size_t size, void* pBuffer) override;
+
+	private:
+		IDataPtr* m_pParent;
+		size_t	  m_offset;
+		size_t	  m_size;
+	};
+
+	IDataProvider* m_pParent;
+	size_t		   m_offset;
+	size_t		   m_size;
+	SliceDataPtr   m_dataPtr;
+};
+
 } // namespace MMD
 
 #endif // MMD_DATAACCESS
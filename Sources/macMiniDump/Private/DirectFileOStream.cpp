@@ -0,0 +1,260 @@
+#include "MMD/DirectFileOStream.hpp"
+
+#include <errno.h>
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <cstring>
+
+#include "MMD/FileDescriptorIO.hpp"
+#include "ZoneAllocator.hpp"
+
+namespace MMD {
+
+namespace {
+
+size_t AlignDown (size_t value)
+{
+	return value / DirectFileOStream::BlockSize * DirectFileOStream::BlockSize;
+}
+
+size_t AlignUp (size_t value)
+{
+	return AlignDown (value + DirectFileOStream::BlockSize - 1);
+}
+
+bool BypassCache (int fd)
+{
+#if defined __APPLE__
+	return fcntl (fd, F_NOCACHE, 1) != -1;
+#elif defined __linux__
+	// Fails with EINVAL on file systems not supporting direct I/O (e.g. tmpfs)
+	const int flags = fcntl (fd, F_GETFL);
+
+	return flags != -1 && fcntl (fd, F_SETFL, flags | O_DIRECT) != -1;
+#else
+	return false;
+#endif
+}
+
+} // namespace
+
+DirectFileOStream::DirectFileOStream (int fd, size_t bufferSize /*= DefaultBufferSize*/): m_fd (fd)
+{
+	Init (bufferSize);
+}
+
+DirectFileOStream::DirectFileOStream (const char* filePath, size_t bufferSize /*= DefaultBufferSize*/)
+{
+	m_fd = open (filePath, O_RDWR);
+	Init (bufferSize);
+}
+
+bool DirectFileOStream::Write (const void* pData, size_t size)
+{
+	if (!WriteAt (pData, size, m_position))
+		return false;
+
+	m_position += size;
+
+	return true;
+}
+
+bool DirectFileOStream::Flush ()
+{
+	return FlushBuffer () && TruncateToSize () && fsync (m_fd) == 0;
+}
+
+size_t DirectFileOStream::GetPosition ()
+{
+	return m_position;
+}
+
+void DirectFileOStream::SetPosition (size_t newPos)
+{
+	// The buffer is flushed by the next write, if it does not continue the buffered data
+	m_position = newPos;
+}
+
+size_t DirectFileOStream::GetSize ()
+{
+	return m_size;
+}
+
+bool DirectFileOStream::SetSize (size_t newSize)
+{
+	if (!FlushBuffer () || ftruncate (m_fd, newSize) != 0)
+		return false;
+
+	m_size	   = newSize;
+	m_fileSize = newSize;
+
+	return true;
+}
+
+bool DirectFileOStream::WriteAt (const void* pData, size_t size, size_t offset)
+{
+	if (!IsValid ())
+		return false;
+
+	if (size == 0)
+		return true;
+
+	if (m_dirtyBegin != m_dirtyEnd && offset != m_dirtyEnd && !FlushBuffer ())
+		return false;
+
+	// Start a new window
+	if (m_dirtyBegin == m_dirtyEnd) {
+		m_bufferOffset = AlignDown (offset);
+		m_dirtyBegin   = offset;
+		m_dirtyEnd	   = offset;
+	}
+
+	const char* pCurr = static_cast<const char*> (pData);
+	while (size > 0) {
+		// A full buffer ends at a block boundary, so the window can move on without reading anything back
+		const size_t bufferEnd = m_bufferOffset + m_bufferSize;
+		if (m_dirtyEnd == bufferEnd) {
+			if (!FlushBuffer ())
+				return false;
+
+			m_bufferOffset = bufferEnd;
+			m_dirtyBegin   = bufferEnd;
+		}
+
+		const size_t toCopy = std::min (size, m_bufferOffset + m_bufferSize - m_dirtyEnd);
+		memcpy (m_pBuffer + (m_dirtyEnd - m_bufferOffset), pCurr, toCopy);
+
+		pCurr += toCopy;
+		size -= toCopy;
+		m_dirtyEnd += toCopy;
+	}
+
+	m_size = std::max (m_size, m_dirtyEnd);
+
+	return true;
+}
+
+bool DirectFileOStream::Preallocate (size_t size)
+{
+	return PreallocateAll (m_fd, size);
+}
+
+DirectFileOStream::~DirectFileOStream ()
+{
+	Cleanup ();
+}
+
+bool DirectFileOStream::IsValid () const
+{
+	return m_fd != -1 && m_pBuffer != nullptr && m_pBlock != nullptr;
+}
+
+bool DirectFileOStream::IsDirect () const
+{
+	return m_direct;
+}
+
+void DirectFileOStream::Init (size_t bufferSize)
+{
+	m_direct	   = m_fd != -1 && BypassCache (m_fd);
+	m_bufferSize   = bufferSize > BlockSize ? AlignUp (bufferSize) : BlockSize;
+	m_pBuffer	   = static_cast<char*> (MallocAligned (m_bufferSize, BlockSize));
+	m_pBlock	   = static_cast<char*> (MallocAligned (BlockSize, BlockSize));
+	m_bufferOffset = 0;
+	m_dirtyBegin   = 0;
+	m_dirtyEnd	   = 0;
+	m_position	   = 0;
+
+	struct stat fileInfo;
+	m_fileSize = m_fd != -1 && fstat (m_fd, &fileInfo) == 0 ? fileInfo.st_size : 0;
+	m_size	   = m_fileSize;
+}
+
+// Writes the blocks covering the dirty range of the buffer, and empties it (m_dirtyEnd is kept)
+bool DirectFileOStream::FlushBuffer ()
+{
+	if (m_dirtyBegin == m_dirtyEnd)
+		return true;
+
+	const size_t begin = AlignDown (m_dirtyBegin);
+	const size_t end   = AlignUp (m_dirtyEnd);
+	if (m_dirtyBegin != begin && !CompleteBlock (begin))
+		return false;
+
+	// The first and the last block might be the same one
+	if (m_dirtyEnd != end && (end - BlockSize != begin || m_dirtyBegin == begin) && !CompleteBlock (end - BlockSize))
+		return false;
+
+	if (!PWriteAll (m_fd, m_pBuffer + (begin - m_bufferOffset), end - begin, begin))
+		return false;
+
+	m_fileSize	 = std::max (m_fileSize, end);
+	m_dirtyBegin = m_dirtyEnd;
+
+	return true;
+}
+
+// Fills the parts of the block outside the dirty range with what is in the file (zeroes beyond its end)
+bool DirectFileOStream::CompleteBlock (size_t blockOffset)
+{
+	memset (m_pBlock, 0, BlockSize);
+	if (blockOffset < m_fileSize) {
+		// Might be a short read at the end of the file
+		ssize_t nRead;
+		do {
+			nRead = pread (m_fd, m_pBlock, BlockSize, blockOffset);
+		} while (nRead == -1 && errno == EINTR);
+
+		if (nRead == -1)
+			return false;
+	}
+
+	char* const pBlockInBuffer = m_pBuffer + (blockOffset - m_bufferOffset);
+	if (m_dirtyBegin > blockOffset)
+		memcpy (pBlockInBuffer, m_pBlock, m_dirtyBegin - blockOffset);
+
+	if (m_dirtyEnd < blockOffset + BlockSize) {
+		const size_t dirtyEndInBlock = m_dirtyEnd - blockOffset;
+		memcpy (pBlockInBuffer + dirtyEndInBlock, m_pBlock + dirtyEndInBlock, BlockSize - dirtyEndInBlock);
+	}
+
+	return true;
+}
+
+// Cuts the padding of the last block
+bool DirectFileOStream::TruncateToSize ()
+{
+	if (m_fileSize <= m_size)
+		return true;
+
+	if (ftruncate (m_fd, m_size) != 0)
+		return false;
+
+	m_fileSize = m_size;
+
+	return true;
+}
+
+void DirectFileOStream::Cleanup ()
+{
+	if (m_fd != -1) {
+		FlushBuffer ();
+		TruncateToSize ();
+		close (m_fd);
+		m_fd = -1;
+	}
+
+	if (m_pBuffer != nullptr)
+		Free (m_pBuffer);
+
+	if (m_pBlock != nullptr)
+		Free (m_pBlock);
+
+	m_pBuffer = nullptr;
+	m_pBlock  = nullptr;
+}
+
+} // namespace MMD
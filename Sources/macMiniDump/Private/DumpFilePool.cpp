@@ -0,0 +1,314 @@
+#include "MMD/DumpFilePool.hpp"
+
+#include <fcntl.h>
+#include <limits.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <cstdio>
+
+#include "Logging.hpp"
+#include "MMD/CRC32C.hpp"
+#include "MMD/FileDescriptorIO.hpp"
+#include "ZoneAllocator.hpp"
+
+namespace MMD {
+
+namespace {
+
+constexpr uint32_t SlotMagic   = 0x544F4C53; // "SLOT"
+constexpr uint32_t SlotVersion = 1;
+
+struct SlotHeader {
+	uint32_t magic	  = SlotMagic;
+	uint32_t version  = SlotVersion;
+	uint64_t sequence = 0; // 0 if the slot holds no core file
+	uint64_t dumpSize = 0;
+	uint64_t capacity = 0;
+	uint32_t crc32c	  = 0; // Checksum of the header, with this field being 0
+	uint32_t reserved = 0;
+};
+
+uint32_t CalculateHeaderCRC32C (SlotHeader header)
+{
+	header.crc32c = 0;
+
+	return CRC32C (&header, sizeof header);
+}
+
+const char Zeroes[4'096] = {};
+
+} // namespace
+
+struct DumpFilePool::Slot {
+	int		 fd		  = -1;
+	uint64_t sequence = 0;
+	uint64_t dumpSize = 0;
+};
+
+// Stream over the data part of a slot file. The file is never resized: sizes are only tracked. Since the slot still
+//   holds the previous core file, ranges skipped by writes (e.g. by sparse output) are filled with zeroes, so
+//   positional writes can't be concurrent.
+class DumpFilePool::SlotOStream : public IRandomAccessBinaryOStream {
+public:
+	explicit SlotOStream (size_t capacity): m_fd (-1), m_capacity (capacity), m_position (0), m_size (0) {}
+
+	void Reset (int fd)
+	{
+		m_fd	   = fd;
+		m_position = 0;
+		m_size	   = 0;
+	}
+
+	virtual bool Write (const void* pData, size_t size) override
+	{
+		if (!WriteAt (pData, size, m_position))
+			return false;
+
+		m_position += size;
+
+		return true;
+	}
+
+	virtual bool Flush () override { return fsync (m_fd) == 0; }
+
+	virtual size_t GetPosition () override { return m_position; }
+	virtual void   SetPosition (size_t newPos) override { m_position = newPos; }
+
+	virtual size_t GetSize () override { return m_size; }
+
+	virtual bool SetSize (size_t newSize) override
+	{
+		if (newSize > m_capacity || !ZeroFill (m_size, newSize))
+			return false;
+
+		m_size = newSize;
+
+		return true;
+	}
+
+	virtual bool WriteAt (const void* pData, size_t size, size_t offset) override
+	{
+		if (offset > m_capacity || size > m_capacity - offset || !ZeroFill (m_size, offset))
+			return false;
+
+		if (!PWriteAll (m_fd, pData, size, HeaderSize + offset))
+			return false;
+
+		m_size = std::max (m_size, offset + size);
+
+		return true;
+	}
+
+	// The whole slot is allocated already
+	virtual bool Preallocate (size_t size) override { return size <= m_capacity; }
+
+private:
+	int			 m_fd;
+	const size_t m_capacity;
+	size_t		 m_position;
+	size_t		 m_size;
+
+	bool ZeroFill (size_t begin, size_t end)
+	{
+		for (size_t offset = begin; offset < end; offset += sizeof Zeroes) {
+			if (!PWriteAll (m_fd, Zeroes, std::min (end - offset, sizeof Zeroes), HeaderSize + offset))
+				return false;
+		}
+
+		return true;
+	}
+};
+
+struct DumpFilePool::State : public ZoneAllocated {
+	explicit State (size_t slotSize): slotSize (slotSize), oStream (slotSize) {}
+
+	const size_t slotSize;
+	Vector<Slot> slots;
+	SlotOStream	 oStream;
+	size_t		 acquiredSlot = SIZE_MAX;
+	uint64_t	 lastSequence = 0;
+	bool		 valid		  = false;
+};
+
+DumpFilePool::DumpFilePool (const char* directoryPath, size_t slotCount, size_t slotSize):
+	m_pState (new State (slotSize))
+{
+	m_pState->valid = Open (directoryPath, slotCount);
+}
+
+DumpFilePool::~DumpFilePool ()
+{
+	for (const Slot& slot : m_pState->slots) {
+		if (slot.fd != -1)
+			close (slot.fd);
+	}
+}
+
+bool DumpFilePool::IsValid () const
+{
+	return m_pState->valid;
+}
+
+IRandomAccessBinaryOStream* DumpFilePool::AcquireSlot ()
+{
+	State& state = *m_pState;
+	if (!state.valid || state.acquiredSlot != SIZE_MAX || state.slots.empty ())
+		return nullptr;
+
+	// Empty slots have a sequence number of 0
+	size_t oldest = 0;
+	for (size_t i = 1; i < state.slots.size (); ++i) {
+		if (state.slots[i].sequence < state.slots[oldest].sequence)
+			oldest = i;
+	}
+
+	// The slot is marked empty first, so that a core file left incomplete (e.g. by a crash while writing it) is not
+	//   mistaken for a valid one
+	Slot& slot	  = state.slots[oldest];
+	slot.sequence = 0;
+	slot.dumpSize = 0;
+	if (!WriteHeader (slot))
+		return nullptr;
+
+	state.acquiredSlot = oldest;
+	state.oStream.Reset (slot.fd);
+
+	return &state.oStream;
+}
+
+bool DumpFilePool::CommitSlot ()
+{
+	State& state = *m_pState;
+	if (state.acquiredSlot == SIZE_MAX)
+		return false;
+
+	Slot& slot		   = state.slots[state.acquiredSlot];
+	state.acquiredSlot = SIZE_MAX;
+
+	// The core file has to be on disk before the header says so
+	if (fsync (slot.fd) != 0)
+		return false;
+
+	slot.sequence = ++state.lastSequence;
+	slot.dumpSize = state.oStream.GetSize ();
+
+	return WriteHeader (slot) && fsync (slot.fd) == 0;
+}
+
+size_t DumpFilePool::GetSlotCount () const
+{
+	return m_pState->slots.size ();
+}
+
+bool DumpFilePool::GetSlotInfo (size_t slotIndex, uint64_t* pSequenceOut, uint64_t* pSizeOut) const
+{
+	const State& state = *m_pState;
+	if (slotIndex >= state.slots.size () || state.slots[slotIndex].sequence == 0)
+		return false;
+
+	*pSequenceOut = state.slots[slotIndex].sequence;
+	*pSizeOut	  = state.slots[slotIndex].dumpSize;
+
+	return true;
+}
+
+bool DumpFilePool::CopySlot (size_t slotIndex, ISequentialBinaryOStream* pOStream) const
+{
+	uint64_t sequence;
+	uint64_t dumpSize;
+	if (!GetSlotInfo (slotIndex, &sequence, &dumpSize))
+		return false;
+
+	const size_t	  BufferSize = 1'024 * 1'024;
+	UniquePtr<char[]> pBuffer;
+	try {
+		pBuffer = MakeUniqueArray<char> (BufferSize);
+	} catch (const std::bad_alloc&) {
+		return false;
+	}
+
+	const int fd = m_pState->slots[slotIndex].fd;
+	for (uint64_t copied = 0; copied < dumpSize;) {
+		const size_t toCopy = std::min<uint64_t> (dumpSize - copied, BufferSize);
+		if (!PReadAll (fd, pBuffer.get (), toCopy, HeaderSize + copied) || !pOStream->Write (pBuffer.get (), toCopy))
+			return false;
+
+		copied += toCopy;
+	}
+
+	return true;
+}
+
+bool DumpFilePool::DiscardSlot (size_t slotIndex)
+{
+	State& state = *m_pState;
+	if (!state.valid || slotIndex >= state.slots.size () || slotIndex == state.acquiredSlot)
+		return false;
+
+	Slot& slot	  = state.slots[slotIndex];
+	slot.sequence = 0;
+	slot.dumpSize = 0;
+
+	return WriteHeader (slot);
+}
+
+// Creates (or reuses) and allocates every slot file, and picks up the core files already in them
+bool DumpFilePool::Open (const char* directoryPath, size_t slotCount)
+{
+	State& state = *m_pState;
+	try {
+		state.slots.resize (slotCount);
+	} catch (const std::bad_alloc&) {
+		return false;
+	}
+
+	for (size_t i = 0; i < slotCount; ++i) {
+		char slotPath[PATH_MAX];
+		if (snprintf (slotPath, sizeof slotPath, "%s/slot%zu.mmdslot", directoryPath, i) >= int (sizeof slotPath))
+			return false;
+
+		Slot& slot = state.slots[i];
+		slot.fd	   = open (slotPath, O_RDWR | O_CREAT, 0666);
+		if (slot.fd == -1) {
+			MMD_DEBUGLOG_LINE << "Failed to open slot file " << slotPath;
+
+			return false;
+		}
+
+		// Core files in slots of a different capacity are dropped
+		SlotHeader header;
+		if (PReadAll (slot.fd, &header, sizeof header, 0) && header.magic == SlotMagic &&
+			header.version == SlotVersion && header.crc32c == CalculateHeaderCRC32C (header) &&
+			header.capacity == state.slotSize && header.dumpSize <= state.slotSize) {
+			slot.sequence	   = header.sequence;
+			slot.dumpSize	   = header.dumpSize;
+			state.lastSequence = std::max (state.lastSequence, header.sequence);
+		} else if (!WriteHeader (slot)) {
+			return false;
+		}
+
+		const size_t fileSize = HeaderSize + state.slotSize;
+		if (!PreallocateAll (slot.fd, fileSize) || ftruncate (slot.fd, fileSize) != 0) {
+			MMD_DEBUGLOG_LINE << "Failed to allocate slot file " << slotPath;
+
+			return false;
+		}
+	}
+
+	return true;
+}
+
+bool DumpFilePool::WriteHeader (const Slot& slot)
+{
+	SlotHeader header;
+	header.sequence = slot.sequence;
+	header.dumpSize = slot.dumpSize;
+	header.capacity = m_pState->slotSize;
+	header.crc32c	= CalculateHeaderCRC32C (header);
+
+	return PWriteAll (slot.fd, &header, sizeof header, 0);
+}
+
+} // namespace MMD
@@ -3,6 +3,8 @@
 #include <fcntl.h>
 #include <unistd.h>
 
+#include "MMD/FileDescriptorIO.hpp"
+
 namespace MMD {
 
 FileOStream::FileOStream (FILE* pFile): IRandomAccessBinaryOStream (), m_fd (fileno (pFile)) {}
@@ -19,9 +21,14 @@ bool FileOStream::Write (const void* pData, size_t size)
 	return write (m_fd, pData, size) != -1;
 }
 
+bool FileOStream::WriteV (const iovec* pIOVecs, size_t count)
+{
+	return WriteVAll (m_fd, pIOVecs, count);
+}
+
 bool FileOStream::Flush ()
 {
-	return fsync (m_fd);
+	return fsync (m_fd) == 0;
 }
 
 size_t FileOStream::GetPosition ()
@@ -49,6 +56,37 @@ bool FileOStream::SetSize (size_t newSize)
 	return ftruncate (m_fd, newSize) != -1;
 }
 
+bool FileOStream::WriteAt (const void* pData, size_t size, size_t offset)
+{
+	return PWriteAll (m_fd, pData, size, offset);
+}
+
+bool FileOStream::SupportsConcurrentWriteAt () const
+{
+	// pwrite does not use (or change) the file offset
+	return true;
+}
+
+bool FileOStream::PunchHole (size_t offset, size_t size)
+{
+#if defined __APPLE__
+	fpunchhole_t args = {};
+	args.fp_offset	  = offset;
+	args.fp_length	  = size;
+
+	return fcntl (m_fd, F_PUNCHHOLE, &args) != -1;
+#elif defined __linux__
+	return fallocate (m_fd, FALLOC_FL_PUNCH_HOLE | FALLOC_FL_KEEP_SIZE, offset, size) == 0;
+#else
+	return false;
+#endif
+}
+
+bool FileOStream::Preallocate (size_t size)
+{
+	return PreallocateAll (m_fd, size);
+}
+
 FileOStream::~FileOStream ()
 {
 	Cleanup ();
@@ -1,8 +0,0 @@
-#include "MMD/IRandomAccessBinaryOStream.hpp"
-
-namespace MMD {
-
-IRandomAccessBinaryOStream::IRandomAccessBinaryOStream ()  = default;
-IRandomAccessBinaryOStream::~IRandomAccessBinaryOStream () = default;
-
-} // namespace MMD
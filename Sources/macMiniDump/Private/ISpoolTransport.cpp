@@ -0,0 +1,8 @@
+#include "MMD/ISpoolTransport.hpp"
+
+namespace MMD {
+
+ISpoolTransport::ISpoolTransport ()	 = default;
+ISpoolTransport::~ISpoolTransport () = default;
+
+} // namespace MMD
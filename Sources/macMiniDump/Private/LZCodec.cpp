@@ -0,0 +1,274 @@
+#include "LZCodec.hpp"
+
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+
+namespace MMD {
+namespace {
+
+constexpr size_t MinMatch		  = 4;
+constexpr size_t MaxOffset		  = 65'535;
+constexpr size_t LastLiterals	  = 5;	// The last bytes of a block are always literals...
+constexpr size_t MatchSearchLimit = 12; // ...and no match starts this close to the end of a block
+constexpr size_t LengthMask		  = 15; // Lengths of 15 or more continue in additional bytes
+
+constexpr unsigned HashBits = 13;
+
+uint32_t Load32 (const uint8_t* pData)
+{
+	uint32_t word;
+	memcpy (&word, pData, sizeof word);
+
+	return word;
+}
+
+uint64_t Load64 (const uint8_t* pData)
+{
+	uint64_t word;
+	memcpy (&word, pData, sizeof word);
+
+	return word;
+}
+
+uint32_t Hash (uint32_t sequence)
+{
+	return (sequence * 2'654'435'761U) >> (32 - HashBits);
+}
+
+// Returns the end of the match of the data at pos and at candidate, which must not go beyond end
+size_t ExtendMatch (const uint8_t* pData, size_t pos, size_t candidate, size_t end)
+{
+	// Both supported CPUs are little-endian, so the first differing byte is the lowest set one
+	while (pos + sizeof (uint64_t) <= end) {
+		const uint64_t difference = Load64 (pData + pos) ^ Load64 (pData + candidate);
+		if (difference != 0)
+			return pos + __builtin_ctzll (difference) / 8;
+
+		pos += sizeof (uint64_t);
+		candidate += sizeof (uint64_t);
+	}
+
+	while (pos < end && pData[pos] == pData[candidate]) {
+		++pos;
+		++candidate;
+	}
+
+	return pos;
+}
+
+class Output {
+public:
+	Output (uint8_t* pBegin, size_t capacity): m_pCurr (pBegin), m_pEnd (pBegin + capacity) {}
+
+	uint8_t* GetCurrent () const { return m_pCurr; }
+
+	bool WriteByte (uint8_t byte)
+	{
+		if (m_pCurr == m_pEnd)
+			return false;
+
+		*m_pCurr++ = byte;
+
+		return true;
+	}
+
+	bool WriteBytes (const uint8_t* pData, size_t size)
+	{
+		if (size_t (m_pEnd - m_pCurr) < size)
+			return false;
+
+		memcpy (m_pCurr, pData, size);
+		m_pCurr += size;
+
+		return true;
+	}
+
+	// Continuation of a length, which has been (partially) stored in a token already
+	bool WriteLength (size_t length)
+	{
+		for (; length >= 255; length -= 255) {
+			if (!WriteByte (255))
+				return false;
+		}
+
+		return WriteByte (uint8_t (length));
+	}
+
+	// A matchLength of zero means no match, which is only allowed for the last sequence
+	bool WriteSequence (const uint8_t* pLiterals, size_t nLiterals, size_t offset, size_t matchLength)
+	{
+		const size_t matchCode = matchLength == 0 ? 0 : matchLength - MinMatch;
+		const size_t token	   = std::min (nLiterals, LengthMask) << 4 | std::min (matchCode, LengthMask);
+
+		if (!WriteByte (uint8_t (token)))
+			return false;
+
+		if (nLiterals >= LengthMask && !WriteLength (nLiterals - LengthMask))
+			return false;
+
+		if (!WriteBytes (pLiterals, nLiterals))
+			return false;
+
+		if (matchLength == 0)
+			return true;
+
+		if (!WriteByte (uint8_t (offset)) || !WriteByte (uint8_t (offset >> 8)))
+			return false;
+
+		return matchCode < LengthMask || WriteLength (matchCode - LengthMask);
+	}
+
+private:
+	uint8_t*	   m_pCurr;
+	uint8_t* const m_pEnd;
+};
+
+class Input {
+public:
+	Input (const uint8_t* pBegin, size_t size): m_pCurr (pBegin), m_pEnd (pBegin + size) {}
+
+	bool IsAtEnd () const { return m_pCurr == m_pEnd; }
+
+	bool ReadByte (uint8_t* pByteOut)
+	{
+		if (m_pCurr == m_pEnd)
+			return false;
+
+		*pByteOut = *m_pCurr++;
+
+		return true;
+	}
+
+	const uint8_t* ReadBytes (size_t size)
+	{
+		if (size_t (m_pEnd - m_pCurr) < size)
+			return nullptr;
+
+		const uint8_t* pBytes = m_pCurr;
+		m_pCurr += size;
+
+		return pBytes;
+	}
+
+	bool ReadLength (size_t* pLength)
+	{
+		uint8_t byte;
+		do {
+			if (!ReadByte (&byte))
+				return false;
+
+			*pLength += byte;
+		} while (byte == 255);
+
+		return true;
+	}
+
+private:
+	const uint8_t*		 m_pCurr;
+	const uint8_t* const m_pEnd;
+};
+
+} // namespace
+
+size_t LZCompress (const void* pSrc, size_t srcSize, void* pDst, size_t dstCapacity)
+{
+	const uint8_t* pIn = static_cast<const uint8_t*> (pSrc);
+	Output		   output (static_cast<uint8_t*> (pDst), dstCapacity);
+
+	// Greedy parsing: the most recent position with the same hash is the only match candidate
+	uint32_t positions[1 << HashBits] = {};
+	size_t	 anchor					  = 0; // Start of the pending literals
+	size_t	 pos					  = 0;
+	while (pos + MatchSearchLimit <= srcSize) {
+		const uint32_t sequence	 = Load32 (pIn + pos);
+		uint32_t&	   entry	 = positions[Hash (sequence)];
+		const size_t   candidate = entry;
+		entry					 = uint32_t (pos);
+
+		if (candidate >= pos || pos - candidate > MaxOffset || Load32 (pIn + candidate) != sequence) {
+			// The longer no match is found, the faster incompressible data is skipped
+			pos += 1 + ((pos - anchor) >> 6);
+
+			continue;
+		}
+
+		const size_t offset		= pos - candidate;
+		size_t		 matchStart = pos;
+		while (matchStart > anchor && matchStart > offset && pIn[matchStart - 1] == pIn[matchStart - 1 - offset])
+			--matchStart;
+
+		const size_t matchEnd = ExtendMatch (pIn, pos + MinMatch, candidate + MinMatch, srcSize - LastLiterals);
+		if (!output.WriteSequence (pIn + anchor, matchStart - anchor, offset, matchEnd - matchStart))
+			return 0;
+
+		// Positions inside the match are not hashed (for speed), except for one near its end
+		positions[Hash (Load32 (pIn + matchEnd - 2))] = uint32_t (matchEnd - 2);
+
+		pos	   = matchEnd;
+		anchor = matchEnd;
+	}
+
+	if (!output.WriteSequence (pIn + anchor, srcSize - anchor, 0, 0))
+		return 0;
+
+	return output.GetCurrent () - static_cast<uint8_t*> (pDst);
+}
+
+bool LZDecompress (const void* pSrc, size_t srcSize, void* pDst, size_t dstSize)
+{
+	Input		   input (static_cast<const uint8_t*> (pSrc), srcSize);
+	uint8_t* const pOutBegin = static_cast<uint8_t*> (pDst);
+	uint8_t*	   pOut		 = pOutBegin;
+	uint8_t* const pOutEnd	 = pOutBegin + dstSize;
+
+	while (true) {
+		uint8_t token;
+		if (!input.ReadByte (&token))
+			return false;
+
+		size_t nLiterals = token >> 4;
+		if (nLiterals == LengthMask && !input.ReadLength (&nLiterals))
+			return false;
+
+		const uint8_t* pLiterals = input.ReadBytes (nLiterals);
+		if (pLiterals == nullptr || size_t (pOutEnd - pOut) < nLiterals)
+			return false;
+
+		memcpy (pOut, pLiterals, nLiterals);
+		pOut += nLiterals;
+
+		// The last sequence has no match
+		if (input.IsAtEnd ())
+			return pOut == pOutEnd;
+
+		const uint8_t* pOffset = input.ReadBytes (2);
+		if (pOffset == nullptr)
+			return false;
+
+		const size_t offset = pOffset[0] | size_t (pOffset[1]) << 8;
+		if (offset == 0 || offset > size_t (pOut - pOutBegin))
+			return false;
+
+		size_t matchLength = token & LengthMask;
+		if (matchLength == LengthMask && !input.ReadLength (&matchLength))
+			return false;
+
+		matchLength += MinMatch;
+		if (size_t (pOutEnd - pOut) < matchLength)
+			return false;
+
+		// The match might overlap the data it produces (e.g. runs of the same byte). Then the data between the match
+		//   and the output is repeated, which can be copied in increasingly large steps without overlapping.
+		const uint8_t* pMatch = pOut - offset;
+		while (matchLength > 0) {
+			const size_t toCopy = std::min (matchLength, size_t (pOut - pMatch));
+			memcpy (pOut, pMatch, toCopy);
+
+			pOut += toCopy;
+			matchLength -= toCopy;
+		}
+	}
+}
+
+} // namespace MMD
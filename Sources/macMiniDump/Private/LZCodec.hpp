@@ -0,0 +1,23 @@
+#ifndef MMD_LZCODEC
+#define MMD_LZCODEC
+
+#pragma once
+
+#include <cstddef>
+
+namespace MMD {
+
+// Compression of independent blocks with a simple and fast LZ77 variant, using the block format of LZ4: sequences of
+//   literals, each followed by a back-reference of at least 4 bytes within the previous 64 KiB. There is no framing,
+//   so the size of the uncompressed data has to be stored separately.
+
+// Returns the compressed size, or 0 if the compressed data would not fit into dstCapacity bytes
+size_t LZCompress (const void* pSrc, size_t srcSize, void* pDst, size_t dstCapacity);
+
+// dstSize must be the exact size of the uncompressed data. Malformed input is detected (returns false), it never
+//   causes reads or writes out of bounds.
+bool LZDecompress (const void* pSrc, size_t srcSize, void* pDst, size_t dstSize);
+
+} // namespace MMD
+
+#endif // MMD_LZCODEC
@@ -0,0 +1,49 @@
+#include "MMD/LocalDirectorySpoolTransport.hpp"
+
+#include "MMD/CRC32C.hpp"
+#include "SpoolFormat.hpp"
+#include "ZoneAllocator.hpp"
+
+namespace MMD {
+
+struct LocalDirectorySpoolTransport::State : public ZoneAllocated {
+	String directoryPath;
+	bool   valid = false;
+};
+
+LocalDirectorySpoolTransport::LocalDirectorySpoolTransport (const char* directoryPath): m_pState (new State)
+{
+	try {
+		m_pState->directoryPath = directoryPath;
+		m_pState->valid			= true;
+	} catch (const std::bad_alloc&) {
+	}
+}
+
+bool LocalDirectorySpoolTransport::SendChunk ([[maybe_unused]] uint64_t spoolId,
+											  uint64_t					chunkIndex,
+											  const void*				pData,
+											  size_t					size,
+											  uint32_t					crc32c)
+{
+	char chunkPath[PATH_MAX];
+	if (!m_pState->valid || CRC32C (pData, size) != crc32c ||
+		!SpoolFormat::FormatChunkPath (m_pState->directoryPath.c_str (), chunkIndex, chunkPath))
+		return false;
+
+	return SpoolFormat::WriteFileAtomically (chunkPath, pData, size);
+}
+
+bool LocalDirectorySpoolTransport::SendManifest ([[maybe_unused]] uint64_t spoolId, const void* pData, size_t size)
+{
+	char manifestPath[PATH_MAX];
+	if (!m_pState->valid ||
+		!SpoolFormat::FormatFilePath (m_pState->directoryPath.c_str (), SpoolFormat::ManifestFileName, manifestPath))
+		return false;
+
+	return SpoolFormat::WriteFileAtomically (manifestPath, pData, size);
+}
+
+LocalDirectorySpoolTransport::~LocalDirectorySpoolTransport () = default;
+
+} // namespace MMD
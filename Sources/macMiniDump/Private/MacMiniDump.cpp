@@ -10,10 +10,12 @@
 
 #include <CoreServices/CoreServices.h>
 
+#include <algorithm>
 #include <cinttypes>
 #include <map>
 #include <memory>
 #include <string>
+#include <type_traits>
 #include <vector>
 
 #include "MMD/FileOStream.hpp"
@@ -34,6 +36,9 @@ namespace {
 
 class DisjointIntervalSet {
 public:
+	// The total length of the intervals in the set never exceeds the budget (see InsertWithinBudget)
+	explicit DisjointIntervalSet (uint64_t budget = UINT64_MAX): m_budget (budget), m_totalLength (0) {}
+
 	// Insert interval [start, start + length). Overlapping intervals are merged.
 	void InsertAndMergeIfNeeded (uint64_t start, uint64_t length)
 	{
@@ -53,13 +58,78 @@ public:
 				// Intervals overlap or are adjacent - merge them
 				start = std::min (start, it->first);
 				end	  = std::max (end, it->second);
-				it	  = m_intervals.erase (it);
+				m_totalLength -= it->second - it->first;
+				it = m_intervals.erase (it);
 			} else {
 				++it;
 			}
 		}
 
 		m_intervals[start] = end;
+		m_totalLength += end - start;
+	}
+
+	// Insert the largest window [anchor - r, anchor + r) (clipped to [start, start + length)) that fits into the
+	//   remaining budget. Only bytes not covered by the set yet count against the budget. The window inserted is
+	//   returned in [*pKeptStartOut, *pKeptEndOut), it is empty if nothing fits. anchor must be within the interval.
+	void InsertWithinBudget (uint64_t  start,
+							 uint64_t  length,
+							 uint64_t  anchor,
+							 uint64_t* pKeptStartOut,
+							 uint64_t* pKeptEndOut)
+	{
+		const uint64_t end		 = start + length;
+		const uint64_t remaining = m_budget - m_totalLength;
+
+		const auto getWindow = [&] (uint64_t radius, uint64_t* pWindowStartOut, uint64_t* pWindowEndOut) {
+			*pWindowStartOut = anchor - start > radius ? anchor - radius : start;
+			*pWindowEndOut	 = end - anchor > radius ? anchor + radius : end;
+		};
+
+		// The number of uncovered bytes grows with the radius, so the largest radius that fits is found by bisection
+		uint64_t minRadius = 0;
+		uint64_t maxRadius = std::max (anchor - start, end - anchor);
+		if (CountUncovered (start, end) <= remaining)
+			minRadius = maxRadius;
+
+		while (minRadius < maxRadius) {
+			const uint64_t radius = minRadius + (maxRadius - minRadius + 1) / 2;
+
+			uint64_t windowStart;
+			uint64_t windowEnd;
+			getWindow (radius, &windowStart, &windowEnd);
+			if (CountUncovered (windowStart, windowEnd) <= remaining)
+				minRadius = radius;
+			else
+				maxRadius = radius - 1;
+		}
+
+		getWindow (minRadius, pKeptStartOut, pKeptEndOut);
+		InsertAndMergeIfNeeded (*pKeptStartOut, *pKeptEndOut - *pKeptStartOut);
+	}
+
+	// Calls func (gapStart, gapEnd) for every part of [start, end) not covered by the set, in increasing order
+	template<typename Func>
+	void ForEachUncovered (uint64_t start, uint64_t end, Func&& func) const
+	{
+		uint64_t pos = start;
+
+		auto it = m_intervals.upper_bound (start);
+		if (it != m_intervals.begin ())
+			--it;
+
+		for (; it != m_intervals.end () && it->first < end && pos < end; ++it) {
+			if (it->second <= pos)
+				continue;
+
+			if (it->first > pos)
+				func (pos, it->first);
+
+			pos = std::min (it->second, end);
+		}
+
+		if (pos < end)
+			func (pos, end);
 	}
 
 	// Iterate over all merged intervals as (start, length) pairs
@@ -72,7 +142,19 @@ public:
 	}
 
 private:
+	uint64_t CountUncovered (uint64_t start, uint64_t end) const
+	{
+		uint64_t uncovered = 0;
+		ForEachUncovered (start, end, [&] (uint64_t gapStart, uint64_t gapEnd) {
+			uncovered += gapEnd - gapStart;
+		});
+
+		return uncovered;
+	}
+
 	Map<uint64_t, uint64_t> m_intervals; // start -> end
+	uint64_t				m_budget;
+	uint64_t				m_totalLength;
 };
 
 bool GetMemoryProtection (mach_port_t taskPort, uint64_t addr, uint64_t size, MemoryProtection* pProtOut)
@@ -328,12 +410,9 @@ MachOCore::MainBinSpec CreateMainBinSpecPayload (const ModuleList& modules)
 	return {};
 }
 
-bool AddPayloadsAndWrite (MachOCoreDumpBuilder*		  pCoreBuilder,
-						  const ModuleList&			  modules,
-						  const Vector<uint64_t>&	  threadIds,
-						  IRandomAccessBinaryOStream* pOStream)
+bool AddPayloads (MachOCoreDumpBuilder* pCoreBuilder, const ModuleList& modules, const Vector<uint64_t>& threadIds)
 {
-	// Add all load command payloads when needed, calculate data offsets, then write out core dump content
+	// Add all load command payloads when needed, calculate data offsets
 
 	// Addressable bits of the address space of the process
 	uint32_t nAddrabbleBits = 0;
@@ -383,12 +462,7 @@ bool AddPayloadsAndWrite (MachOCoreDumpBuilder*		  pCoreBuilder,
 																									sizeof mainBinSpec),
 																				 sizeof mainBinSpec));
 
-	for (size_t i = 0; i < pCoreBuilder->GetNumberOfSegmentCommands (); ++i) {
-		segment_command_64* pSegment = pCoreBuilder->GetSegmentCommand (i);
-		pCoreBuilder->GetOffsetForSegmentCommandPayload (pSegment->vmaddr, &pSegment->fileoff);
-	}
-
-	return pCoreBuilder->Build (pOStream);
+	return true;
 }
 
 bool SuspendAllThreadsExceptCurrentOne (mach_port_t taskPort, Vector<MachPortSendRightRef>* pSuspendedThreadsOut)
@@ -440,17 +514,87 @@ void ResumeThreads (const Vector<MachPortSendRightRef>& threads)
 	}
 }
 
-bool AddThreadsToCore (mach_port_t			 taskPort,
-					   MachOCoreDumpBuilder* pCoreBuilder,
-					   ModuleList*			 pModules,
-					   Vector<uint64_t>*	 pThreadIds,
-					   MMDCrashContext*		 pCrashContext /*= nullptr*/)
+// A range of memory that is a candidate for inclusion in the core file
+struct CandidateRange {
+	uint64_t					   start;
+	uint64_t					   length;
+	MachOCore::MemoryRangePriority priority;
+	uint64_t					   anchor; // If the range does not fit into the budget, the bytes around it are kept
+};
+
+// Admits candidate ranges into memoryRangesToAdd in the order of their priority, until the budget of
+//   memoryRangesToAdd is exhausted. Bytes of ranges not admitted (and not admitted as part of another range either)
+//   are recorded in pDroppedRangesOut, each one once, with the highest priority of the ranges dropping it.
+void AdmitCandidateRanges (Vector<CandidateRange>*				 pCandidates,
+						   DisjointIntervalSet*					 pMemoryRangesToAdd,
+						   Vector<MachOCore::DroppedRangeEntry>* pDroppedRangesOut)
+{
+	// Stable, so ranges of the same priority are admitted in thread order
+	std::stable_sort (pCandidates->begin (),
+					  pCandidates->end (),
+					  [] (const CandidateRange& lhs, const CandidateRange& rhs) {
+						  return lhs.priority < rhs.priority;
+					  });
+
+	// Parts of candidates not admitted. A window kept around an anchor might not exhaust the budget, so later ones
+	//   can still admit some of these bytes: they are only known to be dropped once every candidate has been admitted.
+	Vector<CandidateRange> notAdmitted;
+	for (const CandidateRange& candidate : *pCandidates) {
+		const uint64_t end = candidate.start + candidate.length;
+
+		uint64_t keptStart;
+		uint64_t keptEnd;
+		pMemoryRangesToAdd->InsertWithinBudget (candidate.start,
+												candidate.length,
+												candidate.anchor,
+												&keptStart,
+												&keptEnd);
+		if (keptStart == keptEnd) {
+			notAdmitted.push_back (candidate);
+		} else {
+			const uint64_t prefixLength = keptStart - candidate.start;
+			notAdmitted.push_back ({ candidate.start, prefixLength, candidate.priority, candidate.start });
+			notAdmitted.push_back ({ keptEnd, end - keptEnd, candidate.priority, keptEnd });
+		}
+	}
+
+	// Still in the order of priority, so every byte is recorded once, with the highest priority of the candidates it
+	//   was part of
+	DisjointIntervalSet accountedFor = *pMemoryRangesToAdd; // Admitted, or recorded as dropped
+	for (const CandidateRange& part : notAdmitted) {
+		const uint64_t partEnd = part.start + part.length;
+
+		Vector<std::pair<uint64_t, uint64_t>> droppedParts;
+		accountedFor.ForEachUncovered (part.start, partEnd, [&] (uint64_t gapStart, uint64_t gapEnd) {
+			droppedParts.push_back ({ gapStart, gapEnd });
+		});
+
+		for (const auto& [droppedStart, droppedEnd] : droppedParts) {
+			MachOCore::DroppedRangeEntry entry;
+			entry.address  = droppedStart;
+			entry.size	   = droppedEnd - droppedStart;
+			entry.priority = part.priority;
+			pDroppedRangesOut->push_back (entry);
+
+			accountedFor.InsertAndMergeIfNeeded (droppedStart, droppedEnd - droppedStart);
+		}
+	}
+}
+
+bool AddThreadsToCore (mach_port_t							 taskPort,
+					   MachOCoreDumpBuilder*				 pCoreBuilder,
+					   ModuleList*							 pModules,
+					   Vector<uint64_t>*					 pThreadIds,
+					   uint64_t								 memoryBudget,
+					   Vector<MachOCore::DroppedRangeEntry>* pDroppedRangesOut,
+					   MMDCrashContext*						 pCrashContext /*= nullptr*/)
 {
 	thread_act_port_array_t threads;
 	mach_msg_type_number_t	nThreads;
 	MachPortSendRightRef	thisThreadRef = MachPortSendRightRef::Wrap (mach_thread_self ());
 
 	pThreadIds->clear ();
+	pDroppedRangesOut->clear ();
 
 	if (task_threads (taskPort, &threads, &nThreads) != KERN_SUCCESS)
 		return false;
@@ -464,8 +608,10 @@ bool AddThreadsToCore (mach_port_t			 taskPort,
 
 	MemoryRegionList memoryRegions (taskPort);
 
-	// Collect all memory ranges to add, then merge overlapping ones before adding to core
-	DisjointIntervalSet memoryRangesToAdd;
+	// Collect all memory ranges to add, then admit them by priority (within the budget, if any), merging overlapping
+	//   ones before adding to core
+	Vector<CandidateRange> candidates;
+	DisjointIntervalSet	   memoryRangesToAdd (memoryBudget == 0 ? UINT64_MAX : memoryBudget);
 
 	for (unsigned int i = 0; i < nThreads; ++i) {
 #ifdef __x86_64__
@@ -498,7 +644,8 @@ bool AddThreadsToCore (mach_port_t			 taskPort,
 			MMD_DEBUGLOG_LINE << "Unable to get tid for thread #" << i << "!";
 		}
 
-		if (pCrashContext != nullptr && tid == pCrashContext->crashedTID) {
+		const bool crashingThread = pCrashContext != nullptr && tid == pCrashContext->crashedTID;
+		if (crashingThread) {
 			MMD_DEBUGLOG_LINE << "Found crashing thread (tid " << tid << " )";
 
 			memcpy (&ts, &pCrashContext->mcontext.__ss, sizeof ts);
@@ -530,6 +677,8 @@ bool AddThreadsToCore (mach_port_t			 taskPort,
 
 		Vector<uint64_t> callStack = WalkStack (taskPort, memoryRegions, *pModules, gpr, exc);
 
+		const MachOCore::MemoryRangePriority codePriority =
+			crashingThread ? MachOCore::MemoryRangePriority::CrashingThreadCode : MachOCore::MemoryRangePriority::Code;
 		for (const auto ip : callStack) {
 			// Add some memory before and after every instruction pointer on the call stack. This is needed for
 			// stack walking to work properly when opening the core, as LLDB checks the protection of the memory
@@ -543,7 +692,7 @@ bool AddThreadsToCore (mach_port_t			 taskPort,
 			if (ip >= SurroundingsRange && ip <= UINT64_MAX - SurroundingsRange) {
 				const uint64_t start  = ip - SurroundingsRange;
 				const size_t   length = (2 * SurroundingsRange) + 1;
-				memoryRangesToAdd.InsertAndMergeIfNeeded (start, length);
+				candidates.push_back ({ start, length, codePriority, ip });
 			} else {
 				MMD_DEBUGLOG_LINE << "Skipping address " << ip << " on thread #" << i << " because it is out of range!";
 			}
@@ -574,10 +723,30 @@ bool AddThreadsToCore (mach_port_t			 taskPort,
 		// stack. Very similar limitation that MiniDumpWriteDump on Windows has.
 		if (threadRefs[i].Get () != thisThreadRef.Get () || pCrashContext != nullptr) {
 			const uint64_t stackSegmentStart = stackStart - lengthInBytes;
-			memoryRangesToAdd.InsertAndMergeIfNeeded (stackSegmentStart, lengthInBytes);
+			if (crashingThread) {
+				// Stacks grow downwards, so keeping their start keeps the most recent frames
+				candidates.push_back ({ stackSegmentStart,
+										lengthInBytes,
+										MachOCore::MemoryRangePriority::CrashingThreadStack,
+										stackSegmentStart });
+			} else {
+				// The topmost pages (the most recent frames) of other threads are more valuable than the rest
+				const size_t TopOfStackSize = 16'384;
+				const size_t topLength		= std::min (lengthInBytes, TopOfStackSize);
+				candidates.push_back (
+					{ stackSegmentStart, topLength, MachOCore::MemoryRangePriority::TopOfStack, stackSegmentStart });
+				candidates.push_back ({ stackSegmentStart + topLength,
+										lengthInBytes - topLength,
+										MachOCore::MemoryRangePriority::Stack,
+										stackSegmentStart + topLength });
+			}
 		}
 	}
 
+	AdmitCandidateRanges (&candidates, &memoryRangesToAdd, pDroppedRangesOut);
+	if (!pDroppedRangesOut->empty ())
+		MMD_DEBUGLOG_LINE << pDroppedRangesOut->size () << " memory ranges were dropped because of the memory budget";
+
 	// Add all merged memory ranges to core
 	memoryRangesToAdd.ForEach ([&] (uint64_t start, size_t length) {
 		if (!AddSegmentCommandFromProcessMemory (taskPort, pCoreBuilder, start, length)) {
@@ -591,7 +760,26 @@ bool AddThreadsToCore (mach_port_t			 taskPort,
 	return true;
 }
 
-bool AddNotesToCore (MachOCoreDumpBuilder* pCoreBuilder)
+// Creates the payload of the "dropped ranges" LC_NOTE (see MachOCoreInternal.hpp)
+Vector<char> CreateDroppedRangesPayload (uint64_t									 memoryBudget,
+										 const Vector<MachOCore::DroppedRangeEntry>& droppedRanges)
+{
+	MachOCore::DroppedRangesHeader header;
+	header.entryCount	= static_cast<uint32_t> (droppedRanges.size ());
+	header.memoryBudget = memoryBudget;
+
+	const size_t entriesSize = droppedRanges.size () * sizeof (MachOCore::DroppedRangeEntry);
+	Vector<char> payload (sizeof header + entriesSize);
+	memcpy (payload.data (), &header, sizeof header);
+	if (entriesSize > 0)
+		memcpy (payload.data () + sizeof header, droppedRanges.data (), entriesSize);
+
+	return payload;
+}
+
+bool AddNotesToCore (MachOCoreDumpBuilder*						 pCoreBuilder,
+					 uint64_t									 memoryBudget,
+					 const Vector<MachOCore::DroppedRangeEntry>& droppedRanges)
 {
 	// Payloads for these will be added later
 	pCoreBuilder->AddNoteCommand (MachOCore::AddrableBitsOwner);
@@ -599,21 +787,63 @@ bool AddNotesToCore (MachOCoreDumpBuilder* pCoreBuilder)
 	pCoreBuilder->AddNoteCommand (MachOCore::MainBinSpecOwner);
 	pCoreBuilder->AddNoteCommand (MachOCore::ProcessMetadataOwner);
 
+	// With a memory budget, the core records what was left out (even if nothing was)
+	if (memoryBudget != 0) {
+		Vector<char> payload = CreateDroppedRangesPayload (memoryBudget, droppedRanges);
+		if (!pCoreBuilder->AddNoteCommand (
+				MachOCore::DroppedRangesOwner,
+				std::make_unique<DataProvider> (new CopiedDataPtr (payload.data (), payload.size ()), payload.size ())))
+			return false;
+	}
+
 	return true;
 }
 
-bool MiniDumpWriteDumpImpl (mach_port_t taskPort, IRandomAccessBinaryOStream* pOStream, CrashContext* pCrashContext)
+bool ApplyOptions (MachOCoreDumpBuilder* pCoreBuilder, const Options& options)
 {
-	assert (pOStream != nullptr);
+	if (options.segmentPageAlignment != 4'096 && options.segmentPageAlignment != 16'384 &&
+		options.segmentPageAlignment != 0)
+		return false;
+
+	const size_t chunkSize =
+		options.payloadChunkSize == 0 ? MachOCoreDumpBuilder::DefaultPayloadChunkSize : options.payloadChunkSize;
+	pCoreBuilder->SetPayloadPipelining (chunkSize, options.payloadPipelineDepth);
+	pCoreBuilder->SetParallelWriting (options.writerThreadCount);
+	pCoreBuilder->SetSegmentPageAlignment (options.segmentPageAlignment);
+	pCoreBuilder->SetSparseOutput (options.sparseOutput != 0);
+	pCoreBuilder->SetPageDeduplication (options.pageDeduplication != 0);
+	pCoreBuilder->SetChecksumming (options.checksum != 0);
+
+	return true;
+}
+
+void FillStatistics (const MachOCoreDumpBuilder&				 coreBuilder,
+					 const Vector<MachOCore::DroppedRangeEntry>& droppedRanges,
+					 Statistics*								 pStatistics)
+{
+	pStatistics->coreFileSize			  = coreBuilder.GetCoreFileSize ();
+	pStatistics->segmentCount			  = coreBuilder.GetNumberOfSegmentCommands ();
+	pStatistics->segmentAlignmentOverhead = coreBuilder.GetSegmentAlignmentOverhead ();
+	pStatistics->deduplicatedBytes		  = coreBuilder.GetDeduplicatedBytes ();
+	pStatistics->droppedRangeCount		  = droppedRanges.size ();
+	pStatistics->droppedBytes			  = 0;
+	for (const MachOCore::DroppedRangeEntry& entry : droppedRanges)
+		pStatistics->droppedBytes += entry.size;
+
+	// Only known once the core file has been written
+	pStatistics->crc32c = 0;
+}
 
+// Decides what to put inside the core file of the task, and lays it out. Then calls onPrepared with the builder, while
+// the task is still suspended
+template<typename OnPrepared>
+bool PrepareCore (mach_port_t taskPort, CrashContext* pCrashContext, const Options* pOptions, OnPrepared onPrepared)
+{
 	// Is the passed port valid, and of a task?
 	int pid;
 	if (pid_for_task (taskPort, &pid) != KERN_SUCCESS)
 		return false;
 
-	if (!pOStream->SetSize (0))
-		return false;
-
 	// We want to create a core dump of the process with consistent (memory) state.
 	// Because of this, if its of another process, we need to suspend the task
 	// For a self dump, we suspend all threads except the current one upfront (there is an unavoidable race condition,
@@ -648,16 +878,62 @@ bool MiniDumpWriteDumpImpl (mach_port_t taskPort, IRandomAccessBinaryOStream* pO
 	MachOCoreDumpBuilder coreBuilder;
 	ModuleList			 modules (taskPort);
 	Vector<uint64_t>	 threadIds;
-	if (!AddThreadsToCore (taskPort, &coreBuilder, &modules, &threadIds, pCrashContext))
+	if (pOptions != nullptr && !ApplyOptions (&coreBuilder, *pOptions))
 		return false;
 
-	if (!AddNotesToCore (&coreBuilder))
+	const uint64_t						 memoryBudget = pOptions != nullptr ? pOptions->memoryBudget : 0;
+	Vector<MachOCore::DroppedRangeEntry> droppedRanges;
+	if (!AddThreadsToCore (taskPort, &coreBuilder, &modules, &threadIds, memoryBudget, &droppedRanges, pCrashContext))
 		return false;
 
-	if (!AddPayloadsAndWrite (&coreBuilder, modules, threadIds, pOStream))
+	if (!AddNotesToCore (&coreBuilder, memoryBudget, droppedRanges))
 		return false;
 
-	return true;
+	if (!AddPayloads (&coreBuilder, modules, threadIds))
+		return false;
+
+	// The layout is final at this point
+	if (pOptions != nullptr && pOptions->pStatistics != nullptr)
+		FillStatistics (coreBuilder, droppedRanges, pOptions->pStatistics);
+
+	return onPrepared (&coreBuilder);
+}
+
+// OStream is either IRandomAccessBinaryOStream (payloads are written by seeking to them), or ISequentialBinaryOStream
+// (the core is written front to back, without seeking)
+template<typename OStream>
+bool MiniDumpWriteDumpImpl (mach_port_t	   taskPort,
+							OStream*	   pOStream,
+							CrashContext*  pCrashContext,
+							const Options* pOptions)
+{
+	static_assert (std::is_same_v<OStream, IRandomAccessBinaryOStream> ||
+				   std::is_same_v<OStream, ISequentialBinaryOStream>);
+
+	assert (pOStream != nullptr);
+
+	// Once everything is laid out, write out core dump content
+	return PrepareCore (taskPort, pCrashContext, pOptions, [&] (MachOCoreDumpBuilder* pCoreBuilder) {
+		bool succeeded;
+		if constexpr (std::is_same_v<OStream, IRandomAccessBinaryOStream>) {
+			if (!pOStream->SetSize (0))
+				return false;
+
+			// Running out of space is better detected before writing anything
+			const bool preallocate = pOptions != nullptr && pOptions->preallocate != 0;
+			if (preallocate && !pOStream->Preallocate (pCoreBuilder->GetCoreFileSize ()))
+				return false;
+
+			succeeded = pCoreBuilder->Build (pOStream);
+		} else {
+			succeeded = pCoreBuilder->BuildSequential (pOStream);
+		}
+
+		if (succeeded && pOptions != nullptr && pOptions->pStatistics != nullptr)
+			pOptions->pStatistics->crc32c = pCoreBuilder->GetCRC32C ();
+
+		return succeeded;
+	});
 }
 
 } // namespace
@@ -671,10 +947,46 @@ extern "C" int MiniDumpWriteDump (mach_port_t taskPort, int fd, struct MMDCrashC
 
 bool MiniDumpWriteDump (mach_port_t					taskPort,
 						IRandomAccessBinaryOStream* pOStream,
-						CrashContext*				pCrashContext /*= nullptr*/)
+						CrashContext*				pCrashContext /*= nullptr*/,
+						const Options*				pOptions /*= nullptr*/)
 {
 	try {
-		return MiniDumpWriteDumpImpl (taskPort, pOStream, pCrashContext);
+		return MiniDumpWriteDumpImpl (taskPort, pOStream, pCrashContext, pOptions);
+	} catch (const std::bad_alloc&) {
+		return false;
+	}
+}
+
+bool MiniDumpWriteDump (mach_port_t				  taskPort,
+						ISequentialBinaryOStream* pOStream,
+						CrashContext*			  pCrashContext /*= nullptr*/,
+						const Options*			  pOptions /*= nullptr*/)
+{
+	try {
+		return MiniDumpWriteDumpImpl (taskPort, pOStream, pCrashContext, pOptions);
+	} catch (const std::bad_alloc&) {
+		return false;
+	}
+}
+
+bool MiniDumpEstimateSize (mach_port_t	  taskPort,
+						   Statistics*	  pStatisticsOut,
+						   CrashContext*  pCrashContext /*= nullptr*/,
+						   const Options* pOptions /*= nullptr*/)
+{
+	assert (pStatisticsOut != nullptr);
+
+	// PrepareCore fills in the statistics once the layout is final
+	Options options		= pOptions != nullptr ? *pOptions : Options {};
+	options.pStatistics = pStatisticsOut;
+
+	try {
+		return PrepareCore (taskPort,
+							pCrashContext,
+							&options,
+							[] ([[maybe_unused]] MachOCoreDumpBuilder* pCoreBuilder) {
+								return true;
+							});
 	} catch (const std::bad_alloc&) {
 		return false;
 	}
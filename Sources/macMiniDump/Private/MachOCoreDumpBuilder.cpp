@@ -1,10 +1,17 @@
 #include "MachOCoreDumpBuilder.hpp"
 
+#include <algorithm>
 #include <cassert>
 #include <cmath>
 #include <iostream>
 
+#include "ChunkPipeline.hpp"
 #include "Logging.hpp"
+#include "MMD/ChecksumOStream.hpp"
+#include "MachOCoreInternal.hpp"
+#include "PageDeduplicator.hpp"
+#include "ParallelPayloadWriter.hpp"
+#include "SparseOutput.hpp"
 
 namespace MMD {
 namespace {
@@ -17,9 +24,29 @@ size_t RoundUp (size_t number, size_t roundTo)
 	return remainder == 0 ? number : (quotient + 1) * roundTo;
 }
 
+const char Zeroes[4'096] = {};
+
+// Deduplication works on whole pages of at least this size (every piece costs a 72-byte segment command)
+constexpr size_t MinDeduplicationPageSize = 4'096;
+
 } // namespace
 
-MachOCoreDumpBuilder::MachOCoreDumpBuilder (): m_loadCommandsFinalized (false)
+MachOCoreDumpBuilder::MachOCoreDumpBuilder ():
+	m_loadCommandsFinalized (false),
+	m_oStreamPosition (0),
+	m_payloadChunkSize (DefaultPayloadChunkSize),
+	m_payloadPipelineDepth (1),
+	m_nWriterThreads (1),
+	m_segmentPageSize (0),
+	m_sparseOutput (false),
+	m_oStreamInitialSize (0),
+	m_deduplicatePages (false),
+	m_deduplicatedBytes (0),
+	m_checksumming (false),
+	m_checksumNoteIndex (0),
+	m_crc32c (0),
+	m_segmentAlignmentOverhead (0),
+	m_coreFileSize (0)
 {
 	m_header.magic = MH_MAGIC_64;
 	m_header.cputype =
@@ -44,87 +71,142 @@ MachOCoreDumpBuilder::MachOCoreDumpBuilder (): m_loadCommandsFinalized (false)
 
 bool MachOCoreDumpBuilder::Build (IRandomAccessBinaryOStream* pOStream)
 {
-#ifdef _DEBUG
-	m_writtenRanges.clear ();
-#endif
-
 	FinalizeLoadCommands ();
 
-	// Write out the header
-	if (!WriteToOStream (m_header, pOStream))
+	if (!m_checksumming)
+		return WriteCore (pOStream);
+
+	// Everything but the digest itself is written through the checksumming stream
+	ChecksumOStream checksumOStream (pOStream);
+	if (!WriteCore (&checksumOStream))
 		return false;
 
-	// Update payload offsets, then write out load commands
-	for (auto& nc : m_note_cmds) {
-		GetOffsetForNoteCommandPayload (nc.first.data_owner, &nc.first.offset);
+	MachOCore::ChecksumInfo checksumInfo;
+	checksumInfo.checksummedSize = m_notePayloadOffsets[m_checksumNoteIndex];
+	if (!checksumOStream.GetCRC32C (checksumInfo.checksummedSize, &checksumInfo.crc32c)) {
+		MMD_DEBUGLOG_LINE << "Failed to calculate the checksum of the core file";
 
-		if (!WriteToOStream (nc.first, pOStream))
-			return false;
+		return false;
 	}
 
-	// Thread commands are self-contained (no payload)
-	for (const auto& pTc : m_thread_cmds) {
-		if (!WriteToOStream (pTc.get (), pTc->cmdsize, pOStream))
-			return false;
-	}
+	if (!pOStream->WriteAt (&checksumInfo, sizeof checksumInfo, checksumInfo.checksummedSize))
+		return false;
 
-	for (auto& sc : m_segment_cmds) {
-		GetOffsetForSegmentCommandPayload (sc.first.vmaddr, &sc.first.fileoff);
+	m_crc32c = checksumInfo.crc32c;
 
-		if (!WriteToOStream (sc.first, pOStream))
-			return false;
-	}
+	return true;
+}
+
+bool MachOCoreDumpBuilder::BuildSequential (ISequentialBinaryOStream* pOStream)
+{
+	FinalizeLoadCommands ();
 
-	// Time for writing out payloads
-	for (const auto& nc : m_note_cmds) {
-		uint64_t offset;
-		GetOffsetForNoteCommandPayload (nc.first.data_owner, &offset);
-		pOStream->SetPosition (offset);
+	if (!m_checksumming)
+		return WriteCoreSequential (pOStream);
 
-		if (!WriteToOStream (nc.second->GetDataPtr ()->Get (), nc.first.size, pOStream))
-			return false;
-	}
+	SequentialChecksumOStream checksumOStream (pOStream);
+	if (!WriteCoreSequential (&checksumOStream))
+		return false;
 
-	for (const auto& sc : m_segment_cmds) {
-		assert (sc.second->GetSize () == sc.first.filesize);
-
-		uint64_t startOffset;
-		GetOffsetForSegmentCommandPayload (sc.first.vmaddr, &startOffset);
-		pOStream->SetPosition (startOffset);
-
-		// Some segments might be huge, so we might need to write them out in chunks
-		const size_t MaxChunkSize	= 4'096 * 1'024;
-		const size_t dataSize		= sc.second->GetSize ();
-		const size_t chunkSize		= std::min (dataSize, MaxChunkSize);
-		const size_t nLeftOverBytes = dataSize % chunkSize;
-		const size_t iters			= dataSize / chunkSize;
-
-		size_t offset = 0;
-		for (size_t i = 0; i < iters; ++i) {
-			const char* data = sc.second->GetDataPtr ()->Get (offset, chunkSize);
-
-			if (data == nullptr) {
-				MMD_DEBUGLOG_LINE << "Failed to read data for segment "
-								  << std::string (sc.first.segname, sizeof (sc.first.segname)) << " at address 0x"
-								  << std::hex << sc.first.vmaddr << std::dec;
-				break;
-			}
+	// Padding before the digest (if any) is part of the checksummed range
+	MachOCore::ChecksumInfo checksumInfo;
+	checksumInfo.checksummedSize = m_notePayloadOffsets[m_checksumNoteIndex];
+	if (!PadOStreamTo (checksumInfo.checksummedSize, &checksumOStream))
+		return false;
 
-			if (!WriteToOStream (data, chunkSize, pOStream))
-				return false;
+	checksumInfo.crc32c = checksumOStream.GetCRC32C ();
+	if (!WriteToOStream (checksumInfo, pOStream))
+		return false;
 
-			offset += chunkSize;
-		}
+	m_crc32c = checksumInfo.crc32c;
 
-		if (nLeftOverBytes >= 0) {
-			if (!WriteToOStream (sc.second->GetDataPtr ()->Get (offset, nLeftOverBytes), nLeftOverBytes, pOStream))
-				return false;
-		}
+	return true;
+}
+
+bool MachOCoreDumpBuilder::WriteCore (IRandomAccessBinaryOStream* pOStream)
+{
+#ifdef _DEBUG
+	m_writtenRanges.clear ();
+#endif
+	SetOStreamPosition (0, pOStream);
+	m_oStreamInitialSize = pOStream->GetSize ();
+
+	if (!WriteHeaderLoadCommandsAndNotePayloads (pOStream))
+		return false;
+
+	// Time for writing out segment payloads
+	if (m_nWriterThreads > 1 && pOStream->SupportsConcurrentWriteAt ()) {
+		if (!WriteSegmentPayloadsInParallel (pOStream))
+			return false;
+	} else {
+		if (!WriteSegmentPayloads (pOStream, pOStream))
+			return false;
 	}
 
+	// If the last page(s) have been skipped, the stream needs to be extended
+	if (m_sparseOutput && pOStream->GetSize () < m_coreFileSize)
+		return pOStream->SetSize (m_coreFileSize);
+
 	return true;
 }
 
+bool MachOCoreDumpBuilder::WriteCoreSequential (ISequentialBinaryOStream* pOStream)
+{
+#ifdef _DEBUG
+	m_writtenRanges.clear ();
+#endif
+	m_oStreamPosition = 0;
+
+	if (!WriteHeaderLoadCommandsAndNotePayloads (pOStream))
+		return false;
+
+	// Segment payloads are laid out in the order of their load commands, so the only thing we have to take care of is
+	// writing out padding instead of seeking over it
+	return WriteSegmentPayloads (pOStream, nullptr);
+}
+
+void MachOCoreDumpBuilder::SetPayloadPipelining (size_t chunkSize, size_t pipelineDepth)
+{
+	assert (chunkSize > 0);
+
+	m_payloadChunkSize	   = chunkSize;
+	m_payloadPipelineDepth = pipelineDepth;
+}
+
+void MachOCoreDumpBuilder::SetParallelWriting (size_t nWriterThreads)
+{
+	m_nWriterThreads = nWriterThreads;
+}
+
+void MachOCoreDumpBuilder::SetSparseOutput (bool sparseOutput)
+{
+	m_sparseOutput = sparseOutput;
+}
+
+void MachOCoreDumpBuilder::SetPageDeduplication (bool deduplicatePages)
+{
+	assert (!m_loadCommandsFinalized);
+
+	m_deduplicatePages = deduplicatePages;
+}
+
+void MachOCoreDumpBuilder::SetChecksumming (bool checksumming)
+{
+	assert (!m_loadCommandsFinalized);
+
+	m_checksumming = checksumming;
+}
+
+void MachOCoreDumpBuilder::SetSegmentPageAlignment (size_t pageSize)
+{
+	assert ((pageSize & (pageSize - 1)) == 0);
+
+	m_segmentPageSize = pageSize;
+
+	if (m_loadCommandsFinalized)
+		LayOutPayloads ();
+}
+
 void MachOCoreDumpBuilder::FinalizeLoadCommands ()
 {
 	// It's legal to call this function multiple times (further modification of load commands is guarded against
@@ -132,6 +214,18 @@ void MachOCoreDumpBuilder::FinalizeLoadCommands ()
 	if (m_loadCommandsFinalized)
 		return;
 
+	// Deduplication might split segment commands, so it has to come first
+	if (m_deduplicatePages)
+		DeduplicatePages ();
+
+	// The size of the digest is fixed, its payload is written by Build or BuildSequential
+	if (m_checksumming) {
+		AddNoteCommand (MachOCore::ChecksumOwner);
+
+		m_checksumNoteIndex			   = m_note_cmds.size () - 1;
+		m_note_cmds.back ().first.size = sizeof (MachOCore::ChecksumInfo);
+	}
+
 	// Update some fields of the header
 
 	m_header.ncmds	  = m_note_cmds.size () + m_thread_cmds.size () + m_segment_cmds.size ();
@@ -146,6 +240,8 @@ void MachOCoreDumpBuilder::FinalizeLoadCommands ()
 	m_header.sizeofcmds = sizeOfCmds;
 
 	m_loadCommandsFinalized = true;
+
+	LayOutPayloads ();
 }
 
 bool MachOCoreDumpBuilder::AddNoteCommand (const char* pOwner, std::unique_ptr<IDataProvider> dataProvider)
@@ -214,6 +310,11 @@ bool MachOCoreDumpBuilder::AddDataProviderForNoteCommand (const char*					 pOwne
 			ncPair.second	  = std::move (pDataProvider);
 			ncPair.first.size = ncPair.second->GetSize ();
 
+			// Payloads of notes might be added after finalization (e.g. when their content depends on offsets), in
+			// which case every payload after this one is shifted
+			if (m_loadCommandsFinalized)
+				LayOutPayloads ();
+
 			return true;
 		}
 	}
@@ -226,19 +327,12 @@ bool MachOCoreDumpBuilder::GetOffsetForNoteCommandPayload (const char* pOwnerNam
 	if (!m_loadCommandsFinalized)
 		return false;
 
-	const size_t payloadStartOffset = sizeof m_header + m_header.sizeofcmds;
-	// The very first payload will be aligned to a 16-byte boundary
-	size_t payloadOffset = RoundUp (payloadStartOffset, 16);
-
-	for (const auto& nc : m_note_cmds) {
-		if (strcmp (pOwnerName, nc.first.data_owner) == 0) {
-			*pOffsetOut = payloadOffset;
+	// There is only a handful of note commands, so a linear search is fine here
+	for (size_t i = 0; i < m_note_cmds.size (); ++i) {
+		if (strncmp (pOwnerName, m_note_cmds[i].first.data_owner, sizeof m_note_cmds[i].first.data_owner) == 0) {
+			*pOffsetOut = m_notePayloadOffsets[i];
 
 			return true;
-		} else {
-			assert (nc.second != nullptr); // Sizes of all previous note commands must be known
-
-			payloadOffset += nc.first.size;
 		}
 	}
 
@@ -246,52 +340,466 @@ bool MachOCoreDumpBuilder::GetOffsetForNoteCommandPayload (const char* pOwnerNam
 	return false;
 }
 
-bool MachOCoreDumpBuilder::GetOffsetForSegmentCommandPayload (uintptr_t vmaddr, uint64_t* pOffsetOut) const
+bool MachOCoreDumpBuilder::GetOffsetForSegmentCommandPayload (size_t segmentIndex, uint64_t* pOffsetOut) const
 {
-	if (!m_loadCommandsFinalized)
+	if (!m_loadCommandsFinalized || segmentIndex >= m_segmentPayloadOffsets.size ())
 		return false;
 
-	const note_command* pLastNoteCmd				 = &m_note_cmds.back ().first;
-	uint64_t			lastNoteCommandPayloadOffset = 0;
-	GetOffsetForNoteCommandPayload (pLastNoteCmd->data_owner, &lastNoteCommandPayloadOffset);
+	*pOffsetOut = m_segmentPayloadOffsets[segmentIndex];
+
+	return true;
+}
+
+size_t MachOCoreDumpBuilder::GetNumberOfSegmentCommands () const
+{
+	return m_segment_cmds.size ();
+}
+
+uint64_t MachOCoreDumpBuilder::GetSegmentAlignmentOverhead () const
+{
+	assert (m_loadCommandsFinalized);
+
+	return m_segmentAlignmentOverhead;
+}
+
+uint64_t MachOCoreDumpBuilder::GetCoreFileSize () const
+{
+	assert (m_loadCommandsFinalized);
+
+	return m_coreFileSize;
+}
+
+uint64_t MachOCoreDumpBuilder::GetDeduplicatedBytes () const
+{
+	assert (m_loadCommandsFinalized);
+
+	return m_deduplicatedBytes;
+}
+
+uint32_t MachOCoreDumpBuilder::GetCRC32C () const
+{
+	return m_crc32c;
+}
+
+segment_command_64* MachOCoreDumpBuilder::GetSegmentCommand (size_t index)
+{
+	return &m_segment_cmds[index].first;
+}
+
+void MachOCoreDumpBuilder::LayOutPayloads ()
+{
+	assert (m_loadCommandsFinalized);
+
+	// Assign the file offset of every payload in a single pass, so later queries don't have to walk all previous load
+	// commands. Payloads of notes are laid out first, then the payloads of segments, then the checksum (if any):
+	//   [header][load commands][pad to 16][note payloads...][pad to 4K][segment payloads...][checksum]
+	m_notePayloadOffsets.resize (m_note_cmds.size ());
+	m_segmentPayloadOffsets.resize (m_segment_cmds.size ());
+
+	const size_t payloadStartOffset = sizeof m_header + m_header.sizeofcmds;
+	// The very first payload will be aligned to a 16-byte boundary
+	uint64_t payloadOffset = RoundUp (payloadStartOffset, 16);
+	for (size_t i = 0; i < m_note_cmds.size (); ++i) {
+		if (IsChecksumNote (i))
+			continue;
+
+		m_notePayloadOffsets[i] = payloadOffset;
+
+		// Sizes of notes without a payload are not known yet; offsets after them will be updated once they are added
+		payloadOffset += m_note_cmds[i].first.size;
+	}
+
+	m_coreFileSize = payloadOffset;
 
 	// The first segment payload should be written to a 4K boundary
-	uint64_t payloadOffset = RoundUp (lastNoteCommandPayloadOffset + pLastNoteCmd->size, 0x1000);
-	for (const auto& sc : m_segment_cmds) {
-		if (vmaddr == sc.first.vmaddr) {
-			*pOffsetOut = payloadOffset;
+	payloadOffset			   = RoundUp (payloadOffset, 0x1000);
+	m_segmentAlignmentOverhead = 0;
+	for (size_t i = 0; i < m_segment_cmds.size (); ++i) {
+		const segment_command_64& command = m_segment_cmds[i].first;
 
-			return true;
-		} else {
-			assert (sc.second != nullptr); // Sizes of all previous segment commands must be known
+		// Shared payloads are written once, as part of the payload of a preceding segment
+		const auto sharedPayloadIt = m_sharedPayloads.find (i);
+		if (sharedPayloadIt != m_sharedPayloads.end ()) {
+			const SharedPayload& sharedPayload = sharedPayloadIt->second;
+			assert (sharedPayload.segmentIndex < i);
+
+			m_segmentPayloadOffsets[i] = m_segmentPayloadOffsets[sharedPayload.segmentIndex] + sharedPayload.offset;
 
-			payloadOffset += sc.first.filesize;
+			continue;
 		}
+
+		// With page alignment, the payload is moved forward until its offset within the page matches the one of its
+		// address, so readers can map it directly from the file. The gap is padding (or a hole) in the file.
+		if (m_segmentPageSize != 0) {
+			const uint64_t padding = (command.vmaddr - payloadOffset) & (m_segmentPageSize - 1);
+
+			payloadOffset += padding;
+			m_segmentAlignmentOverhead += padding;
+		}
+
+		m_segmentPayloadOffsets[i] = payloadOffset;
+
+		payloadOffset += command.filesize;
+		m_coreFileSize = payloadOffset;
 	}
 
-	// Segment command not found
-	return false;
+	if (m_checksumming) {
+		m_notePayloadOffsets[m_checksumNoteIndex] = m_coreFileSize;
+		m_coreFileSize += m_note_cmds[m_checksumNoteIndex].first.size;
+	}
 }
 
-size_t MachOCoreDumpBuilder::GetNumberOfSegmentCommands () const
+void MachOCoreDumpBuilder::DeduplicatePages ()
 {
-	return m_segment_cmds.size ();
+	assert (!m_loadCommandsFinalized);
+
+	// With page alignment, deduplicated pieces have to be aligned the same way in the file as in memory, so pages
+	// can't be smaller than the alignment
+	const size_t pageSize = std::max (MinDeduplicationPageSize, m_segmentPageSize);
+
+	Vector<PageDeduplicator::Source> sources;
+	sources.reserve (m_segment_cmds.size ());
+	for (const auto& [command, pDataProvider] : m_segment_cmds)
+		sources.push_back ({ pDataProvider.get (), command.vmaddr });
+
+	PageDeduplicator deduplicator (std::move (sources), pageSize);
+	deduplicator.Run ();
+
+	m_deduplicatedBytes = deduplicator.GetDuplicateBytes ();
+	if (m_deduplicatedBytes == 0)
+		return;
+
+	// Replace segment commands with their pieces. Pieces refer to data of preceding segments only, so the new index
+	// of the piece containing it is always known by the time it's needed.
+	LoadCommandsWithLazyData<segment_command_64> segmentCommands;
+	Vector<size_t>								 firstPieceIndices (m_segment_cmds.size ());
+
+	for (size_t i = 0; i < m_segment_cmds.size (); ++i) {
+		auto& [command, pDataProvider]				  = m_segment_cmds[i];
+		const Vector<PageDeduplicator::Piece>& pieces = deduplicator.GetPieces (i);
+
+		firstPieceIndices[i] = segmentCommands.size ();
+
+		if (pieces.size () == 1 && !pieces[0].isDuplicate) {
+			segmentCommands.push_back (std::move (m_segment_cmds[i]));
+
+			continue;
+		}
+
+		IDataProvider* pOriginalDataProvider = pDataProvider.get ();
+		m_splitDataProviders.push_back (std::move (pDataProvider));
+
+		for (const PageDeduplicator::Piece& piece : pieces) {
+			segment_command_64 pieceCommand = command;
+			pieceCommand.vmaddr += piece.offset;
+			pieceCommand.vmsize	  = piece.size;
+			pieceCommand.filesize = piece.size;
+
+			std::unique_ptr<IDataProvider> pPieceDataProvider;
+			if (piece.isDuplicate) {
+				const size_t source = piece.originalSourceIndex;
+
+				uint64_t	 offsetInPiece;
+				const size_t pieceIndex = deduplicator.FindPiece (source, piece.originalOffset, &offsetInPiece);
+
+				const SharedPayload sharedPayload = { firstPieceIndices[source] + pieceIndex, offsetInPiece };
+				m_sharedPayloads.emplace (segmentCommands.size (), sharedPayload);
+			} else {
+				pPieceDataProvider =
+					std::make_unique<DataProviderSlice> (pOriginalDataProvider, piece.offset, piece.size);
+			}
+
+			segmentCommands.emplace_back (pieceCommand, std::move (pPieceDataProvider));
+		}
+	}
+
+	m_segment_cmds = std::move (segmentCommands);
 }
 
-segment_command_64* MachOCoreDumpBuilder::GetSegmentCommand (size_t index)
+bool MachOCoreDumpBuilder::HasOwnPayload (size_t segmentIndex) const
 {
-	return &m_segment_cmds[index].first;
+	return m_segment_cmds[segmentIndex].second != nullptr;
 }
 
-bool MachOCoreDumpBuilder::WriteToOStream (const void* pData, size_t size, IRandomAccessBinaryOStream* pOStream)
+bool MachOCoreDumpBuilder::IsChecksumNote (size_t noteIndex) const
 {
-	assert (!(pData == NULL && size > 0));
+	return m_checksumming && noteIndex == m_checksumNoteIndex;
+}
+
+bool MachOCoreDumpBuilder::WriteHeaderLoadCommandsAndNotePayloads (ISequentialBinaryOStream* pOStream)
+{
+	assert (m_loadCommandsFinalized);
+	assert (m_oStreamPosition == 0);
+
+	// The header and all load commands are serialized into one contiguous image (instead of writing them out one by
+	// one, which would result in a huge number of tiny writes)
+	Vector<char> image (sizeof m_header + m_header.sizeofcmds);
+	char*		 pImageCurr = image.data ();
+	auto		 append		= [&pImageCurr] (const void* pData, size_t size) {
+		  memcpy (pImageCurr, pData, size);
+		  pImageCurr += size;
+	};
+
+	append (&m_header, sizeof m_header);
+
+	// Update payload offsets while serializing load commands
+	for (size_t i = 0; i < m_note_cmds.size (); ++i) {
+		auto& nc		= m_note_cmds[i];
+		nc.first.offset = m_notePayloadOffsets[i];
+
+		append (&nc.first, sizeof nc.first);
+	}
+
+	// Thread commands are self-contained (no payload)
+	for (const auto& pTc : m_thread_cmds)
+		append (pTc.get (), pTc->cmdsize);
+
+	for (size_t i = 0; i < m_segment_cmds.size (); ++i) {
+		auto& sc		 = m_segment_cmds[i];
+		sc.first.fileoff = m_segmentPayloadOffsets[i];
+
+		append (&sc.first, sizeof sc.first);
+	}
+
+	assert (pImageCurr == image.data () + image.size ());
+
+	// Note payloads are small, and directly follow the load commands, so they (and the padding before them) are written
+	// out together with the image in one go
+	Vector<iovec> iovecs;
+	iovecs.reserve (1 + 2 * m_note_cmds.size ());
+	iovecs.push_back ({ image.data (), image.size () });
+
+	size_t position = image.size ();
+	for (size_t i = 0; i < m_note_cmds.size (); ++i) {
+		if (IsChecksumNote (i))
+			continue;
+
+		const auto& nc = m_note_cmds[i];
+		assert (m_notePayloadOffsets[i] >= position && m_notePayloadOffsets[i] - position <= sizeof Zeroes);
+
+		if (m_notePayloadOffsets[i] > position)
+			iovecs.push_back ({ const_cast<char*> (Zeroes), m_notePayloadOffsets[i] - position });
+
+		iovecs.push_back ({ const_cast<char*> (nc.second->GetDataPtr ()->Get ()), nc.first.size });
+		position = m_notePayloadOffsets[i] + nc.first.size;
+	}
+
+	return WriteToOStream (iovecs.data (), iovecs.size (), pOStream);
+}
+
+bool MachOCoreDumpBuilder::WriteSegmentPayloads (ISequentialBinaryOStream*	pOStream,
+												 IRandomAccessBinaryOStream* pSeekableOStream)
+{
+	if (m_payloadPipelineDepth > 1) {
+		Vector<IDataProvider*> sources;
+		Vector<size_t>		   segmentIndices;
+		for (size_t i = 0; i < m_segment_cmds.size (); ++i) {
+			if (HasOwnPayload (i)) {
+				sources.push_back (m_segment_cmds[i].second.get ());
+				segmentIndices.push_back (i);
+			}
+		}
+
+		ChunkPipeline pipeline (std::move (sources), m_payloadChunkSize, m_payloadPipelineDepth);
+		if (pipeline.Start ())
+			return WriteSegmentPayloadsPipelined (&pipeline, segmentIndices, pOStream, pSeekableOStream);
+
+		MMD_DEBUGLOG_LINE << "Failed to start payload pipeline, falling back to serial writing";
+	}
+
+	for (size_t i = 0; i < m_segment_cmds.size (); ++i) {
+		if (!HasOwnPayload (i))
+			continue;
+
+		if (!MoveOStreamTo (m_segmentPayloadOffsets[i], pOStream, pSeekableOStream))
+			return false;
+
+		if (!WriteSegmentPayload (i, pOStream, pSeekableOStream))
+			return false;
+	}
+
+	return true;
+}
+
+bool MachOCoreDumpBuilder::WriteSegmentPayloadsPipelined (ChunkPipeline*				pPipeline,
+														  const Vector<size_t>&			segmentIndices,
+														  ISequentialBinaryOStream*		pOStream,
+														  IRandomAccessBinaryOStream*	pSeekableOStream)
+{
+	// Memory is read ahead on the producer thread of the pipeline, while we are writing out previously read chunks
+	const ChunkPipeline::Chunk* pChunk = nullptr;
+	while ((pChunk = pPipeline->Next ()) != nullptr) {
+		const size_t segmentIndex = segmentIndices[pChunk->sourceIndex];
+
+		bool succeeded = true;
+		if (pChunk->offset == 0)
+			succeeded = MoveOStreamTo (m_segmentPayloadOffsets[segmentIndex], pOStream, pSeekableOStream);
+
+		if (succeeded) {
+			const char* pData = pChunk->valid ? pChunk->pData : nullptr;
+			succeeded		  = WriteSegmentChunk (segmentIndex, pData, pChunk->size, pOStream, pSeekableOStream);
+		}
+
+		pPipeline->Release ();
+
+		if (!succeeded)
+			return false;
+	}
+
+	return true;
+}
+
+bool MachOCoreDumpBuilder::WriteSegmentPayloadsInParallel (IRandomAccessBinaryOStream* pOStream)
+{
+	// Every payload offset is known at this point, so segments can be written independently of each other
+	Vector<ParallelPayloadWriter::Job> jobs;
+	jobs.reserve (m_segment_cmds.size ());
+
+	uint64_t gapStart = m_oStreamPosition;
+	for (size_t i = 0; i < m_segment_cmds.size (); ++i) {
+		if (!HasOwnPayload (i))
+			continue;
+
+		const auto& [command, pDataProvider] = m_segment_cmds[i];
+		assert (pDataProvider->GetSize () == command.filesize);
+
+		// Gaps are not written, but the stream might have had content there already
+		if (!ZeroOStreamRange (pOStream, gapStart, m_segmentPayloadOffsets[i] - gapStart, m_oStreamInitialSize))
+			return false;
+
+		gapStart = m_segmentPayloadOffsets[i] + command.filesize;
 
-	// Debug feature: Let's check if we would overwrite parts or not
 #ifdef _DEBUG
-	size_t start = pOStream->GetPosition ();
-	size_t end	 = start + size;
+		if (!TrackWrittenRange (m_segmentPayloadOffsets[i], m_segmentPayloadOffsets[i] + command.filesize))
+			return false;
+#endif
+
+		jobs.push_back ({ pDataProvider.get (), m_segmentPayloadOffsets[i] });
+	}
+
+	ParallelPayloadWriter writer (std::move (jobs), m_nWriterThreads, m_payloadChunkSize);
+	if (m_sparseOutput)
+		writer.SetSparseOutput (m_oStreamInitialSize);
+
+	return writer.Write (pOStream);
+}
+
+bool MachOCoreDumpBuilder::WriteSegmentPayload (size_t						index,
+												ISequentialBinaryOStream*	pOStream,
+												IRandomAccessBinaryOStream* pSeekableOStream)
+{
+	const auto& sc = m_segment_cmds[index];
+	assert (sc.second->GetSize () == sc.first.filesize);
+	assert (m_oStreamPosition == m_segmentPayloadOffsets[index]);
+
+	// Some segments might be huge, so we might need to write them out in chunks
+	const size_t dataSize = sc.second->GetSize ();
+
+	size_t offset = 0;
+	while (offset < dataSize) {
+		const size_t chunkSize = std::min (dataSize - offset, m_payloadChunkSize);
+		IDataPtr*	 pDataPtr  = sc.second->GetDataPtr ();
+		const char*	 data	   = pDataPtr == nullptr ? nullptr : pDataPtr->Get (offset, chunkSize);
+
+		if (!WriteSegmentChunk (index, data, chunkSize, pOStream, pSeekableOStream))
+			return false;
+
+		offset += chunkSize;
+	}
 
+	return true;
+}
+
+bool MachOCoreDumpBuilder::WriteSegmentChunk (size_t						  index,
+											  const char*				  pData,
+											  size_t					  size,
+											  ISequentialBinaryOStream*	  pOStream,
+											  IRandomAccessBinaryOStream* pSeekableOStream)
+{
+	const bool sparse = m_sparseOutput && pSeekableOStream != nullptr;
+
+	if (pData == nullptr) {
+		const auto& sc = m_segment_cmds[index];
+		MMD_DEBUGLOG_LINE << "Failed to read data for segment "
+						  << std::string (sc.first.segname, sizeof (sc.first.segname)) << " at address 0x"
+						  << std::hex << sc.first.vmaddr << std::dec;
+
+		// The size of the payload is already part of the layout, so the missing data is filled with zeroes
+		if (sparse)
+			return SkipZeroesInOStream (size, pSeekableOStream);
+
+		return PadOStreamTo (m_oStreamPosition + size, pOStream);
+	}
+
+	if (sparse)
+		return WriteSparseChunk (pData, size, pSeekableOStream);
+
+	return WriteToOStream (pData, size, pOStream);
+}
+
+bool MachOCoreDumpBuilder::WriteSparseChunk (const char* pData, size_t size, IRandomAccessBinaryOStream* pOStream)
+{
+	return ForEachSparseRun (pData, size, m_oStreamPosition, [&] (size_t offset, size_t runSize, bool isZero) {
+		if (isZero)
+			return SkipZeroesInOStream (runSize, pOStream);
+
+		return WriteToOStream (pData + offset, runSize, pOStream);
+	});
+}
+
+bool MachOCoreDumpBuilder::SkipZeroesInOStream (size_t size, IRandomAccessBinaryOStream* pOStream)
+{
+	const size_t start = m_oStreamPosition;
+	if (!ZeroOStreamRange (pOStream, start, size, m_oStreamInitialSize))
+		return false;
+
+	// ZeroOStreamRange might have written (and moved the stream), or not
+	SetOStreamPosition (start + size, pOStream);
+
+	return true;
+}
+
+bool MachOCoreDumpBuilder::MoveOStreamTo (size_t					  newPos,
+										  ISequentialBinaryOStream*	  pOStream,
+										  IRandomAccessBinaryOStream* pSeekableOStream)
+{
+	if (pSeekableOStream != nullptr) {
+		// Gaps are not written, but the stream might have had content there already
+		if (newPos > m_oStreamPosition) {
+			const size_t gapStart = m_oStreamPosition;
+			if (!ZeroOStreamRange (pSeekableOStream, gapStart, newPos - gapStart, m_oStreamInitialSize))
+				return false;
+		}
+
+		SetOStreamPosition (newPos, pSeekableOStream);
+
+		return true;
+	}
+
+	return PadOStreamTo (newPos, pOStream);
+}
+
+bool MachOCoreDumpBuilder::PadOStreamTo (size_t newPos, ISequentialBinaryOStream* pOStream)
+{
+	assert (newPos >= m_oStreamPosition);
+
+	while (m_oStreamPosition < newPos) {
+		if (!WriteToOStream (Zeroes, std::min (newPos - m_oStreamPosition, sizeof Zeroes), pOStream))
+			return false;
+	}
+
+	return true;
+}
+
+void MachOCoreDumpBuilder::SetOStreamPosition (size_t newPos, IRandomAccessBinaryOStream* pOStream)
+{
+	pOStream->SetPosition (newPos);
+	m_oStreamPosition = newPos;
+}
+
+#ifdef _DEBUG
+bool MachOCoreDumpBuilder::TrackWrittenRange (size_t start, size_t end)
+{
 	// Poor man's interval search...
 	for (const auto& interval : m_writtenRanges) {
 		if ((start < interval.second && start > interval.first) || (end > interval.first && end < interval.second)) {
@@ -302,9 +810,50 @@ bool MachOCoreDumpBuilder::WriteToOStream (const void* pData, size_t size, IRand
 	}
 
 	m_writtenRanges.push_back ({ start, end });
+
+	return true;
+}
 #endif // _DEBUG
 
-	return pOStream->Write (pData, size);
+bool MachOCoreDumpBuilder::WriteToOStream (const void* pData, size_t size, ISequentialBinaryOStream* pOStream)
+{
+	assert (!(pData == NULL && size > 0));
+
+	// Debug feature: Let's check if we would overwrite parts or not
+#ifdef _DEBUG
+	if (!TrackWrittenRange (m_oStreamPosition, m_oStreamPosition + size))
+		return false;
+#endif // _DEBUG
+
+	if (!pOStream->Write (pData, size))
+		return false;
+
+	m_oStreamPosition += size;
+
+	return true;
+}
+
+bool MachOCoreDumpBuilder::WriteToOStream (const iovec* pIOVecs, size_t count, ISequentialBinaryOStream* pOStream)
+{
+	size_t size = 0;
+	for (size_t i = 0; i < count; ++i) {
+		assert (!(pIOVecs[i].iov_base == NULL && pIOVecs[i].iov_len > 0));
+
+		size += pIOVecs[i].iov_len;
+	}
+
+	// Debug feature: Let's check if we would overwrite parts or not
+#ifdef _DEBUG
+	if (!TrackWrittenRange (m_oStreamPosition, m_oStreamPosition + size))
+		return false;
+#endif // _DEBUG
+
+	if (!pOStream->WriteV (pIOVecs, count))
+		return false;
+
+	m_oStreamPosition += size;
+
+	return true;
 }
 
 } // namespace MMD
@@ -4,6 +4,7 @@
 #pragma once
 
 #include <mach-o/loader.h>
+#include <sys/uio.h>
 
 #include <utility>
 
@@ -13,13 +14,40 @@
 
 namespace MMD {
 
+class ChunkPipeline;
+
 // Class for constructing and writing out a Mach-O core dump
 // By using this class, only structural correctness is guaranteed, semantical is not
 class MachOCoreDumpBuilder {
 public:
+	static constexpr size_t DefaultPayloadChunkSize = 4'096 * 1'024;
+
 	MachOCoreDumpBuilder ();
 
+	// Writes out the header and load commands, then seeks to the offset of every payload to write it
 	bool Build (IRandomAccessBinaryOStream* pOStream);
+	// Writes out everything (padding included) in strictly increasing offset order, without ever seeking
+	bool BuildSequential (ISequentialBinaryOStream* pOStream);
+
+	// Segment payloads are read and written in chunks of chunkSize bytes. If pipelineDepth is greater than 1, chunks
+	// are read on a separate thread, while previously read ones are being written (at most pipelineDepth at once)
+	void SetPayloadPipelining (size_t chunkSize, size_t pipelineDepth);
+	// If nWriterThreads is greater than 1, Build writes segment payloads on this many threads in parallel, using
+	// positional writes (only if the stream supports concurrent positional writes; takes precedence over pipelining)
+	void SetParallelWriting (size_t nWriterThreads);
+	// If pageSize (a power of two) is not zero, every segment payload is placed at a file offset that has the same
+	// offset within a page of this size as the address of the segment. Zero means payloads are packed back to back.
+	void SetSegmentPageAlignment (size_t pageSize);
+	// If true, Build skips whole pages of zeroes in segment payloads instead of writing them, leaving holes on file
+	// systems supporting sparse files (the contents of the stream stay the same). BuildSequential is not affected.
+	void SetSparseOutput (bool sparseOutput);
+	// If true, FinalizeLoadCommands looks for pages of segments with identical content. Segments are split around
+	// runs of such pages, and the resulting segment commands refer to the file range of the first occurrence.
+	void SetPageDeduplication (bool deduplicatePages);
+	// If true, FinalizeLoadCommands adds a "crc32c digest" note. Its payload is placed at the very end of the file, so
+	// it can hold the CRC-32C checksum of everything before it (see MachOCore::ChecksumInfo). The checksum is
+	// calculated while writing, which works with both Build and BuildSequential.
+	void SetChecksumming (bool checksumming);
 
 	void FinalizeLoadCommands ();
 
@@ -30,8 +58,18 @@ public:
 
 	bool AddDataProviderForNoteCommand (const char* pOwnerName, std::unique_ptr<IDataProvider> pDataProvider);
 
+	// Payload offsets are only available after FinalizeLoadCommands has been called; lookups are constant time
 	bool GetOffsetForNoteCommandPayload (const char* pOwnerName, uint64_t* pOffsetOut) const;
-	bool GetOffsetForSegmentCommandPayload (uintptr_t vmaddr, uint64_t* pOffsetOut) const;
+	bool GetOffsetForSegmentCommandPayload (size_t segmentIndex, uint64_t* pOffsetOut) const;
+
+	// Bytes of padding inserted due to segment page alignment, and the size of the core file. Only available after
+	// FinalizeLoadCommands has been called, and are only final once all payload sizes are known
+	uint64_t GetSegmentAlignmentOverhead () const;
+	uint64_t GetCoreFileSize () const;
+	// Bytes of segment payloads not written because of page deduplication
+	uint64_t GetDeduplicatedBytes () const;
+	// Checksum stored in the "crc32c digest" note, only available after a successful Build or BuildSequential
+	uint32_t GetCRC32C () const;
 
 	size_t				GetNumberOfSegmentCommands () const;
 	segment_command_64* GetSegmentCommand (size_t index);
@@ -42,8 +80,45 @@ private:
 	using ThreadCommands		   = Vector<UniquePtr<thread_command>>;
 
 	template<typename T>
-	bool WriteToOStream (const T& data, IRandomAccessBinaryOStream* pOStream);
-	bool WriteToOStream (const void* pData, size_t size, IRandomAccessBinaryOStream* pOStream);
+	bool WriteToOStream (const T& data, ISequentialBinaryOStream* pOStream);
+	bool WriteToOStream (const void* pData, size_t size, ISequentialBinaryOStream* pOStream);
+	bool WriteToOStream (const iovec* pIOVecs, size_t count, ISequentialBinaryOStream* pOStream);
+	bool PadOStreamTo (size_t newPos, ISequentialBinaryOStream* pOStream);
+	void SetOStreamPosition (size_t newPos, IRandomAccessBinaryOStream* pOStream);
+	// Seeks if pSeekableOStream is provided, writes padding otherwise
+	bool MoveOStreamTo (size_t						newPos,
+						ISequentialBinaryOStream*	pOStream,
+						IRandomAccessBinaryOStream* pSeekableOStream);
+
+	bool WriteCore (IRandomAccessBinaryOStream* pOStream);
+	bool WriteCoreSequential (ISequentialBinaryOStream* pOStream);
+	bool WriteHeaderLoadCommandsAndNotePayloads (ISequentialBinaryOStream* pOStream);
+	bool WriteSegmentPayloads (ISequentialBinaryOStream* pOStream, IRandomAccessBinaryOStream* pSeekableOStream);
+	bool WriteSegmentPayloadsPipelined (ChunkPipeline*				pPipeline,
+										const Vector<size_t>&		segmentIndices,
+										ISequentialBinaryOStream*	pOStream,
+										IRandomAccessBinaryOStream* pSeekableOStream);
+	bool WriteSegmentPayloadsInParallel (IRandomAccessBinaryOStream* pOStream);
+	bool WriteSegmentPayload (size_t						 index,
+							  ISequentialBinaryOStream*	 pOStream,
+							  IRandomAccessBinaryOStream* pSeekableOStream);
+	// pData might be nullptr if the data could not be read, the chunk is filled with zeroes in this case. Chunks are
+	// written sparsely if sparse output is enabled, and pSeekableOStream is provided.
+	bool WriteSegmentChunk (size_t						index,
+							const char*					pData,
+							size_t						size,
+							ISequentialBinaryOStream*	pOStream,
+							IRandomAccessBinaryOStream* pSeekableOStream);
+	bool WriteSparseChunk (const char* pData, size_t size, IRandomAccessBinaryOStream* pOStream);
+	bool SkipZeroesInOStream (size_t size, IRandomAccessBinaryOStream* pOStream);
+
+	void LayOutPayloads ();
+	void DeduplicatePages ();
+	// Segments without a data provider don't have a payload of their own: they are empty, or refer to the payload of
+	// another segment (see m_sharedPayloads)
+	bool HasOwnPayload (size_t segmentIndex) const;
+	// The checksum note has no data provider, its payload is written by Build or BuildSequential directly
+	bool IsChecksumNote (size_t noteIndex) const;
 
 	bool m_loadCommandsFinalized;
 
@@ -53,7 +128,45 @@ private:
 	ThreadCommands								 m_thread_cmds;
 	LoadCommandsWithLazyData<segment_command_64> m_segment_cmds;
 
+	// File offsets of payloads, indexed the same way as the corresponding load command containers
+	Vector<uint64_t> m_notePayloadOffsets;
+	Vector<uint64_t> m_segmentPayloadOffsets;
+
+	struct SharedPayload {
+		size_t	 segmentIndex; // Always a segment with its own payload, preceding the one referring to it
+		uint64_t offset;
+	};
+
+	// Segments (created by page deduplication) referring to (a piece of) the payload of another segment
+	Map<size_t, SharedPayload> m_sharedPayloads;
+	// Data providers of segments that have been split by page deduplication, the pieces are slices of them
+	Vector<std::unique_ptr<IDataProvider>> m_splitDataProviders;
+
+	// Position of the output stream during building (tracked by us, as not all streams are able to report it)
+	size_t m_oStreamPosition;
+
+	size_t m_payloadChunkSize;
+	size_t m_payloadPipelineDepth;
+	size_t m_nWriterThreads;
+	size_t m_segmentPageSize;
+	bool   m_sparseOutput;
+	// Size of the stream when Build was called: bytes beyond it that are skipped (gaps, sparse output) are holes, the
+	// ones before it have to be zeroed
+	size_t m_oStreamInitialSize;
+
+	bool	 m_deduplicatePages;
+	uint64_t m_deduplicatedBytes;
+
+	bool	 m_checksumming;
+	size_t	 m_checksumNoteIndex;
+	uint32_t m_crc32c;
+
+	uint64_t m_segmentAlignmentOverhead;
+	uint64_t m_coreFileSize;
+
 #ifdef _DEBUG
+	bool TrackWrittenRange (size_t start, size_t end);
+
 	Vector<std::pair<size_t, size_t>> m_writtenRanges;
 #endif
 };
@@ -1,5 +1,5 @@
 template<typename T>
-bool MachOCoreDumpBuilder::WriteToOStream (const T& data, IRandomAccessBinaryOStream* pOStream)
+bool MachOCoreDumpBuilder::WriteToOStream (const T& data, ISequentialBinaryOStream* pOStream)
 {
 	return WriteToOStream (&data, sizeof data, pOStream);
 }
@@ -9,6 +9,8 @@ const char* AddrableBitsOwner	 = "addrable bits";
 const char* AllImageInfosOwner	 = "all image infos";
 const char* MainBinSpecOwner	 = "main bin spec";
 const char* ProcessMetadataOwner = "process metadata";
+const char* DroppedRangesOwner	 = "dropped ranges";
+const char* ChecksumOwner		 = "crc32c digest";
 
 ThreadInfo::ThreadInfo (thread_act_t threads_i, bool suspendWhileInspecting):
 	suspendWhileInspecting (suspendWhileInspecting),
@@ -56,6 +56,39 @@ struct MainBinSpec {
 	uint32_t platform      = 0;           // 0 = unspecified
 };
 
+// Importance of a range of memory; with a memory budget, ranges are admitted in this order
+enum class MemoryRangePriority : uint32_t {
+	CrashingThreadStack = 0,
+	CrashingThreadCode	= 1, // Memory around instruction pointers on the call stack of the crashing thread
+	TopOfStack			= 2, // Topmost pages of the stacks of other threads
+	Code				= 3, // Memory around instruction pointers on the call stacks of other threads
+	Stack				= 4	 // The rest of the stacks of other threads
+};
+
+// "dropped ranges" LC_NOTE payload, present if a memory budget was set: the header is followed by entryCount
+// DroppedRangeEntry structs, describing memory that was left out of the core file because of the budget
+struct DroppedRangesHeader {
+	uint32_t version	  = 1;
+	uint32_t entryCount	  = 0;
+	uint64_t memoryBudget = 0;
+};
+
+struct DroppedRangeEntry {
+	uint64_t			address	 = 0;
+	uint64_t			size	 = 0;
+	MemoryRangePriority priority = MemoryRangePriority::Stack;
+	uint32_t			reserved = 0;
+};
+
+// "crc32c digest" LC_NOTE payload, present if checksumming was requested. Unlike other payloads, it's at the very end
+//   of the file: crc32c is the CRC-32C checksum of the first checksummedSize bytes of the file, i.e. everything before
+//   the payload itself.
+struct ChecksumInfo {
+	uint32_t version		 = 1;
+	uint32_t crc32c			 = 0;
+	uint64_t checksummedSize = 0;
+};
+
 enum class RegSetKind : uint32_t {
 #ifdef __x86_64__
 	GPR = 4,
@@ -149,6 +182,8 @@ extern const char* MainBinSpecOwner;
 extern const char* AddrableBitsOwner;
 extern const char* AllImageInfosOwner;
 extern const char* ProcessMetadataOwner;
+extern const char* DroppedRangesOwner;
+extern const char* ChecksumOwner;
 
 } // namespace MachOCore
 } // namespace MMD
@@ -0,0 +1,169 @@
+#include "MMD/MemoryOStream.hpp"
+
+#include <algorithm>
+#include <cassert>
+#include <cstring>
+
+#include "ZoneAllocator.hpp"
+
+namespace MMD {
+
+// Every allocated chunk has an iovec, whose length is the number of bytes of the chunk within the size of the stream
+//   (so chunks allocated in advance have zero length). Bytes of chunks beyond the size of the stream are always zero.
+struct MemoryOStream::Chunks : public ZoneAllocated {
+	Vector<iovec> iovecs;
+};
+
+MemoryOStream::MemoryOStream (size_t chunkSize /*= DefaultChunkSize*/):
+	m_pChunks (new Chunks),
+	m_chunkSize (chunkSize),
+	m_size (0),
+	m_position (0)
+{
+	assert (m_chunkSize > 0);
+}
+
+bool MemoryOStream::Write (const void* pData, size_t size)
+{
+	if (!WriteAt (pData, size, m_position))
+		return false;
+
+	m_position += size;
+
+	return true;
+}
+
+bool MemoryOStream::Flush ()
+{
+	return true;
+}
+
+size_t MemoryOStream::GetPosition ()
+{
+	return m_position;
+}
+
+void MemoryOStream::SetPosition (size_t newPos)
+{
+	m_position = newPos;
+}
+
+size_t MemoryOStream::GetSize ()
+{
+	return m_size;
+}
+
+bool MemoryOStream::SetSize (size_t newSize)
+{
+	if (newSize >= m_size) {
+		if (!Reserve (newSize))
+			return false;
+	} else {
+		// Restore the invariant of zeroes beyond the size: clear the cut off part of the last chunk, and free the ones
+		//   entirely beyond the new size
+		const size_t offsetInChunk = newSize % m_chunkSize;
+		if (offsetInChunk != 0) {
+			const size_t chunkStart = newSize - offsetInChunk;
+			const size_t clearEnd	= std::min (m_size - chunkStart, m_chunkSize);
+			memset (static_cast<char*> (m_pChunks->iovecs[newSize / m_chunkSize].iov_base) + offsetInChunk,
+					0,
+					clearEnd - offsetInChunk);
+		}
+
+		const size_t nChunksNeeded = (newSize + m_chunkSize - 1) / m_chunkSize;
+		for (size_t i = nChunksNeeded; i < m_pChunks->iovecs.size (); ++i)
+			Free (m_pChunks->iovecs[i].iov_base);
+
+		m_pChunks->iovecs.resize (nChunksNeeded);
+	}
+
+	UpdateChunkLengths (m_size, newSize);
+	m_size = newSize;
+
+	return true;
+}
+
+bool MemoryOStream::WriteAt (const void* pData, size_t size, size_t offset)
+{
+	const size_t end = offset + size;
+	if (!Reserve (end))
+		return false;
+
+	const char* pCurr = static_cast<const char*> (pData);
+	while (offset < end) {
+		const size_t offsetInChunk = offset % m_chunkSize;
+		const size_t toCopy		   = std::min (end - offset, m_chunkSize - offsetInChunk);
+		memcpy (static_cast<char*> (m_pChunks->iovecs[offset / m_chunkSize].iov_base) + offsetInChunk, pCurr, toCopy);
+
+		pCurr += toCopy;
+		offset += toCopy;
+	}
+
+	if (end > m_size) {
+		UpdateChunkLengths (m_size, end);
+		m_size = end;
+	}
+
+	return true;
+}
+
+bool MemoryOStream::Preallocate (size_t size)
+{
+	return Reserve (size);
+}
+
+MemoryOStream::~MemoryOStream ()
+{
+	for (const iovec& chunk : m_pChunks->iovecs)
+		Free (chunk.iov_base);
+}
+
+const iovec* MemoryOStream::GetIOVecs () const
+{
+	return m_pChunks->iovecs.data ();
+}
+
+size_t MemoryOStream::GetIOVecCount () const
+{
+	return (m_size + m_chunkSize - 1) / m_chunkSize;
+}
+
+size_t MemoryOStream::GetChunkSize () const
+{
+	return m_chunkSize;
+}
+
+// Makes sure that chunks are allocated for the first size bytes
+bool MemoryOStream::Reserve (size_t size)
+{
+	while (m_pChunks->iovecs.size () * m_chunkSize < size) {
+		// Zeroed, so that gaps left by positional writes read back as zeroes
+		void* pChunk = Calloc (m_chunkSize);
+		if (pChunk == nullptr)
+			return false;
+
+		try {
+			m_pChunks->iovecs.push_back ({ pChunk, 0 });
+		} catch (const std::bad_alloc&) {
+			Free (pChunk);
+
+			return false;
+		}
+	}
+
+	return true;
+}
+
+// Recalculates the lengths of the chunks affected by a size change
+void MemoryOStream::UpdateChunkLengths (size_t oldSize, size_t newSize)
+{
+	const size_t firstChunk = std::min (oldSize, newSize) / m_chunkSize;
+	const size_t maxSize	= std::max (oldSize, newSize);
+	const size_t endChunk	= std::min ((maxSize + m_chunkSize - 1) / m_chunkSize, m_pChunks->iovecs.size ());
+	for (size_t i = firstChunk; i < endChunk; ++i) {
+		const size_t chunkStart		 = i * m_chunkSize;
+		m_pChunks->iovecs[i].iov_len = newSize > chunkStart ? std::min (newSize - chunkStart, m_chunkSize) : 0;
+	}
+}
+
+} // namespace MMD
@@ -0,0 +1,245 @@
+#include "MMD/MmapOStream.hpp"
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <cstring>
+#include <mutex>
+
+#include "MMD/FileDescriptorIO.hpp"
+
+namespace MMD {
+namespace {
+
+// Storage is allocated, and the file is mapped in steps of this size, so that both are rare
+const size_t GrowthStep = 32 * 1'024 * 1'024;
+
+size_t RoundUpToGrowthStep (size_t size)
+{
+	return (size + GrowthStep - 1) / GrowthStep * GrowthStep;
+}
+
+void AtomicMax (std::atomic<size_t>* pValue, size_t candidate)
+{
+	size_t current = pValue->load ();
+	while (current < candidate && !pValue->compare_exchange_weak (current, candidate)) {
+		// current has been reloaded, try again
+	}
+}
+
+} // namespace
+
+MmapOStream::MmapOStream (int fd):
+	m_fd (fd),
+	m_pMapping (nullptr),
+	m_mappingSize (0),
+	m_fileSize (0),
+	m_reservedSize (0),
+	m_writableSize (0),
+	m_position (0),
+	m_size (0)
+{
+	struct stat fileInfo;
+	if (m_fd != -1 && fstat (m_fd, &fileInfo) == 0) {
+		m_fileSize = fileInfo.st_size;
+		m_size	   = fileInfo.st_size;
+	}
+}
+
+MmapOStream::MmapOStream (const char* filePath): MmapOStream (open (filePath, O_RDWR)) {}
+
+bool MmapOStream::Write (const void* pData, size_t size)
+{
+	if (!WriteAt (pData, size, m_position))
+		return false;
+
+	m_position += size;
+
+	return true;
+}
+
+bool MmapOStream::Flush ()
+{
+	if (m_pMapping != nullptr && m_fileSize > 0 && msync (m_pMapping, m_fileSize, MS_SYNC) != 0)
+		return false;
+
+	return Trim () && fsync (m_fd) == 0;
+}
+
+size_t MmapOStream::GetPosition ()
+{
+	return m_position;
+}
+
+void MmapOStream::SetPosition (size_t newPos)
+{
+	m_position = newPos;
+}
+
+size_t MmapOStream::GetSize ()
+{
+	return m_size;
+}
+
+bool MmapOStream::SetSize (size_t newSize)
+{
+	// Shrinking truncates the file itself, so that the part cut off reads back as zeroes should the stream grow again
+	if (newSize < m_size) {
+		Unmap ();
+		if (ftruncate (m_fd, newSize) == -1)
+			return false;
+
+		m_fileSize	   = newSize;
+		m_reservedSize = std::min (m_reservedSize, newSize);
+	}
+
+	m_size = newSize;
+
+	return true;
+}
+
+bool MmapOStream::WriteAt (const void* pData, size_t size, size_t offset)
+{
+	if (size == 0)
+		return true;
+
+	const size_t end = offset + size;
+	while (true) {
+		{
+			std::shared_lock<std::shared_mutex> lock (m_mappingMutex);
+			if (end <= m_writableSize) {
+				memcpy (m_pMapping + offset, pData, size);
+				AtomicMax (&m_size, end);
+
+				return true;
+			}
+		}
+
+		// Some other writer might have grown the file in the meantime, Grow handles that
+		std::unique_lock<std::shared_mutex> lock (m_mappingMutex);
+		if (!Grow (end))
+			return false;
+	}
+}
+
+bool MmapOStream::SupportsConcurrentWriteAt () const
+{
+	// Writes copy into the mapping under a shared lock, only growing the mapping is exclusive
+	return true;
+}
+
+bool MmapOStream::Preallocate (size_t size)
+{
+	// Allocating and mapping everything up front avoids doing so while writing. The file is still extended write by
+	//   write, so it never appears larger than what has been written.
+	return Reserve (size) && Map (size);
+}
+
+MmapOStream::~MmapOStream ()
+{
+	Cleanup ();
+}
+
+bool MmapOStream::IsValid () const
+{
+	return m_fd != -1;
+}
+
+bool MmapOStream::Grow (size_t minSize)
+{
+	if (minSize <= m_writableSize)
+		return true;
+
+	// Storage must be allocated before the file is extended over it, as stores into a hole of a mapping can't fail
+	//   gracefully
+	if (!Reserve (minSize) || !Map (minSize))
+		return false;
+
+	if (minSize > m_fileSize) {
+		if (ftruncate (m_fd, minSize) == -1)
+			return false;
+
+		m_fileSize = minSize;
+	}
+
+	m_writableSize = std::min ({ m_fileSize, m_reservedSize, m_mappingSize });
+
+	return true;
+}
+
+bool MmapOStream::Reserve (size_t minSize)
+{
+	if (minSize <= m_reservedSize)
+		return true;
+
+	const size_t newReservedSize = RoundUpToGrowthStep (minSize);
+	if (!PreallocateAll (m_fd, newReservedSize))
+		return false;
+
+	m_reservedSize = newReservedSize;
+
+	return true;
+}
+
+bool MmapOStream::Map (size_t minSize)
+{
+	if (minSize <= m_mappingSize)
+		return true;
+
+	// The mapping may extend past the end of the file, it is only written within the file. There is no mremap on macOS.
+	const size_t newMappingSize = RoundUpToGrowthStep (minSize);
+	Unmap ();
+
+	void* pMapping = mmap (nullptr, newMappingSize, PROT_READ | PROT_WRITE, MAP_SHARED, m_fd, 0);
+	if (pMapping == MAP_FAILED)
+		return false;
+
+	m_pMapping	  = static_cast<uint8_t*> (pMapping);
+	m_mappingSize = newMappingSize;
+
+	return true;
+}
+
+bool MmapOStream::Trim ()
+{
+	Unmap ();
+
+	if (m_fileSize == m_size && m_reservedSize <= m_size)
+		return true;
+
+	// Also releases the storage allocated past the end of the stream
+	if (ftruncate (m_fd, m_size) == -1)
+		return false;
+
+	m_fileSize	   = m_size;
+	m_reservedSize = m_size;
+
+	return true;
+}
+
+void MmapOStream::Unmap ()
+{
+	if (m_pMapping == nullptr)
+		return;
+
+	munmap (m_pMapping, m_mappingSize);
+	m_pMapping	   = nullptr;
+	m_mappingSize  = 0;
+	m_writableSize = 0;
+}
+
+void MmapOStream::Cleanup ()
+{
+	if (!IsValid ())
+		return;
+
+	Trim ();
+
+	close (m_fd);
+	m_fd = -1;
+}
+
+} // namespace MMD
@@ -0,0 +1,168 @@
+#include "PageDeduplicator.hpp"
+
+#include <algorithm>
+#include <cassert>
+#include <cstring>
+
+namespace MMD {
+namespace {
+
+constexpr uint64_t Prime1 = 0x9E37'79B1'85EB'CA87ull;
+constexpr uint64_t Prime2 = 0xC2B2'AE3D'27D4'EB4Full;
+
+uint64_t RotateLeft (uint64_t value, unsigned bits)
+{
+	return (value << bits) | (value >> (64 - bits));
+}
+
+uint64_t MixLane (uint64_t lane, uint64_t word)
+{
+	return RotateLeft (lane + word * Prime2, 31) * Prime1;
+}
+
+} // namespace
+
+// Multiply-rotate hash over four independent 64-bit lanes (in the spirit of xxHash), so the loop is not bound by the
+// latency of a single multiplication chain. Pages are a multiple of 32 bytes, any remainder is mixed in byte by byte.
+uint64_t HashPage (const void* pData, size_t size)
+{
+	const char* pBytes = static_cast<const char*> (pData);
+
+	uint64_t lanes[4] = { Prime1 + Prime2, Prime2, 0, 0 - Prime1 };
+
+	size_t i = 0;
+	for (; i + sizeof lanes <= size; i += sizeof lanes) {
+		uint64_t words[4];
+		memcpy (words, pBytes + i, sizeof words);
+
+		for (size_t lane = 0; lane < 4; ++lane)
+			lanes[lane] = MixLane (lanes[lane], words[lane]);
+	}
+
+	uint64_t hash = RotateLeft (lanes[0], 1) + RotateLeft (lanes[1], 7) + RotateLeft (lanes[2], 12) +
+					RotateLeft (lanes[3], 18) + size;
+	for (; i < size; ++i)
+		hash = RotateLeft (hash ^ (uint8_t (pBytes[i]) * Prime1), 11) * Prime2;
+
+	hash ^= hash >> 33;
+	hash *= Prime2;
+	hash ^= hash >> 29;
+
+	return hash;
+}
+
+PageDeduplicator::PageDeduplicator (Vector<Source> sources, size_t pageSize):
+	m_sources (std::move (sources)),
+	m_pageSize (pageSize),
+	m_duplicateBytes (0)
+{
+	assert (pageSize > 0 && (pageSize & (pageSize - 1)) == 0);
+}
+
+void PageDeduplicator::Run ()
+{
+	m_pieces.clear ();
+	m_pieces.resize (m_sources.size ());
+	m_duplicateBytes = 0;
+
+	// Only the first occurrence of a hash is remembered: if another page has the same hash but different content, it
+	// is simply written out
+	Map<uint64_t, PageLocation> firstOccurrences;
+
+	UniquePtr<char[]> pPage		= MakeUniqueArray<char> (m_pageSize);
+	UniquePtr<char[]> pOriginal = MakeUniqueArray<char> (m_pageSize);
+
+	for (size_t sourceIndex = 0; sourceIndex < m_sources.size (); ++sourceIndex) {
+		const Source&  source	= m_sources[sourceIndex];
+		const uint64_t size		= source.pDataProvider == nullptr ? 0 : source.pDataProvider->GetSize ();
+		IDataPtr*	   pDataPtr = size == 0 ? nullptr : source.pDataProvider->GetDataPtr ();
+
+		uint64_t offset = 0;
+		while (offset < size) {
+			// Pages are aligned in the address space, so the first and last ones might be partial
+			const uint64_t pageEnd	= (source.address + offset + m_pageSize) & ~uint64_t (m_pageSize - 1);
+			const uint64_t pageSize = std::min (pageEnd - source.address, size) - offset;
+
+			Piece piece = { offset, pageSize, false, 0, 0 };
+			if (pageSize == m_pageSize && pDataPtr != nullptr && pDataPtr->CopyTo (offset, pageSize, pPage.get ())) {
+				const uint64_t hash = HashPage (pPage.get (), pageSize);
+
+				const auto it = firstOccurrences.find (hash);
+				if (it == firstOccurrences.end ()) {
+					firstOccurrences.emplace (hash, PageLocation { sourceIndex, offset });
+				} else {
+					const PageLocation& original = it->second;
+					IDataPtr* pOriginalDataPtr	 = m_sources[original.sourceIndex].pDataProvider->GetDataPtr ();
+
+					if (pOriginalDataPtr != nullptr &&
+						pOriginalDataPtr->CopyTo (original.offset, pageSize, pOriginal.get ()) &&
+						memcmp (pPage.get (), pOriginal.get (), pageSize) == 0) {
+						piece.isDuplicate		  = true;
+						piece.originalSourceIndex = original.sourceIndex;
+						piece.originalOffset	  = original.offset;
+					}
+				}
+			}
+
+			AddPiece (sourceIndex, piece);
+
+			offset += pageSize;
+		}
+
+		// Zero-sized sources still get a (zero-sized) piece, so that every source is represented
+		if (size == 0)
+			AddPiece (sourceIndex, { 0, 0, false, 0, 0 });
+	}
+}
+
+void PageDeduplicator::AddPiece (size_t sourceIndex, const Piece& piece)
+{
+	if (piece.isDuplicate)
+		m_duplicateBytes += piece.size;
+
+	Vector<Piece>& pieces = m_pieces[sourceIndex];
+	if (!pieces.empty ()) {
+		Piece& last = pieces.back ();
+
+		// Runs of pages to write are merged, and so are runs of duplicates of consecutive pages
+		const bool mergeable = !last.isDuplicate && !piece.isDuplicate;
+		const bool mergeableDuplicates =
+			last.isDuplicate && piece.isDuplicate && last.originalSourceIndex == piece.originalSourceIndex &&
+			last.originalOffset + last.size == piece.originalOffset;
+
+		if (mergeable || mergeableDuplicates) {
+			last.size += piece.size;
+
+			return;
+		}
+	}
+
+	pieces.push_back (piece);
+}
+
+const Vector<PageDeduplicator::Piece>& PageDeduplicator::GetPieces (size_t sourceIndex) const
+{
+	return m_pieces[sourceIndex];
+}
+
+size_t PageDeduplicator::FindPiece (size_t sourceIndex, uint64_t offset, uint64_t* pOffsetInPieceOut) const
+{
+	const Vector<Piece>& pieces = m_pieces[sourceIndex];
+
+	const auto it = std::upper_bound (pieces.begin (), pieces.end (), offset, [] (uint64_t value, const Piece& piece) {
+		return value < piece.offset;
+	});
+	assert (it != pieces.begin ());
+
+	const size_t index = (it - pieces.begin ()) - 1;
+	*pOffsetInPieceOut = offset - pieces[index].offset;
+
+	return index;
+}
+
+uint64_t PageDeduplicator::GetDuplicateBytes () const
+{
+	return m_duplicateBytes;
+}
+
+} // namespace MMD
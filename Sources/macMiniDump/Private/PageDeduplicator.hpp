@@ -0,0 +1,62 @@
+#ifndef MMD_PAGEDEDUPLICATOR
+#define MMD_PAGEDEDUPLICATOR
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+#include "DataAccess.hpp"
+#include "ZoneAllocator.hpp"
+
+namespace MMD {
+
+// Finds pages with identical content in a list of memory ranges. Pages are hashed, and matches are verified with a
+//   byte compare. Every range is split into pieces: runs of pages (and partial pages at the edges) that have to be
+//   written, and runs of pages that are duplicates of pages written earlier (in this or in a previous range).
+class PageDeduplicator {
+public:
+	struct Source {
+		IDataProvider* pDataProvider; // Might be nullptr (no data)
+		uint64_t	   address;
+	};
+
+	struct Piece {
+		uint64_t offset; // Inside the data of the source
+		uint64_t size;
+		bool	 isDuplicate;
+		// For duplicates: the first occurrence of the data (always part of a non-duplicate piece)
+		size_t	 originalSourceIndex;
+		uint64_t originalOffset;
+	};
+
+	// Pages are aligned to pageSize (a power of two) in the address space
+	PageDeduplicator (Vector<Source> sources, size_t pageSize);
+
+	void Run ();
+
+	// Pieces of a source, in increasing offset order, covering all of its data
+	const Vector<Piece>& GetPieces (size_t sourceIndex) const;
+	// Index of the piece of a source containing the given offset (and the offset inside that piece)
+	size_t	 FindPiece (size_t sourceIndex, uint64_t offset, uint64_t* pOffsetInPieceOut) const;
+	uint64_t GetDuplicateBytes () const;
+
+private:
+	struct PageLocation {
+		size_t	 sourceIndex;
+		uint64_t offset;
+	};
+
+	void AddPiece (size_t sourceIndex, const Piece& piece);
+
+	Vector<Source>		  m_sources;
+	size_t				  m_pageSize;
+	Vector<Vector<Piece>> m_pieces;
+	uint64_t			  m_duplicateBytes;
+};
+
+uint64_t HashPage (const void* pData, size_t size);
+
+} // namespace MMD
+
+#endif // MMD_PAGEDEDUPLICATOR
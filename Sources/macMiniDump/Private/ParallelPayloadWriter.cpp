@@ -0,0 +1,175 @@
+#include "ParallelPayloadWriter.hpp"
+
+#include <pthread.h>
+
+#include <algorithm>
+#include <cassert>
+#include <cstring>
+
+#include "Logging.hpp"
+#include "SparseOutput.hpp"
+
+namespace MMD {
+
+ParallelPayloadWriter::ParallelPayloadWriter (Vector<Job> jobs, size_t nWorkers, size_t chunkSize):
+	m_jobs (std::move (jobs)),
+	m_nWorkers (nWorkers),
+	m_chunkSize (chunkSize),
+	m_sparseOutput (false),
+	m_oStreamInitialSize (0)
+{
+	assert (nWorkers > 0);
+	assert (chunkSize > 0);
+}
+
+void ParallelPayloadWriter::SetSparseOutput (size_t oStreamInitialSize)
+{
+	m_sparseOutput		 = true;
+	m_oStreamInitialSize = oStreamInitialSize;
+}
+
+bool ParallelPayloadWriter::Write (IRandomAccessBinaryOStream* pOStream)
+{
+	assert (pOStream->SupportsConcurrentWriteAt ());
+
+	// Buffers are allocated upfront, as allocation failures could not be handled on the worker threads
+	Vector<Worker> workers = AssignJobsToWorkers ();
+	try {
+		for (Worker& worker : workers) {
+			worker.pOStream = pOStream;
+			worker.pBuffer	= MakeUniqueArray<char> (m_chunkSize);
+		}
+	} catch (const std::bad_alloc&) {
+		MMD_DEBUGLOG_LINE << "Failed to allocate buffers for " << workers.size () << " writer threads";
+
+		return false;
+	}
+
+	// The calling thread takes the share of the first worker, so one less thread is needed
+	Vector<pthread_t> threads (workers.size ());
+	Vector<bool>	  threadStarted (workers.size (), false);
+	for (size_t i = 1; i < workers.size (); ++i)
+		threadStarted[i] = pthread_create (&threads[i], nullptr, &WorkerThreadMain, &workers[i]) == 0;
+
+	workers[0].succeeded = WriteParts (workers[0]);
+
+	bool succeeded = workers[0].succeeded;
+	for (size_t i = 1; i < workers.size (); ++i) {
+		if (threadStarted[i]) {
+			pthread_join (threads[i], nullptr);
+		} else {
+			MMD_DEBUGLOG_LINE << "Failed to start writer thread #" << i << ", writing its share on the calling thread";
+
+			workers[i].succeeded = WriteParts (workers[i]);
+		}
+
+		succeeded = succeeded && workers[i].succeeded;
+	}
+
+	return succeeded;
+}
+
+void* ParallelPayloadWriter::WorkerThreadMain (void* pWorker)
+{
+	Worker* pThis	 = static_cast<Worker*> (pWorker);
+	pThis->succeeded = pThis->pWriter->WriteParts (*pThis);
+
+	return nullptr;
+}
+
+bool ParallelPayloadWriter::WriteParts (const Worker& worker)
+{
+	char* pBuffer = worker.pBuffer.get ();
+
+	for (const JobPart& part : worker.parts) {
+		for (size_t offset = 0; offset < part.size; offset += m_chunkSize) {
+			const size_t chunkSize = std::min (part.size - offset, m_chunkSize);
+
+			// The size of the payload is already part of the layout, so data that can't be read is filled with zeroes
+			if (part.pDataPtr == nullptr || !part.pDataPtr->CopyTo (part.offset + offset, chunkSize, pBuffer)) {
+				MMD_DEBUGLOG_LINE << "Failed to read data for payload at file offset 0x" << std::hex
+								  << part.fileOffset + offset << std::dec;
+
+				memset (pBuffer, 0, chunkSize);
+			}
+
+			if (!WriteChunk (pBuffer, chunkSize, part.fileOffset + offset, worker.pOStream))
+				return false;
+		}
+	}
+
+	return true;
+}
+
+bool ParallelPayloadWriter::WriteChunk (const char*					pData,
+										size_t						size,
+										uint64_t					fileOffset,
+										IRandomAccessBinaryOStream* pOStream)
+{
+	if (!m_sparseOutput)
+		return pOStream->WriteAt (pData, size, fileOffset);
+
+	return ForEachSparseRun (pData, size, fileOffset, [&] (size_t offset, size_t runSize, bool isZero) {
+		if (isZero)
+			return ZeroOStreamRange (pOStream, fileOffset + offset, runSize, m_oStreamInitialSize);
+
+		return pOStream->WriteAt (pData + offset, runSize, fileOffset + offset);
+	});
+}
+
+Vector<ParallelPayloadWriter::Worker> ParallelPayloadWriter::AssignJobsToWorkers ()
+{
+	// Payloads larger than an even share of all bytes are split into parts of (about) that size, so that a single large
+	//   payload (e.g. a big heap region) is not left to a single worker. Parts are aligned to chunks.
+	uint64_t totalSize = 0;
+	for (const Job& job : m_jobs)
+		totalSize += job.pSource->GetSize ();
+
+	const uint64_t share	   = std::max<uint64_t> ((totalSize + m_nWorkers - 1) / m_nWorkers, 1);
+	const size_t   maxPartSize = size_t ((share + m_chunkSize - 1) / m_chunkSize * m_chunkSize);
+
+	// Data pointers are fetched here, as providers are not required to hand them out concurrently
+	Vector<JobPart> parts;
+	for (const Job& job : m_jobs) {
+		const size_t dataSize = job.pSource->GetSize ();
+		IDataPtr*	 pDataPtr = job.pSource->GetDataPtr ();
+		for (size_t offset = 0; offset < dataSize; offset += maxPartSize)
+			parts.push_back ({ pDataPtr, offset, std::min (dataSize - offset, maxPartSize), job.fileOffset + offset });
+	}
+
+	// Greedy balancing by byte count: parts are handed out largest first, always to the worker with the least bytes
+	std::sort (parts.begin (), parts.end (), [] (const JobPart& lhs, const JobPart& rhs) {
+		return lhs.size != rhs.size ? lhs.size > rhs.size : lhs.fileOffset < rhs.fileOffset;
+	});
+
+	const size_t   nWorkers = std::max<size_t> (1, std::min (m_nWorkers, parts.size ()));
+	Vector<Worker> workers (nWorkers);
+	for (Worker& worker : workers) {
+		worker.pWriter	 = this;
+		worker.pOStream	 = nullptr;
+		worker.nBytes	 = 0;
+		worker.succeeded = false;
+	}
+
+	for (const JobPart& part : parts) {
+		Worker* pLeastBusy = &workers[0];
+		for (Worker& worker : workers) {
+			if (worker.nBytes < pLeastBusy->nBytes)
+				pLeastBusy = &worker;
+		}
+
+		pLeastBusy->parts.push_back (part);
+		pLeastBusy->nBytes += part.size;
+	}
+
+	// Writing payloads in increasing offset order is friendlier to the file system
+	for (Worker& worker : workers) {
+		std::sort (worker.parts.begin (), worker.parts.end (), [] (const JobPart& lhs, const JobPart& rhs) {
+			return lhs.fileOffset < rhs.fileOffset;
+		});
+	}
+
+	return workers;
+}
+
+} // namespace MMD
@@ -0,0 +1,65 @@
+#ifndef MMD_PARALLELPAYLOADWRITER
+#define MMD_PARALLELPAYLOADWRITER
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+#include "DataAccess.hpp"
+#include "MMD/IRandomAccessBinaryOStream.hpp"
+#include "ZoneAllocator.hpp"
+
+namespace MMD {
+
+// Writes payloads with known file offsets on a small pool of worker threads, using positional writes. Payloads are
+//   distributed among workers so that each of them has to write roughly the same number of bytes: payloads larger than
+//   an even share are split into parts, written by different workers.
+class ParallelPayloadWriter {
+public:
+	struct Job {
+		IDataProvider* pSource;
+		uint64_t	   fileOffset;
+	};
+
+	ParallelPayloadWriter (Vector<Job> jobs, size_t nWorkers, size_t chunkSize);
+
+	// Whole pages of zeroes are skipped instead of being written (see ZeroOStreamRange for oStreamInitialSize)
+	void SetSparseOutput (size_t oStreamInitialSize);
+
+	// The stream must support concurrent positional writes, and the data pointers of the sources concurrent copies
+	bool Write (IRandomAccessBinaryOStream* pOStream);
+
+private:
+	struct JobPart {
+		IDataPtr* pDataPtr;	  // nullptr if the data of the job could not be accessed
+		size_t	  offset;	  // In the payload of the job
+		size_t	  size;
+		uint64_t  fileOffset; // Of the part
+	};
+
+	struct Worker {
+		ParallelPayloadWriter*		pWriter;
+		IRandomAccessBinaryOStream* pOStream;
+		Vector<JobPart>				parts;
+		UniquePtr<char[]>			pBuffer; // Of the chunk size
+		uint64_t					nBytes;
+		bool						succeeded;
+	};
+
+	static void* WorkerThreadMain (void* pWorker);
+	bool		 WriteParts (const Worker& worker);
+	bool		 WriteChunk (const char* pData, size_t size, uint64_t fileOffset, IRandomAccessBinaryOStream* pOStream);
+
+	Vector<Worker> AssignJobsToWorkers ();
+
+	Vector<Job> m_jobs;
+	size_t		m_nWorkers;
+	size_t		m_chunkSize;
+	bool		m_sparseOutput;
+	size_t		m_oStreamInitialSize;
+};
+
+} // namespace MMD
+
+#endif // MMD_PARALLELPAYLOADWRITER
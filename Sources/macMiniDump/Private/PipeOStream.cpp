@@ -0,0 +1,47 @@
+#include "MMD/PipeOStream.hpp"
+
+#include <unistd.h>
+
+#include "MMD/FileDescriptorIO.hpp"
+
+namespace MMD {
+
+PipeOStream::PipeOStream (int fd): m_fd (fd) {}
+
+bool PipeOStream::Write (const void* pData, size_t size)
+{
+	// Pipes and sockets might accept less data than requested at once
+	return WriteAll (m_fd, pData, size);
+}
+
+bool PipeOStream::WriteV (const iovec* pIOVecs, size_t count)
+{
+	return WriteVAll (m_fd, pIOVecs, count);
+}
+
+bool PipeOStream::Flush ()
+{
+	// Nothing is buffered on our side
+	return IsValid ();
+}
+
+PipeOStream::~PipeOStream ()
+{
+	Cleanup ();
+}
+
+bool PipeOStream::IsValid () const
+{
+	return m_fd != -1;
+}
+
+void PipeOStream::Cleanup ()
+{
+	if (!IsValid ())
+		return;
+
+	close (m_fd);
+	m_fd = -1;
+}
+
+} // namespace MMD
@@ -26,4 +26,13 @@ const char* ProcessMemoryReaderDataPtr::Get ()
 	return nullptr; // Not a good idea...
 }
 
+bool ProcessMemoryReaderDataPtr::CopyTo (size_t offset, size_t size, void* pBuffer)
+{
+	if (offset + size > m_maxSize)
+		return false;
+
+	// Read directly into the buffer (no need for an intermediate copy)
+	return ReadProcessMemoryInto (m_taskPort, m_startAddress + offset, pBuffer, size);
+}
+
 } // namespace MMD
\ No newline at end of file
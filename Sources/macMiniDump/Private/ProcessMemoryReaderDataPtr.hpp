@@ -17,6 +17,7 @@ public:
 
 	virtual const char* Get (size_t offset, size_t size) override;
 	virtual const char* Get () override;
+	virtual bool		CopyTo (size_t offset, size_t size, void* pBuffer) override;
 
 private:
 	mach_port_t	 m_taskPort;
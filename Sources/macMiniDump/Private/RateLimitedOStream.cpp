@@ -0,0 +1,157 @@
+#include "MMD/RateLimitedOStream.hpp"
+
+#include <algorithm>
+#include <cassert>
+#include <thread>
+
+namespace MMD {
+
+RateLimitedOStream::RateLimitedOStream (IRandomAccessBinaryOStream* pOStream,
+										uint64_t					bytesPerSecond,
+										size_t						burstSize /*= DefaultBurstSize*/,
+										uint32_t					latencyThresholdMs /*= 0*/):
+	m_pOStream (pOStream),
+	m_nanosecondsPerByte (1e9 / bytesPerSecond),
+	m_burstSize (burstSize),
+	m_burstDuration (std::chrono::nanoseconds (uint64_t (burstSize * m_nanosecondsPerByte))),
+	m_latencyThreshold (std::chrono::milliseconds (latencyThresholdMs)),
+	m_theoreticalArrival (Clock::now () - m_burstDuration),
+	m_pausedUntil (),
+	m_throttledNanoseconds (0),
+	m_pauseCount (0)
+{
+	assert (m_pOStream != nullptr);
+	assert (bytesPerSecond > 0 && burstSize > 0);
+}
+
+bool RateLimitedOStream::Write (const void* pData, size_t size)
+{
+	const char* pCurr = static_cast<const char*> (pData);
+	while (size > 0) {
+		const size_t pieceSize = std::min (size, m_burstSize);
+		WaitForTokens (pieceSize);
+
+		const Clock::time_point start = Clock::now ();
+		if (!m_pOStream->Write (pCurr, pieceSize))
+			return false;
+
+		CheckLatency (Clock::now () - start);
+
+		pCurr += pieceSize;
+		size -= pieceSize;
+	}
+
+	return true;
+}
+
+bool RateLimitedOStream::Flush ()
+{
+	return m_pOStream->Flush ();
+}
+
+size_t RateLimitedOStream::GetPosition ()
+{
+	return m_pOStream->GetPosition ();
+}
+
+void RateLimitedOStream::SetPosition (size_t newPos)
+{
+	m_pOStream->SetPosition (newPos);
+}
+
+size_t RateLimitedOStream::GetSize ()
+{
+	return m_pOStream->GetSize ();
+}
+
+bool RateLimitedOStream::SetSize (size_t newSize)
+{
+	return m_pOStream->SetSize (newSize);
+}
+
+bool RateLimitedOStream::WriteAt (const void* pData, size_t size, size_t offset)
+{
+	const char* pCurr = static_cast<const char*> (pData);
+	while (size > 0) {
+		const size_t pieceSize = std::min (size, m_burstSize);
+		WaitForTokens (pieceSize);
+
+		const Clock::time_point start = Clock::now ();
+		if (!m_pOStream->WriteAt (pCurr, pieceSize, offset))
+			return false;
+
+		CheckLatency (Clock::now () - start);
+
+		pCurr += pieceSize;
+		offset += pieceSize;
+		size -= pieceSize;
+	}
+
+	return true;
+}
+
+bool RateLimitedOStream::SupportsConcurrentWriteAt () const
+{
+	return m_pOStream->SupportsConcurrentWriteAt ();
+}
+
+bool RateLimitedOStream::PunchHole (size_t offset, size_t size)
+{
+	return m_pOStream->PunchHole (offset, size);
+}
+
+bool RateLimitedOStream::Preallocate (size_t size)
+{
+	return m_pOStream->Preallocate (size);
+}
+
+RateLimitedOStream::~RateLimitedOStream () = default;
+
+uint64_t RateLimitedOStream::GetThrottledNanoseconds () const
+{
+	return m_throttledNanoseconds;
+}
+
+uint64_t RateLimitedOStream::GetPauseCount () const
+{
+	return m_pauseCount;
+}
+
+// The bucket is tracked by the time at which it would be empty (the "theoretical arrival time" of the generic cell rate
+//   algorithm): taking tokens moves it forward by the time it takes to earn them, and the tokens are available once it
+//   is at most burstDuration ahead of the current time. Tokens are taken right away, even if they have to be waited
+//   for, so every writer waits for its own turn.
+void RateLimitedOStream::WaitForTokens (size_t size)
+{
+	const Clock::duration cost = std::chrono::nanoseconds (uint64_t (size * m_nanosecondsPerByte));
+
+	Clock::time_point writeTime;
+	{
+		std::lock_guard<std::mutex> lock (m_mutex);
+
+		const Clock::time_point now = Clock::now ();
+		m_theoreticalArrival		= std::max (m_theoreticalArrival, now - m_burstDuration) + cost;
+		writeTime					= std::max (m_theoreticalArrival - m_burstDuration, m_pausedUntil);
+		if (writeTime <= now)
+			return;
+	}
+
+	const Clock::time_point sleepStart = Clock::now ();
+	std::this_thread::sleep_until (writeTime);
+
+	const Clock::duration throttled = Clock::now () - sleepStart;
+	m_throttledNanoseconds += std::chrono::duration_cast<std::chrono::nanoseconds> (throttled).count ();
+}
+
+void RateLimitedOStream::CheckLatency (Clock::duration latency)
+{
+	if (m_latencyThreshold == Clock::duration::zero () || latency <= m_latencyThreshold)
+		return;
+
+	std::lock_guard<std::mutex> lock (m_mutex);
+
+	m_pausedUntil = std::max (m_pausedUntil, Clock::now () + latency);
+	++m_pauseCount;
+}
+
+} // namespace MMD
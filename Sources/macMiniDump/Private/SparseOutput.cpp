@@ -0,0 +1,124 @@
+#include "SparseOutput.hpp"
+
+#include <algorithm>
+#include <cstring>
+
+#if defined __x86_64__
+	#include <immintrin.h>
+#elif defined __arm64__
+	#include <arm_neon.h>
+#endif
+
+namespace MMD {
+namespace {
+
+const char Zeroes[SparsePageSize] = {};
+
+bool IsZeroMemoryScalar (const char* pData, size_t size)
+{
+	uint64_t accumulator = 0;
+
+	size_t i = 0;
+	for (; i + sizeof (uint64_t) <= size; i += sizeof (uint64_t)) {
+		uint64_t word;
+		memcpy (&word, pData + i, sizeof word);
+
+		accumulator |= word;
+	}
+
+	for (; i < size; ++i)
+		accumulator |= uint8_t (pData[i]);
+
+	return accumulator == 0;
+}
+
+// The vectorized variants check 64 bytes at a time (bailing out early on data, which is the common case for non-zero
+// pages), and leave the remainder to the scalar variant
+#if defined __x86_64__
+bool IsZeroMemorySSE2 (const char* pData, size_t size)
+{
+	constexpr size_t BlockSize = 4 * sizeof (__m128i);
+
+	size_t i = 0;
+	for (; i + BlockSize <= size; i += BlockSize) {
+		const __m128i* pBlock	   = reinterpret_cast<const __m128i*> (pData + i);
+		const __m128i  lower	   = _mm_or_si128 (_mm_loadu_si128 (pBlock), _mm_loadu_si128 (pBlock + 1));
+		const __m128i  upper	   = _mm_or_si128 (_mm_loadu_si128 (pBlock + 2), _mm_loadu_si128 (pBlock + 3));
+		const __m128i  accumulator = _mm_or_si128 (lower, upper);
+
+		if (_mm_movemask_epi8 (_mm_cmpeq_epi8 (accumulator, _mm_setzero_si128 ())) != 0xFFFF)
+			return false;
+	}
+
+	return IsZeroMemoryScalar (pData + i, size - i);
+}
+
+__attribute__ ((target ("avx2"))) bool IsZeroMemoryAVX2 (const char* pData, size_t size)
+{
+	constexpr size_t BlockSize = 2 * sizeof (__m256i);
+
+	size_t i = 0;
+	for (; i + BlockSize <= size; i += BlockSize) {
+		const __m256i* pBlock	   = reinterpret_cast<const __m256i*> (pData + i);
+		const __m256i  accumulator = _mm256_or_si256 (_mm256_loadu_si256 (pBlock), _mm256_loadu_si256 (pBlock + 1));
+
+		if (!_mm256_testz_si256 (accumulator, accumulator))
+			return false;
+	}
+
+	return IsZeroMemoryScalar (pData + i, size - i);
+}
+#elif defined __arm64__
+bool IsZeroMemoryNEON (const char* pData, size_t size)
+{
+	constexpr size_t BlockSize = 4 * sizeof (uint8x16_t);
+
+	size_t i = 0;
+	for (; i + BlockSize <= size; i += BlockSize) {
+		const uint8_t*	 pBlock		 = reinterpret_cast<const uint8_t*> (pData + i);
+		const uint8x16_t accumulator = vorrq_u8 (vorrq_u8 (vld1q_u8 (pBlock), vld1q_u8 (pBlock + 16)),
+												 vorrq_u8 (vld1q_u8 (pBlock + 32), vld1q_u8 (pBlock + 48)));
+
+		if (vmaxvq_u8 (accumulator) != 0)
+			return false;
+	}
+
+	return IsZeroMemoryScalar (pData + i, size - i);
+}
+#endif
+
+} // namespace
+
+bool IsZeroMemory (const void* pData, size_t size)
+{
+	const char* pBytes = static_cast<const char*> (pData);
+
+#if defined __x86_64__
+	static const bool hasAVX2 = __builtin_cpu_supports ("avx2");
+
+	return hasAVX2 ? IsZeroMemoryAVX2 (pBytes, size) : IsZeroMemorySSE2 (pBytes, size);
+#elif defined __arm64__
+	return IsZeroMemoryNEON (pBytes, size);
+#else
+	return IsZeroMemoryScalar (pBytes, size);
+#endif
+}
+
+bool ZeroOStreamRange (IRandomAccessBinaryOStream* pOStream, size_t offset, size_t size, size_t zeroFrom)
+{
+	if (offset >= zeroFrom || size == 0)
+		return true;
+
+	const size_t sizeToClear = std::min (size, zeroFrom - offset);
+	if (pOStream->PunchHole (offset, sizeToClear))
+		return true;
+
+	for (size_t cleared = 0; cleared < sizeToClear; cleared += sizeof Zeroes) {
+		if (!pOStream->WriteAt (Zeroes, std::min (sizeToClear - cleared, sizeof Zeroes), offset + cleared))
+			return false;
+	}
+
+	return true;
+}
+
+} // namespace MMD
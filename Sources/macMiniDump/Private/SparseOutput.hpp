@@ -0,0 +1,54 @@
+#ifndef MMD_SPARSEOUTPUT
+#define MMD_SPARSEOUTPUT
+
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+
+#include "MMD/IRandomAccessBinaryOStream.hpp"
+
+namespace MMD {
+
+// Only whole pages of zeroes (aligned in the file) are skipped when writing sparse output
+constexpr size_t SparsePageSize = 4'096;
+
+// Uses the widest vector instructions available (AVX2 or SSE2 on x86-64, NEON on arm64)
+bool IsZeroMemory (const void* pData, size_t size);
+
+// Splits size bytes at pData, which are to be written at fileOffset, into alternating runs of data and of zero pages.
+// onRun (offset, size, isZero) is called for every run in order, offset is relative to pData. Stops if onRun returns
+// false.
+template<typename OnRun>
+bool ForEachSparseRun (const char* pData, size_t size, uint64_t fileOffset, OnRun onRun)
+{
+	size_t runStart	 = 0;
+	bool   runIsZero = false;
+	size_t pos		 = 0;
+	while (pos < size) {
+		const size_t pageEnd	= std::min (size, pos + SparsePageSize - (fileOffset + pos) % SparsePageSize);
+		const bool	 isZeroPage = pageEnd - pos == SparsePageSize && IsZeroMemory (pData + pos, SparsePageSize);
+
+		if (isZeroPage != runIsZero && pos > runStart) {
+			if (!onRun (runStart, pos - runStart, runIsZero))
+				return false;
+
+			runStart = pos;
+		}
+
+		runIsZero = isZeroPage;
+		pos		  = pageEnd;
+	}
+
+	return pos == runStart || onRun (runStart, pos - runStart, runIsZero);
+}
+
+// Makes the given range of the stream read back as zeroes, without writing it if possible. Bytes at or beyond zeroFrom
+// (the size of the stream before writing started) are never written, so they are zeroes (holes) already. The rest is
+// deallocated with PunchHole, or overwritten with zeroes as a fallback (which might change the stream position).
+bool ZeroOStreamRange (IRandomAccessBinaryOStream* pOStream, size_t offset, size_t size, size_t zeroFrom);
+
+} // namespace MMD
+
+#endif // MMD_SPARSEOUTPUT
@@ -0,0 +1,136 @@
+#include "SpoolFormat.hpp"
+
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <cinttypes>
+#include <cstdio>
+#include <cstring>
+
+#include "MMD/CRC32C.hpp"
+#include "MMD/FileDescriptorIO.hpp"
+
+namespace MMD {
+namespace SpoolFormat {
+
+bool FormatFilePath (const char* directoryPath, const char* fileName, char* pPathOut)
+{
+	const int length = snprintf (pPathOut, PATH_MAX, "%s/%s", directoryPath, fileName);
+
+	return length >= 0 && length < PATH_MAX;
+}
+
+bool FormatChunkPath (const char* directoryPath, uint64_t chunkIndex, char* pPathOut)
+{
+	const int length = snprintf (pPathOut, PATH_MAX, "%s/chunk%06" PRIu64 ".mmdchunk", directoryPath, chunkIndex);
+
+	return length >= 0 && length < PATH_MAX;
+}
+
+bool WriteFileAtomically (const char* filePath, const void* pData, size_t size)
+{
+	char	  temporaryPath[PATH_MAX];
+	const int length = snprintf (temporaryPath, sizeof temporaryPath, "%s.tmp", filePath);
+	if (length < 0 || length >= PATH_MAX)
+		return false;
+
+	const int fd = open (temporaryPath, O_WRONLY | O_CREAT | O_TRUNC, 0666);
+	if (fd == -1)
+		return false;
+
+	const bool written = WriteAll (fd, pData, size) && fsync (fd) == 0;
+	close (fd);
+
+	if (!written || rename (temporaryPath, filePath) != 0) {
+		unlink (temporaryPath);
+
+		return false;
+	}
+
+	return true;
+}
+
+bool ReadFile (const char* filePath, Vector<char>* pContentOut)
+{
+	const int fd = open (filePath, O_RDONLY);
+	if (fd == -1)
+		return false;
+
+	struct stat fileInfo;
+	bool		succeeded = fstat (fd, &fileInfo) == 0;
+	if (succeeded) {
+		try {
+			pContentOut->resize (fileInfo.st_size);
+		} catch (const std::bad_alloc&) {
+			succeeded = false;
+		}
+	}
+
+	succeeded = succeeded && PReadAll (fd, pContentOut->data (), pContentOut->size (), 0);
+	close (fd);
+
+	return succeeded;
+}
+
+bool CreateManifest (const ManifestHeader& header, const Vector<ChunkEntry>& chunks, Vector<char>* pManifestOut)
+{
+	const size_t chunksSize = chunks.size () * sizeof (ChunkEntry);
+	try {
+		pManifestOut->resize (sizeof header + chunksSize + sizeof (uint32_t));
+	} catch (const std::bad_alloc&) {
+		return false;
+	}
+
+	char* pManifest = pManifestOut->data ();
+	memcpy (pManifest, &header, sizeof header);
+	memcpy (pManifest + sizeof header, chunks.data (), chunksSize);
+
+	const uint32_t crc = CRC32C (pManifest, sizeof header + chunksSize);
+	memcpy (pManifest + sizeof header + chunksSize, &crc, sizeof crc);
+
+	return true;
+}
+
+bool ParseManifest (const Vector<char>& manifest, ManifestHeader* pHeaderOut, Vector<ChunkEntry>* pChunksOut)
+{
+	if (manifest.size () < sizeof (ManifestHeader) + sizeof (uint32_t))
+		return false;
+
+	const size_t checksummedSize = manifest.size () - sizeof (uint32_t);
+	uint32_t	 crc;
+	memcpy (&crc, manifest.data () + checksummedSize, sizeof crc);
+	if (crc != CRC32C (manifest.data (), checksummedSize))
+		return false;
+
+	ManifestHeader& header = *pHeaderOut;
+	memcpy (&header, manifest.data (), sizeof header);
+
+	const size_t chunksSize = checksummedSize - sizeof header;
+	if (header.magic != ManifestMagic || header.version != Version || header.chunkSize == 0 ||
+		chunksSize % sizeof (ChunkEntry) != 0 || chunksSize / sizeof (ChunkEntry) != header.chunkCount)
+		return false;
+
+	try {
+		pChunksOut->resize (header.chunkCount);
+	} catch (const std::bad_alloc&) {
+		return false;
+	}
+
+	memcpy (pChunksOut->data (), manifest.data () + sizeof header, chunksSize);
+
+	// Every chunk but the last one is full
+	uint64_t totalSize = 0;
+	for (size_t i = 0; i < pChunksOut->size (); ++i) {
+		const uint64_t chunkSize = (*pChunksOut)[i].size;
+		if (chunkSize > header.chunkSize || (chunkSize != header.chunkSize && i + 1 != pChunksOut->size ()))
+			return false;
+
+		totalSize += chunkSize;
+	}
+
+	return totalSize == header.totalSize;
+}
+
+} // namespace SpoolFormat
+} // namespace MMD
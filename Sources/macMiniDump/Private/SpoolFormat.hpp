@@ -0,0 +1,69 @@
+#ifndef MMD_SPOOLFORMAT
+#define MMD_SPOOLFORMAT
+
+#pragma once
+
+#include <limits.h>
+
+#include <cstddef>
+#include <cstdint>
+
+#include "ZoneAllocator.hpp"
+
+namespace MMD {
+namespace SpoolFormat {
+
+// A spool is a directory with the data cut into chunk files (chunk000000.mmdchunk, chunk000001.mmdchunk, ...) of
+//   chunkSize bytes (only the last one might be shorter), and a manifest (manifest.mmdspool), listing the size and the
+//   CRC-32C checksum of every chunk. The manifest is written last, so a spool is complete if it has one.
+//   Manifest: [ManifestHeader][ChunkEntry 0]...[ChunkEntry N-1][uint32_t CRC-32C of everything before it]
+
+constexpr uint32_t ManifestMagic = 0x4C4F5053; // "SPOL"
+constexpr uint32_t ProgressMagic = 0x474F5250; // "PROG"
+constexpr uint32_t Version		 = 1;
+
+constexpr const char* ManifestFileName = "manifest.mmdspool";
+// Upload progress of the spool (see SpoolUploader), in the spool directory
+constexpr const char* ProgressFileName = "progress.mmdspool";
+
+struct ManifestHeader {
+	uint32_t magic		= ManifestMagic;
+	uint32_t version	= Version;
+	uint64_t spoolId	= 0; // Random, identifies the spool for transports
+	uint64_t chunkSize	= 0;
+	uint64_t chunkCount = 0;
+	uint64_t totalSize	= 0;
+};
+
+struct ChunkEntry {
+	uint64_t size	  = 0;
+	uint32_t crc32c	  = 0;
+	uint32_t reserved = 0;
+};
+
+struct Progress {
+	uint32_t magic				  = ProgressMagic;
+	uint32_t version			  = Version;
+	uint64_t spoolId			  = 0;
+	uint64_t acknowledgedChunks	  = 0; // Chunks are sent in order
+	uint32_t manifestAcknowledged = 0; // The manifest is sent after every chunk
+	uint32_t crc32c				  = 0; // Checksum of the fields before it
+};
+
+// pPathOut must have room for PATH_MAX characters
+bool FormatFilePath (const char* directoryPath, const char* fileName, char* pPathOut);
+bool FormatChunkPath (const char* directoryPath, uint64_t chunkIndex, char* pPathOut);
+
+// Writes a temporary file, then renames it, so the file is either complete or missing
+bool WriteFileAtomically (const char* filePath, const void* pData, size_t size);
+bool ReadFile (const char* filePath, Vector<char>* pContentOut);
+
+// Serializes a manifest, with its checksum
+bool CreateManifest (const ManifestHeader& header, const Vector<ChunkEntry>& chunks, Vector<char>* pManifestOut);
+// Returns false if the manifest is malformed, or its checksum does not match
+bool ParseManifest (const Vector<char>& manifest, ManifestHeader* pHeaderOut, Vector<ChunkEntry>* pChunksOut);
+
+} // namespace SpoolFormat
+} // namespace MMD
+
+#endif // MMD_SPOOLFORMAT
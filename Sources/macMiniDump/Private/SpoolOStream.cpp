@@ -0,0 +1,203 @@
+#include "MMD/SpoolOStream.hpp"
+
+#include <fcntl.h>
+#include <stdlib.h>
+#include <unistd.h>
+
+#include <algorithm>
+
+#include "MMD/CRC32C.hpp"
+#include "MMD/FileDescriptorIO.hpp"
+#include "SpoolFormat.hpp"
+#include "ZoneAllocator.hpp"
+
+namespace MMD {
+
+struct SpoolOStream::State : public ZoneAllocated {
+	String	 directoryPath;
+	size_t	 chunkSize;
+	uint64_t spoolId;
+
+	Vector<SpoolFormat::ChunkEntry> chunks;
+
+	int		 chunkFd		  = -1; // The chunk being written
+	size_t	 currentChunkSize = 0;
+	uint32_t currentChunkCRC  = 0;
+	uint64_t totalSize		  = 0;
+	bool	 failed			  = false;
+	bool	 finished		  = false;
+};
+
+SpoolOStream::SpoolOStream (const char* directoryPath, size_t chunkSize /*= DefaultChunkSize*/): m_pState (new State)
+{
+	m_pState->chunkSize = chunkSize;
+	arc4random_buf (&m_pState->spoolId, sizeof m_pState->spoolId);
+
+	try {
+		m_pState->directoryPath = directoryPath;
+	} catch (const std::bad_alloc&) {
+		m_pState->failed = true;
+	}
+}
+
+bool SpoolOStream::Write (const void* pData, size_t size)
+{
+	State& state = *m_pState;
+	if (state.failed || state.finished)
+		return false;
+
+	const char* pCurr = static_cast<const char*> (pData);
+	while (size > 0) {
+		if (state.chunkFd == -1 && !OpenChunk ())
+			return false;
+
+		const size_t toWrite = std::min (size, state.chunkSize - state.currentChunkSize);
+		if (!WriteAll (state.chunkFd, pCurr, toWrite)) {
+			state.failed = true;
+
+			return false;
+		}
+
+		state.currentChunkCRC = CRC32C (pCurr, toWrite, state.currentChunkCRC);
+		state.currentChunkSize += toWrite;
+		state.totalSize += toWrite;
+		pCurr += toWrite;
+		size -= toWrite;
+
+		if (state.currentChunkSize == state.chunkSize && !CloseChunk ())
+			return false;
+	}
+
+	return true;
+}
+
+bool SpoolOStream::Flush ()
+{
+	const State& state = *m_pState;
+	if (state.failed)
+		return false;
+
+	return state.chunkFd == -1 || fsync (state.chunkFd) == 0;
+}
+
+SpoolOStream::~SpoolOStream ()
+{
+	if (m_pState->chunkFd != -1)
+		close (m_pState->chunkFd);
+}
+
+bool SpoolOStream::Finish ()
+{
+	State& state = *m_pState;
+	if (state.failed || state.finished)
+		return false;
+
+	state.finished = true;
+	if (state.chunkFd != -1 && !CloseChunk ())
+		return false;
+
+	SpoolFormat::ManifestHeader header;
+	header.spoolId	  = state.spoolId;
+	header.chunkSize  = state.chunkSize;
+	header.chunkCount = state.chunks.size ();
+	header.totalSize  = state.totalSize;
+
+	Vector<char> manifest;
+	char		 manifestPath[PATH_MAX];
+	if (!SpoolFormat::CreateManifest (header, state.chunks, &manifest) ||
+		!SpoolFormat::FormatFilePath (state.directoryPath.c_str (), SpoolFormat::ManifestFileName, manifestPath) ||
+		!SpoolFormat::WriteFileAtomically (manifestPath, manifest.data (), manifest.size ())) {
+		state.failed = true;
+
+		return false;
+	}
+
+	return true;
+}
+
+bool SpoolOStream::IsValid () const
+{
+	return !m_pState->failed;
+}
+
+bool SpoolOStream::OpenChunk ()
+{
+	State& state = *m_pState;
+
+	char chunkPath[PATH_MAX];
+	if (!SpoolFormat::FormatChunkPath (state.directoryPath.c_str (), state.chunks.size (), chunkPath)) {
+		state.failed = true;
+
+		return false;
+	}
+
+	state.chunkFd = open (chunkPath, O_WRONLY | O_CREAT | O_TRUNC, 0666);
+	if (state.chunkFd == -1) {
+		state.failed = true;
+
+		return false;
+	}
+
+	state.currentChunkSize = 0;
+	state.currentChunkCRC  = 0;
+
+	return true;
+}
+
+// Chunks are synced before they are listed, so the manifest never refers to data not on disk
+bool SpoolOStream::CloseChunk ()
+{
+	State& state = *m_pState;
+
+	const bool synced = fsync (state.chunkFd) == 0;
+	close (state.chunkFd);
+	state.chunkFd = -1;
+	if (!synced) {
+		state.failed = true;
+
+		return false;
+	}
+
+	SpoolFormat::ChunkEntry entry;
+	entry.size	 = state.currentChunkSize;
+	entry.crc32c = state.currentChunkCRC;
+
+	try {
+		state.chunks.push_back (entry);
+	} catch (const std::bad_alloc&) {
+		state.failed = true;
+
+		return false;
+	}
+
+	return true;
+}
+
+bool AssembleSpool (const char* directoryPath, ISequentialBinaryOStream* pOStream)
+{
+	char		 manifestPath[PATH_MAX];
+	Vector<char> manifest;
+
+	SpoolFormat::ManifestHeader		header;
+	Vector<SpoolFormat::ChunkEntry> chunks;
+	if (!SpoolFormat::FormatFilePath (directoryPath, SpoolFormat::ManifestFileName, manifestPath) ||
+		!SpoolFormat::ReadFile (manifestPath, &manifest) || !SpoolFormat::ParseManifest (manifest, &header, &chunks))
+		return false;
+
+	Vector<char> chunk;
+	for (size_t i = 0; i < chunks.size (); ++i) {
+		char chunkPath[PATH_MAX];
+		if (!SpoolFormat::FormatChunkPath (directoryPath, i, chunkPath) || !SpoolFormat::ReadFile (chunkPath, &chunk))
+			return false;
+
+		if (chunk.size () != chunks[i].size || CRC32C (chunk.data (), chunk.size ()) != chunks[i].crc32c)
+			return false;
+
+		if (!pOStream->Write (chunk.data (), chunk.size ()))
+			return false;
+	}
+
+	return true;
+}
+
+} // namespace MMD
@@ -0,0 +1,158 @@
+#include "MMD/SpoolUploader.hpp"
+
+#include <cstddef>
+#include <cstring>
+
+#include "Logging.hpp"
+#include "MMD/CRC32C.hpp"
+#include "SpoolFormat.hpp"
+#include "ZoneAllocator.hpp"
+
+namespace MMD {
+
+namespace {
+
+uint32_t CalculateProgressCRC32C (const SpoolFormat::Progress& progress)
+{
+	return CRC32C (&progress, offsetof (SpoolFormat::Progress, crc32c));
+}
+
+} // namespace
+
+struct SpoolUploader::State : public ZoneAllocated {
+	String			 directoryPath;
+	ISpoolTransport* pTransport;
+
+	Vector<char>					manifest;
+	SpoolFormat::ManifestHeader		header;
+	Vector<SpoolFormat::ChunkEntry> chunks;
+
+	SpoolFormat::Progress progress;
+	uint64_t			  sentChunks = 0;
+	bool				  valid		 = false;
+};
+
+SpoolUploader::SpoolUploader (const char* spoolDirectoryPath, ISpoolTransport* pTransport): m_pState (new State)
+{
+	State& state	 = *m_pState;
+	state.pTransport = pTransport;
+
+	try {
+		state.directoryPath = spoolDirectoryPath;
+	} catch (const std::bad_alloc&) {
+		return;
+	}
+
+	char manifestPath[PATH_MAX];
+	if (!SpoolFormat::FormatFilePath (spoolDirectoryPath, SpoolFormat::ManifestFileName, manifestPath) ||
+		!SpoolFormat::ReadFile (manifestPath, &state.manifest) ||
+		!SpoolFormat::ParseManifest (state.manifest, &state.header, &state.chunks)) {
+		MMD_DEBUGLOG_LINE << "No valid manifest in spool " << spoolDirectoryPath;
+
+		return;
+	}
+
+	state.progress.spoolId = state.header.spoolId;
+	state.valid			   = true;
+
+	// Progress of an other spool (e.g. one written into the same directory before) is ignored
+	if (!LoadProgress ()) {
+		state.progress.acknowledgedChunks	= 0;
+		state.progress.manifestAcknowledged = 0;
+	}
+}
+
+SpoolUploader::~SpoolUploader () = default;
+
+bool SpoolUploader::Upload ()
+{
+	State& state = *m_pState;
+	if (!state.valid)
+		return false;
+
+	Vector<char> chunk;
+	for (uint64_t i = state.progress.acknowledgedChunks; i < state.chunks.size (); ++i) {
+		const SpoolFormat::ChunkEntry& entry = state.chunks[i];
+
+		char chunkPath[PATH_MAX];
+		if (!SpoolFormat::FormatChunkPath (state.directoryPath.c_str (), i, chunkPath) ||
+			!SpoolFormat::ReadFile (chunkPath, &chunk))
+			return false;
+
+		if (chunk.size () != entry.size || CRC32C (chunk.data (), chunk.size ()) != entry.crc32c) {
+			MMD_DEBUGLOG_LINE << "Chunk " << i << " of spool " << state.directoryPath.c_str () << " is damaged";
+
+			return false;
+		}
+
+		if (!state.pTransport->SendChunk (state.header.spoolId, i, chunk.data (), chunk.size (), entry.crc32c))
+			return false;
+
+		++state.sentChunks;
+		state.progress.acknowledgedChunks = i + 1;
+		if (!SaveProgress ())
+			return false;
+	}
+
+	if (state.progress.manifestAcknowledged != 0)
+		return true;
+
+	if (!state.pTransport->SendManifest (state.header.spoolId, state.manifest.data (), state.manifest.size ()))
+		return false;
+
+	state.progress.manifestAcknowledged = 1;
+
+	return SaveProgress ();
+}
+
+uint64_t SpoolUploader::GetChunkCount () const
+{
+	return m_pState->chunks.size ();
+}
+
+uint64_t SpoolUploader::GetAcknowledgedChunkCount () const
+{
+	return m_pState->progress.acknowledgedChunks;
+}
+
+uint64_t SpoolUploader::GetSentChunkCount () const
+{
+	return m_pState->sentChunks;
+}
+
+bool SpoolUploader::LoadProgress ()
+{
+	State& state = *m_pState;
+
+	char		 progressPath[PATH_MAX];
+	Vector<char> content;
+	if (!SpoolFormat::FormatFilePath (state.directoryPath.c_str (), SpoolFormat::ProgressFileName, progressPath) ||
+		!SpoolFormat::ReadFile (progressPath, &content) || content.size () != sizeof (SpoolFormat::Progress))
+		return false;
+
+	SpoolFormat::Progress progress;
+	memcpy (&progress, content.data (), sizeof progress);
+	if (progress.magic != SpoolFormat::ProgressMagic || progress.version != SpoolFormat::Version ||
+		progress.crc32c != CalculateProgressCRC32C (progress) || progress.spoolId != state.header.spoolId ||
+		progress.acknowledgedChunks > state.chunks.size ())
+		return false;
+
+	state.progress = progress;
+
+	return true;
+}
+
+// Written atomically: a torn progress file would restart the upload from the first chunk
+bool SpoolUploader::SaveProgress ()
+{
+	State& state = *m_pState;
+
+	state.progress.crc32c = CalculateProgressCRC32C (state.progress);
+
+	char progressPath[PATH_MAX];
+
+	return SpoolFormat::FormatFilePath (state.directoryPath.c_str (), SpoolFormat::ProgressFileName, progressPath) &&
+		   SpoolFormat::WriteFileAtomically (progressPath, &state.progress, sizeof state.progress);
+}
+
+} // namespace MMD
@@ -0,0 +1,40 @@
+#include "TaskMemoryReader.hpp"
+
+#include "ReadProcessMemory.hpp"
+
+namespace MMD {
+
+TaskMemoryReader::TaskMemoryReader (mach_port_t				taskPort,
+									const MemoryRegionList& memoryRegions,
+									const ModuleList&		moduleList):
+	m_taskPort (taskPort),
+	m_memoryRegions (memoryRegions),
+	m_moduleList (moduleList)
+{
+}
+
+bool TaskMemoryReader::Read (uint64_t address, size_t size, void* pOut) const
+{
+	return ReadProcessMemoryInto (m_taskPort, address, pOut, size);
+}
+
+bool TaskMemoryReader::IsExecutable (uint64_t address) const
+{
+	MemoryRegionInfo regionInfo;
+
+	return m_memoryRegions.GetRegionInfoForAddress (address, &regionInfo) && (regionInfo.prot & MemProtExecute);
+}
+
+bool TaskMemoryReader::FindImage (uint64_t address, uint64_t* pLoadAddressOut, const char** ppHeaderOut) const
+{
+	const ModuleList::ModuleInfo* pModuleInfo = nullptr;
+	if (!m_moduleList.GetModuleInfoForAddress (address, &pModuleInfo) || !pModuleInfo->headerAndLoadCommandBytes)
+		return false;
+
+	*pLoadAddressOut = pModuleInfo->loadAddress;
+	*ppHeaderOut	 = pModuleInfo->headerAndLoadCommandBytes.get ();
+
+	return true;
+}
+
+} // namespace MMD
@@ -0,0 +1,34 @@
+#ifndef MMD_TASKMEMORYREADER
+#define MMD_TASKMEMORYREADER
+
+#pragma once
+
+#include <mach/port.h>
+
+#include "MMD/IProcessMemoryReader.hpp"
+
+#include "MemoryRegionList.hpp"
+#include "ModuleList.hpp"
+
+namespace MMD {
+
+// Reads the memory of a live process through its task port, for the stack walker
+class TaskMemoryReader final : public IProcessMemoryReader {
+public:
+	TaskMemoryReader (mach_port_t taskPort, const MemoryRegionList& memoryRegions, const ModuleList& moduleList);
+
+	bool Read (uint64_t address, size_t size, void* pOut) const override;
+	bool IsExecutable (uint64_t address) const override;
+	bool FindImage (uint64_t address, uint64_t* pLoadAddressOut, const char** ppHeaderOut) const override;
+
+	using IProcessMemoryReader::Read;
+
+private:
+	mach_port_t				m_taskPort;
+	const MemoryRegionList& m_memoryRegions;
+	const ModuleList&		m_moduleList;
+};
+
+} // namespace MMD
+
+#endif // MMD_TASKMEMORYREADER
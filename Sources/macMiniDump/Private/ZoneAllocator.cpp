@@ -48,6 +48,11 @@ void* Malloc (size_t size)
 	return malloc_zone_malloc (GetZone (), size);
 }
 
+void* Calloc (size_t size)
+{
+	return malloc_zone_calloc (GetZone (), 1, size);
+}
+
 void* MallocAligned (size_t size, size_t alignment)
 {
 	return malloc_zone_memalign (GetZone (), alignment, size);
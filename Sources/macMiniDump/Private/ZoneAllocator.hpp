@@ -24,6 +24,7 @@ namespace MMD {
 malloc_zone_t* GetZone ();
 
 void* Malloc (size_t size);
+void* Calloc (size_t size); // Zeroed memory
 void* MallocAligned (size_t size, size_t alignment);
 void  Free (void* ptr);
 
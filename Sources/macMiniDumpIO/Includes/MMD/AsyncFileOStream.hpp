@@ -0,0 +1,93 @@
+#ifndef MMD_ASYNCFILEOSTREAM
+#define MMD_ASYNCFILEOSTREAM
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+
+#include "IRandomAccessBinaryOStream.hpp"
+
+namespace MMD {
+
+// File stream writing asynchronously, for tools processing many core files at once (e.g. on a server). Writes are
+//   copied into a fixed set of buffers (contiguous writes fill the same buffer), full buffers are queued, and the queue
+//   is submitted in batches: through io_uring if the kernel allows it (Linux), otherwise to a pool of threads calling
+//   pwrite. Writers only wait when every buffer is in use. Writes only fail later (on Flush) if the I/O fails.
+//   Positional writes can be concurrent: space in a buffer is reserved under a lock, but copied without it. A write
+//   overlapping a pending one (e.g. a header rewritten at the end) waits for every pending write to complete first, so
+//   that it lands last; concurrent writes to the same range land in any order. Holes are not supported (a hole could
+//   be punched before a pending write lands), so sparse output falls back to writing zeroes.
+class AsyncFileOStream : public IRandomAccessBinaryOStream {
+public:
+	static const size_t DefaultQueueDepth = 32;
+	static const size_t DefaultBufferSize = 256 * 1'024;
+
+	// Constructors
+	AsyncFileOStream () = delete;
+	// queueDepth is the number of buffers, i.e. the most writes in flight; fd must be opened for writing
+	explicit AsyncFileOStream (int fd, size_t queueDepth = DefaultQueueDepth, size_t bufferSize = DefaultBufferSize);
+	// The file at this path must exist
+	explicit AsyncFileOStream (const char* filePath,
+							   size_t	   queueDepth = DefaultQueueDepth,
+							   size_t	   bufferSize = DefaultBufferSize);
+
+	// Inherited from IRandomAccessBinaryOStream
+	virtual bool Write (const void* pData, size_t size) override;
+
+	// Submits every buffer, waits for all writes to complete, then syncs the file. Reports if any write failed.
+	virtual bool Flush () override;
+
+	virtual size_t GetPosition () override;
+	virtual void   SetPosition (size_t newPos) override;
+
+	virtual size_t GetSize () override;
+	// Waits for all writes to complete first
+	virtual bool SetSize (size_t newSize) override;
+
+	virtual bool WriteAt (const void* pData, size_t size, size_t offset) override;
+	virtual bool SupportsConcurrentWriteAt () const override;
+	virtual bool Preallocate (size_t size) override;
+
+	// Waits for all writes to complete, but does not sync the file
+	virtual ~AsyncFileOStream ();
+
+	// Miscellaneous
+	bool IsValid () const;
+	// Otherwise, batches are submitted to the thread pool
+	bool UsesIOUring () const;
+	// Batches submitted, and writes in them (a write covers a buffer, or a part of it)
+	uint64_t GetSubmissionCount () const;
+	uint64_t GetWriteCount () const;
+
+private:
+	struct Buffer;
+	struct State;
+
+	std::unique_ptr<State> m_pState;
+
+	void Init (int fd, size_t queueDepth, size_t bufferSize);
+	void RetireCurrentBuffer ();
+	void FinishCopy (size_t bufferIndex);
+	void QueueBuffer (size_t bufferIndex);
+	void SubmitQueued ();
+	bool WaitForBuffer (std::unique_lock<std::mutex>& lock);
+	void CompleteWrite (size_t bufferIndex, bool succeeded);
+	bool OverlapsPendingWrite (size_t offset, size_t size) const;
+	bool WaitForPendingWrites (std::unique_lock<std::mutex>& lock);
+	bool Drain ();
+
+	bool InitIOUring ();
+	void ReapIOUringCompletions ();
+	bool WaitForIOUringCompletions (size_t maxInFlight);
+
+	static void* WorkerThreadMain (void* pThis);
+	void		 RunWorker ();
+	void		 StopWorkers ();
+};
+
+} // namespace MMD
+
+#endif // MMD_ASYNCFILEOSTREAM
@@ -0,0 +1,27 @@
+#ifndef MMD_FILEDESCRIPTORIO
+#define MMD_FILEDESCRIPTORIO
+
+#pragma once
+
+#include <sys/uio.h>
+
+#include <cstddef>
+
+namespace MMD {
+
+// Helpers for writing to file descriptors. Unlike plain write/writev, these keep going until everything is written
+//   (some file descriptors, e.g. pipes and sockets, might accept less data than requested at once), and retry on EINTR.
+bool WriteAll (int fd, const void* pData, size_t size);
+// Positional variant: does not use or change the file offset of fd
+bool PWriteAll (int fd, const void* pData, size_t size, size_t offset);
+bool WriteVAll (int fd, const iovec* pIOVecs, size_t count);
+
+// Reads exactly size bytes at offset (fails at the end of the file), does not use or change the file offset of fd
+bool PReadAll (int fd, void* pData, size_t size, size_t offset);
+
+// Allocates storage for the first size bytes of the file (without changing its size), where supported
+bool PreallocateAll (int fd, size_t size);
+
+} // namespace MMD
+
+#endif // MMD_FILEDESCRIPTORIO
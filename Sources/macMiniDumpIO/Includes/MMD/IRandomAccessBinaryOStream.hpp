@@ -0,0 +1,43 @@
+#ifndef MMD_IRANDOMACCESSBINARYOSTREAM
+#define MMD_IRANDOMACCESSBINARYOSTREAM
+
+#pragma once
+
+#include <cstddef>
+
+#include "ISequentialBinaryOStream.hpp"
+
+namespace MMD {
+
+class IRandomAccessBinaryOStream : public ISequentialBinaryOStream {
+public:
+	IRandomAccessBinaryOStream ();
+	IRandomAccessBinaryOStream (const IRandomAccessBinaryOStream& rhs)			  = delete;
+	IRandomAccessBinaryOStream& operator= (const IRandomAccessBinaryOStream& rhs) = delete;
+
+	virtual size_t GetPosition ()			   = 0;
+	virtual void   SetPosition (size_t newPos) = 0;
+
+	virtual size_t GetSize ()				= 0;
+	virtual bool   SetSize (size_t newSize) = 0;
+
+	// Positional write: writes data at the given offset. Optional; the default implementation seeks, then writes, so
+	// the position is changed. Streams able to do better (e.g. with pwrite) should override it, and if it can be called
+	// from multiple threads at once (for non-overlapping ranges), SupportsConcurrentWriteAt should return true.
+	virtual bool WriteAt (const void* pData, size_t size, size_t offset);
+	virtual bool SupportsConcurrentWriteAt () const;
+
+	// Deallocates the storage of the given range (without changing the size), which reads back as zeroes afterwards.
+	// Optional; the default implementation does nothing and returns false, callers should write zeroes instead then.
+	virtual bool PunchHole (size_t offset, size_t size);
+
+	// Allocates storage for size bytes in advance (without changing the size), so that writing up to that size won't
+	// run out of space. Optional; the default implementation does nothing and returns true.
+	virtual bool Preallocate (size_t size);
+
+	virtual ~IRandomAccessBinaryOStream ();
+};
+
+} // namespace MMD
+
+#endif // MMD_IRANDOMACCESSBINARYOSTREAM
@@ -0,0 +1,44 @@
+#ifndef MMD_ISEQUENTIALBINARYOSTREAM
+#define MMD_ISEQUENTIALBINARYOSTREAM
+
+#pragma once
+
+#include <sys/uio.h>
+
+#include <cstddef>
+#include <type_traits>
+
+namespace MMD {
+
+// Forward-only output stream: data is always appended, there is no way to seek (e.g. pipes, sockets)
+class ISequentialBinaryOStream {
+public:
+	ISequentialBinaryOStream ();
+	ISequentialBinaryOStream (const ISequentialBinaryOStream& rhs)			  = delete;
+	ISequentialBinaryOStream& operator= (const ISequentialBinaryOStream& rhs) = delete;
+
+	virtual bool Write (const void* pData, size_t size) = 0;
+
+	template<typename T>
+	bool Write (const T& data);
+
+	// Scatter/gather write: buffers are written one after another. Optional; the default implementation calls Write for
+	// every buffer, streams able to do better (e.g. with writev) should override it
+	virtual bool WriteV (const iovec* pIOVecs, size_t count);
+
+	virtual bool Flush () = 0;
+
+	virtual ~ISequentialBinaryOStream ();
+};
+
+template<typename T>
+bool ISequentialBinaryOStream::Write (const T& data)
+{
+	static_assert (std::is_trivially_copyable_v<T>);
+
+	return Write (reinterpret_cast<const char*> (&data), sizeof data);
+}
+
+} // namespace MMD
+
+#endif // MMD_ISEQUENTIALBINARYOSTREAM
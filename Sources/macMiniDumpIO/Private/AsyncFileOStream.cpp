@@ -0,0 +1,692 @@
+#include "MMD/AsyncFileOStream.hpp"
+
+#include <errno.h>
+#include <fcntl.h>
+#include <pthread.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <cassert>
+#include <condition_variable>
+#include <cstring>
+#include <mutex>
+#include <vector>
+
+#include "MMD/FileDescriptorIO.hpp"
+
+// liburing is not needed: the interface is simple enough to be used with system calls directly
+#if defined __linux__ && __has_include(<linux/io_uring.h>)
+	#include <linux/io_uring.h>
+	#include <sys/mman.h>
+	#include <sys/syscall.h>
+
+	#if defined __NR_io_uring_setup && defined __NR_io_uring_enter
+		#define MMD_IO_URING 1
+	#endif
+#endif
+
+namespace MMD {
+
+namespace {
+
+const size_t NoBuffer		= SIZE_MAX;
+const size_t WorkerCount	= 4;
+const size_t BatchesInQueue = 4; // The queue is submitted once it holds queueDepth / BatchesInQueue buffers
+
+#ifdef MMD_IO_URING
+// The rings shared with the kernel. Submissions are only produced, and completions only consumed, with the mutex of
+//   the stream held, so only the indices written by the kernel (the head of the submission queue, the tail of the
+//   completion queue) need atomic access.
+struct IOUring {
+	int	   fd		  = -1;
+	void*  pSQRing	  = MAP_FAILED;
+	void*  pCQRing	  = MAP_FAILED; // Same as pSQRing with IORING_FEAT_SINGLE_MMAP
+	size_t sqRingSize = 0;
+	size_t cqRingSize = 0;
+
+	io_uring_sqe* pSQEs	   = static_cast<io_uring_sqe*> (MAP_FAILED);
+	size_t		  sqesSize = 0;
+	io_uring_cqe* pCQEs	   = nullptr;
+
+	unsigned* pSQTail  = nullptr;
+	unsigned* pSQMask  = nullptr;
+	unsigned* pSQArray = nullptr;
+	unsigned* pCQHead  = nullptr;
+	unsigned* pCQTail  = nullptr;
+	unsigned* pCQMask  = nullptr;
+
+	~IOUring ()
+	{
+		if (pSQEs != MAP_FAILED)
+			munmap (pSQEs, sqesSize);
+
+		if (pCQRing != MAP_FAILED && pCQRing != pSQRing)
+			munmap (pCQRing, cqRingSize);
+
+		if (pSQRing != MAP_FAILED)
+			munmap (pSQRing, sqRingSize);
+
+		if (fd != -1)
+			close (fd);
+	}
+};
+#else
+struct IOUring {};
+#endif
+
+} // namespace
+
+struct AsyncFileOStream::Buffer {
+	char*  pData			= nullptr;
+	size_t offset			= 0; // In the file
+	size_t size				= 0; // Reserved by writers, not necessarily copied yet; 0 once the write completed
+	size_t copiesInProgress = 0;
+	bool   retired			= false; // Queued by the last copy in progress
+	iovec  ioVec			= {};	 // For io_uring; must stay valid until the write completes
+};
+
+struct AsyncFileOStream::State {
+	int	   fd;
+	size_t bufferSize;
+	size_t batchSize;
+
+	std::unique_ptr<char[]> pBufferMemory;
+	std::vector<Buffer>		buffers;
+	std::vector<size_t>		freeBuffers;
+	std::vector<size_t>		queuedBuffers;	  // Full (or abandoned) buffers, not submitted yet
+	std::vector<size_t>		submittedBuffers; // Waiting for a worker thread (thread pool only)
+	size_t					currentBuffer	 = NoBuffer; // The buffer being filled
+	size_t					copiesInProgress = 0;		 // Into any buffer
+	size_t					inFlight		 = 0;		 // Buffers submitted, but not completed
+
+	IOUring					ioUring; // Destroyed before the buffers, which in-flight writes might still use
+	bool					usesIOUring = false;
+	std::vector<pthread_t>	workers;
+	std::mutex				mutex; // Guards everything but the position
+	std::condition_variable cv;
+	bool					stopRequested = false;
+
+	size_t	 position	 = 0;
+	size_t	 size		 = 0;
+	uint64_t submissions = 0;
+	uint64_t writes		 = 0;
+	bool	 failed		 = false;
+	bool	 valid		 = false;
+};
+
+AsyncFileOStream::AsyncFileOStream (int fd,
+									size_t queueDepth /*= DefaultQueueDepth*/,
+									size_t bufferSize /*= DefaultBufferSize*/):
+	m_pState (new State)
+{
+	Init (fd, queueDepth, bufferSize);
+}
+
+AsyncFileOStream::AsyncFileOStream (const char* filePath,
+									size_t		queueDepth /*= DefaultQueueDepth*/,
+									size_t		bufferSize /*= DefaultBufferSize*/):
+	m_pState (new State)
+{
+	Init (open (filePath, O_WRONLY), queueDepth, bufferSize);
+}
+
+bool AsyncFileOStream::Write (const void* pData, size_t size)
+{
+	State& state = *m_pState;
+	if (!WriteAt (pData, size, state.position))
+		return false;
+
+	state.position += size;
+
+	return true;
+}
+
+bool AsyncFileOStream::Flush ()
+{
+	return Drain () && fsync (m_pState->fd) == 0;
+}
+
+size_t AsyncFileOStream::GetPosition ()
+{
+	return m_pState->position;
+}
+
+void AsyncFileOStream::SetPosition (size_t newPos)
+{
+	m_pState->position = newPos;
+}
+
+size_t AsyncFileOStream::GetSize ()
+{
+	std::lock_guard<std::mutex> lock (m_pState->mutex);
+
+	return m_pState->size;
+}
+
+// A pending write past the new size would extend the file again
+bool AsyncFileOStream::SetSize (size_t newSize)
+{
+	State& state = *m_pState;
+	if (!Drain ())
+		return false;
+
+	std::lock_guard<std::mutex> lock (state.mutex);
+	if (ftruncate (state.fd, newSize) != 0)
+		return false;
+
+	state.size = newSize;
+
+	return true;
+}
+
+bool AsyncFileOStream::WriteAt (const void* pData, size_t size, size_t offset)
+{
+	State& state = *m_pState;
+
+	std::unique_lock<std::mutex> lock (state.mutex);
+	if (!state.valid || state.failed)
+		return false;
+
+	// Pending writes land in any order, so a write to the same range could be overwritten by an older one
+	while (OverlapsPendingWrite (offset, size)) {
+		if (!WaitForPendingWrites (lock))
+			return false;
+	}
+
+	state.size = std::max (state.size, offset + size);
+
+	const char* pCurr = static_cast<const char*> (pData);
+	while (size > 0) {
+		// Contiguous writes are appended to the buffer being filled, anything else starts a new one
+		if (state.currentBuffer != NoBuffer) {
+			const Buffer& current = state.buffers[state.currentBuffer];
+			if (current.offset + current.size != offset || current.size == state.bufferSize)
+				RetireCurrentBuffer ();
+		}
+
+		if (state.currentBuffer == NoBuffer) {
+			// Other threads might have taken the buffer (or started a new one) by the time one is available, so
+			//   everything is checked again
+			if (state.freeBuffers.empty ()) {
+				if (!WaitForBuffer (lock))
+					return false;
+
+				continue;
+			}
+
+			state.currentBuffer = state.freeBuffers.back ();
+			state.freeBuffers.pop_back ();
+
+			Buffer& buffer = state.buffers[state.currentBuffer];
+			buffer.offset  = offset;
+			buffer.size	   = 0;
+		}
+
+		// The space is reserved with the mutex held, but copied without it, so that concurrent writers don't wait
+		//   for each other's copies
+		const size_t bufferIndex = state.currentBuffer;
+		Buffer&		 buffer		 = state.buffers[bufferIndex];
+		const size_t toCopy		 = std::min (size, state.bufferSize - buffer.size);
+		char*		 pDest		 = buffer.pData + buffer.size;
+
+		buffer.size += toCopy;
+		++buffer.copiesInProgress;
+		++state.copiesInProgress;
+
+		lock.unlock ();
+		memcpy (pDest, pCurr, toCopy);
+		lock.lock ();
+
+		FinishCopy (bufferIndex);
+
+		pCurr += toCopy;
+		offset += toCopy;
+		size -= toCopy;
+	}
+
+	return true;
+}
+
+bool AsyncFileOStream::SupportsConcurrentWriteAt () const
+{
+	return true;
+}
+
+bool AsyncFileOStream::Preallocate (size_t size)
+{
+	return PreallocateAll (m_pState->fd, size);
+}
+
+AsyncFileOStream::~AsyncFileOStream ()
+{
+	State& state = *m_pState;
+	if (state.valid)
+		Drain ();
+
+	StopWorkers ();
+
+	if (state.fd != -1)
+		close (state.fd);
+}
+
+bool AsyncFileOStream::IsValid () const
+{
+	return m_pState->valid;
+}
+
+bool AsyncFileOStream::UsesIOUring () const
+{
+	return m_pState->usesIOUring;
+}
+
+uint64_t AsyncFileOStream::GetSubmissionCount () const
+{
+	std::lock_guard<std::mutex> lock (m_pState->mutex);
+
+	return m_pState->submissions;
+}
+
+uint64_t AsyncFileOStream::GetWriteCount () const
+{
+	std::lock_guard<std::mutex> lock (m_pState->mutex);
+
+	return m_pState->writes;
+}
+
+void AsyncFileOStream::Init (int fd, size_t queueDepth, size_t bufferSize)
+{
+	assert (queueDepth > 0 && bufferSize > 0);
+
+	State& state	 = *m_pState;
+	state.fd		 = fd;
+	state.bufferSize = bufferSize;
+	state.batchSize	 = std::max<size_t> (queueDepth / BatchesInQueue, 1);
+	if (fd == -1)
+		return;
+
+	struct stat fileInfo;
+	if (fstat (fd, &fileInfo) != 0)
+		return;
+
+	state.size = fileInfo.st_size;
+
+	// The vectors are never reallocated after this, so they can be used without allocating, and without throwing
+	try {
+		state.pBufferMemory.reset (new char[queueDepth * bufferSize]);
+		state.buffers.resize (queueDepth);
+		state.freeBuffers.reserve (queueDepth);
+		state.queuedBuffers.reserve (queueDepth);
+		state.submittedBuffers.reserve (queueDepth);
+	} catch (const std::bad_alloc&) {
+		return;
+	}
+
+	for (size_t i = 0; i < queueDepth; ++i) {
+		state.buffers[i].pData = state.pBufferMemory.get () + i * bufferSize;
+		state.freeBuffers.push_back (i);
+	}
+
+	// Without io_uring or worker threads, writes are done synchronously
+	state.usesIOUring = InitIOUring ();
+	if (!state.usesIOUring) {
+		for (size_t i = 0; i < WorkerCount; ++i) {
+			pthread_t thread;
+			if (pthread_create (&thread, nullptr, &WorkerThreadMain, this) != 0)
+				break;
+
+			state.workers.push_back (thread);
+		}
+	}
+
+	state.valid = true;
+}
+
+// No more writes go into the buffer being filled. It is queued right away, or by the last copy into it, if any are
+//   in progress. Called with the mutex held.
+void AsyncFileOStream::RetireCurrentBuffer ()
+{
+	State&		 state		 = *m_pState;
+	const size_t bufferIndex = state.currentBuffer;
+	state.currentBuffer		 = NoBuffer;
+
+	if (state.buffers[bufferIndex].copiesInProgress > 0)
+		state.buffers[bufferIndex].retired = true;
+	else
+		QueueBuffer (bufferIndex);
+}
+
+// Called with the mutex held
+void AsyncFileOStream::FinishCopy (size_t bufferIndex)
+{
+	State&	state  = *m_pState;
+	Buffer& buffer = state.buffers[bufferIndex];
+	--buffer.copiesInProgress;
+	--state.copiesInProgress;
+
+	if (buffer.copiesInProgress == 0 && buffer.retired) {
+		buffer.retired = false;
+		QueueBuffer (bufferIndex);
+
+		// A writer might be waiting for this very buffer, so it can't wait for the rest of the batch
+		if (state.freeBuffers.empty ())
+			SubmitQueued ();
+	}
+
+	// Writers waiting for a buffer, and Drain waiting for the copies
+	state.cv.notify_all ();
+}
+
+// Called with the mutex held
+void AsyncFileOStream::QueueBuffer (size_t bufferIndex)
+{
+	State& state = *m_pState;
+	state.queuedBuffers.push_back (bufferIndex);
+
+	if (state.queuedBuffers.size () >= state.batchSize)
+		SubmitQueued ();
+}
+
+// Submits every queued buffer at once: with a single system call for io_uring, with a single wakeup for the thread
+//   pool. Without either, writes are done right away. Called with the mutex held.
+void AsyncFileOStream::SubmitQueued ()
+{
+	State& state = *m_pState;
+	if (state.queuedBuffers.empty ())
+		return;
+
+	++state.submissions;
+	state.writes += state.queuedBuffers.size ();
+	state.inFlight += state.queuedBuffers.size ();
+
+	if (state.usesIOUring) {
+#ifdef MMD_IO_URING
+		IOUring& ring = state.ioUring;
+
+		// There is a submission queue entry for every buffer, so the queue can't be full
+		unsigned tail = *ring.pSQTail;
+		for (const size_t bufferIndex : state.queuedBuffers) {
+			Buffer& buffer		  = state.buffers[bufferIndex];
+			buffer.ioVec.iov_base = buffer.pData;
+			buffer.ioVec.iov_len  = buffer.size;
+
+			const unsigned index = tail & *ring.pSQMask;
+			io_uring_sqe&  sqe	 = ring.pSQEs[index];
+			memset (&sqe, 0, sizeof sqe);
+			// IORING_OP_WRITE would need a newer kernel
+			sqe.opcode	  = IORING_OP_WRITEV;
+			sqe.fd		  = state.fd;
+			sqe.off		  = buffer.offset;
+			sqe.addr	  = reinterpret_cast<uint64_t> (&buffer.ioVec);
+			sqe.len		  = 1;
+			sqe.user_data = bufferIndex;
+
+			ring.pSQArray[index] = index;
+			++tail;
+		}
+
+		__atomic_store_n (ring.pSQTail, tail, __ATOMIC_RELEASE);
+
+		size_t toSubmit = state.queuedBuffers.size ();
+		while (toSubmit > 0) {
+			const long submitted = syscall (__NR_io_uring_enter, ring.fd, unsigned (toSubmit), 0, 0, nullptr, 0);
+			if (submitted > 0) {
+				toSubmit -= submitted;
+			} else if (submitted == -1 && (errno == EINTR || errno == EAGAIN || errno == EBUSY)) {
+				ReapIOUringCompletions ();
+			} else {
+				// The kernel only reads entries in io_uring_enter, so the ones not consumed can be taken back
+				__atomic_store_n (ring.pSQTail, tail - unsigned (toSubmit), __ATOMIC_RELEASE);
+
+				const size_t nQueued = state.queuedBuffers.size ();
+				for (size_t i = nQueued - toSubmit; i < nQueued; ++i)
+					CompleteWrite (state.queuedBuffers[i], false);
+
+				break;
+			}
+		}
+#endif
+	} else if (!state.workers.empty ()) {
+		state.submittedBuffers.insert (state.submittedBuffers.end (),
+									   state.queuedBuffers.begin (),
+									   state.queuedBuffers.end ());
+		state.cv.notify_all ();
+	} else {
+		for (const size_t bufferIndex : state.queuedBuffers) {
+			const Buffer& buffer = state.buffers[bufferIndex];
+			CompleteWrite (bufferIndex, PWriteAll (state.fd, buffer.pData, buffer.size, buffer.offset));
+		}
+	}
+
+	state.queuedBuffers.clear ();
+}
+
+// Submits the queue, and waits until a buffer is free, or another writer started filling one. lock holds the mutex,
+//   and is released while waiting, except for io_uring completions (nothing else could be done in the meantime).
+bool AsyncFileOStream::WaitForBuffer (std::unique_lock<std::mutex>& lock)
+{
+	State& state = *m_pState;
+	SubmitQueued ();
+
+	// io_uring completions are only reaped by waiting writers. With none in flight, every buffer is being copied into.
+	if (state.usesIOUring && state.inFlight > 0)
+		return WaitForIOUringCompletions (state.inFlight - 1);
+
+	state.cv.wait (lock, [&state] {
+		return !state.freeBuffers.empty () || state.currentBuffer != NoBuffer || state.failed ||
+			   (state.usesIOUring && state.inFlight > 0);
+	});
+
+	return !state.failed;
+}
+
+// Called with the mutex held
+void AsyncFileOStream::CompleteWrite (size_t bufferIndex, bool succeeded)
+{
+	State& state					= *m_pState;
+	state.buffers[bufferIndex].size = 0;
+	state.freeBuffers.push_back (bufferIndex);
+	--state.inFlight;
+
+	if (!succeeded)
+		state.failed = true;
+}
+
+// Buffers being filled, queued, or in flight (free ones are empty). Called with the mutex held.
+bool AsyncFileOStream::OverlapsPendingWrite (size_t offset, size_t size) const
+{
+	for (const Buffer& buffer : m_pState->buffers) {
+		if (buffer.size > 0 && buffer.offset < offset + size && offset < buffer.offset + buffer.size)
+			return true;
+	}
+
+	return false;
+}
+
+// Submits everything, and waits for it to complete. lock holds the mutex, and is released while waiting, except for
+//   io_uring completions.
+bool AsyncFileOStream::WaitForPendingWrites (std::unique_lock<std::mutex>& lock)
+{
+	State& state = *m_pState;
+
+	// Buffers are only submitted once every copy into them is done
+	state.cv.wait (lock, [&state] { return state.copiesInProgress == 0; });
+	if (state.currentBuffer != NoBuffer)
+		RetireCurrentBuffer ();
+
+	SubmitQueued ();
+	if (state.usesIOUring)
+		return WaitForIOUringCompletions (0);
+
+	state.cv.wait (lock, [&state] { return state.inFlight == 0; });
+
+	return !state.failed;
+}
+
+bool AsyncFileOStream::Drain ()
+{
+	State& state = *m_pState;
+
+	std::unique_lock<std::mutex> lock (state.mutex);
+	if (!state.valid)
+		return false;
+
+	return WaitForPendingWrites (lock);
+}
+
+// Fails if io_uring is not available: not Linux, an old kernel, or blocked (e.g. by seccomp in containers, or by the
+//   kernel.io_uring_disabled sysctl)
+bool AsyncFileOStream::InitIOUring ()
+{
+#ifdef MMD_IO_URING
+	State&	 state = *m_pState;
+	IOUring& ring  = state.ioUring;
+
+	io_uring_params params = {};
+	ring.fd				   = int (syscall (__NR_io_uring_setup, unsigned (state.buffers.size ()), &params));
+	if (ring.fd == -1)
+		return false;
+
+	ring.sqRingSize = params.sq_off.array + params.sq_entries * sizeof (unsigned);
+	ring.cqRingSize = params.cq_off.cqes + params.cq_entries * sizeof (io_uring_cqe);
+
+	const bool singleMmap = (params.features & IORING_FEAT_SINGLE_MMAP) != 0;
+	if (singleMmap)
+		ring.sqRingSize = ring.cqRingSize = std::max (ring.sqRingSize, ring.cqRingSize);
+
+	const int Protection = PROT_READ | PROT_WRITE;
+	const int Flags		 = MAP_SHARED | MAP_POPULATE;
+
+	ring.pSQRing = mmap (nullptr, ring.sqRingSize, Protection, Flags, ring.fd, IORING_OFF_SQ_RING);
+	if (ring.pSQRing == MAP_FAILED)
+		return false;
+
+	ring.pCQRing =
+		singleMmap ? ring.pSQRing : mmap (nullptr, ring.cqRingSize, Protection, Flags, ring.fd, IORING_OFF_CQ_RING);
+	if (ring.pCQRing == MAP_FAILED)
+		return false;
+
+	ring.sqesSize = params.sq_entries * sizeof (io_uring_sqe);
+	void* pSQEs	  = mmap (nullptr, ring.sqesSize, Protection, Flags, ring.fd, IORING_OFF_SQES);
+	if (pSQEs == MAP_FAILED)
+		return false;
+
+	ring.pSQEs = static_cast<io_uring_sqe*> (pSQEs);
+
+	char* pSQRing = static_cast<char*> (ring.pSQRing);
+	char* pCQRing = static_cast<char*> (ring.pCQRing);
+	ring.pSQTail  = reinterpret_cast<unsigned*> (pSQRing + params.sq_off.tail);
+	ring.pSQMask  = reinterpret_cast<unsigned*> (pSQRing + params.sq_off.ring_mask);
+	ring.pSQArray = reinterpret_cast<unsigned*> (pSQRing + params.sq_off.array);
+	ring.pCQHead  = reinterpret_cast<unsigned*> (pCQRing + params.cq_off.head);
+	ring.pCQTail  = reinterpret_cast<unsigned*> (pCQRing + params.cq_off.tail);
+	ring.pCQMask  = reinterpret_cast<unsigned*> (pCQRing + params.cq_off.ring_mask);
+	ring.pCQEs	  = reinterpret_cast<io_uring_cqe*> (pCQRing + params.cq_off.cqes);
+
+	return true;
+#else
+	return false;
+#endif
+}
+
+// Short writes (rare for regular files) are finished synchronously. Called with the mutex held.
+void AsyncFileOStream::ReapIOUringCompletions ()
+{
+#ifdef MMD_IO_URING
+	State&	 state = *m_pState;
+	IOUring& ring  = state.ioUring;
+
+	unsigned	   head = *ring.pCQHead;
+	const unsigned tail = __atomic_load_n (ring.pCQTail, __ATOMIC_ACQUIRE);
+	for (; head != tail; ++head) {
+		const io_uring_cqe& cqe			= ring.pCQEs[head & *ring.pCQMask];
+		const size_t		bufferIndex = size_t (cqe.user_data);
+		const Buffer&		buffer		= state.buffers[bufferIndex];
+
+		bool succeeded = cqe.res >= 0;
+		if (succeeded && size_t (cqe.res) < buffer.size) {
+			const size_t written = size_t (cqe.res);
+			succeeded = PWriteAll (state.fd, buffer.pData + written, buffer.size - written, buffer.offset + written);
+		}
+
+		CompleteWrite (bufferIndex, succeeded);
+	}
+
+	__atomic_store_n (ring.pCQHead, head, __ATOMIC_RELEASE);
+#endif
+}
+
+// Waits until at most maxInFlight buffers are in flight, reaping every completion available on the way. Called with
+//   the mutex held, which is not released while waiting.
+bool AsyncFileOStream::WaitForIOUringCompletions ([[maybe_unused]] size_t maxInFlight)
+{
+#ifdef MMD_IO_URING
+	State& state = *m_pState;
+
+	ReapIOUringCompletions ();
+	while (state.inFlight > maxInFlight) {
+		const unsigned toWait = unsigned (state.inFlight - maxInFlight);
+		if (syscall (__NR_io_uring_enter, state.ioUring.fd, 0, toWait, IORING_ENTER_GETEVENTS, nullptr, 0) == -1 &&
+			errno != EINTR) {
+			state.failed = true;
+
+			return false;
+		}
+
+		ReapIOUringCompletions ();
+	}
+
+	return !state.failed;
+#else
+	return false;
+#endif
+}
+
+void* AsyncFileOStream::WorkerThreadMain (void* pThis)
+{
+	static_cast<AsyncFileOStream*> (pThis)->RunWorker ();
+
+	return nullptr;
+}
+
+void AsyncFileOStream::RunWorker ()
+{
+	State& state = *m_pState;
+
+	std::unique_lock<std::mutex> lock (state.mutex);
+	while (true) {
+		state.cv.wait (lock, [&state] { return state.stopRequested || !state.submittedBuffers.empty (); });
+		if (state.stopRequested)
+			return;
+
+		const size_t bufferIndex = state.submittedBuffers.back ();
+		state.submittedBuffers.pop_back ();
+
+		const Buffer& buffer = state.buffers[bufferIndex];
+
+		lock.unlock ();
+		const bool succeeded = PWriteAll (state.fd, buffer.pData, buffer.size, buffer.offset);
+		lock.lock ();
+
+		CompleteWrite (bufferIndex, succeeded);
+		state.cv.notify_all ();
+	}
+}
+
+void AsyncFileOStream::StopWorkers ()
+{
+	State& state = *m_pState;
+	{
+		std::lock_guard<std::mutex> lock (state.mutex);
+
+		state.stopRequested = true;
+		state.cv.notify_all ();
+	}
+
+	for (const pthread_t thread : state.workers)
+		pthread_join (thread, nullptr);
+
+	state.workers.clear ();
+}
+
+} // namespace MMD
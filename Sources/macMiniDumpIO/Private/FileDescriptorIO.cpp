@@ -0,0 +1,136 @@
+#include "MMD/FileDescriptorIO.hpp"
+
+#include <errno.h>
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <algorithm>
+
+namespace MMD {
+
+bool WriteAll (int fd, const void* pData, size_t size)
+{
+	const char* pCurr = static_cast<const char*> (pData);
+	while (size > 0) {
+		const ssize_t written = write (fd, pCurr, size);
+		if (written == -1) {
+			if (errno == EINTR)
+				continue;
+
+			return false;
+		}
+
+		pCurr += written;
+		size -= written;
+	}
+
+	return true;
+}
+
+bool PWriteAll (int fd, const void* pData, size_t size, size_t offset)
+{
+	const char* pCurr = static_cast<const char*> (pData);
+	while (size > 0) {
+		const ssize_t written = pwrite (fd, pCurr, size, offset);
+		if (written == -1) {
+			if (errno == EINTR)
+				continue;
+
+			return false;
+		}
+
+		pCurr += written;
+		offset += written;
+		size -= written;
+	}
+
+	return true;
+}
+
+bool WriteVAll (int fd, const iovec* pIOVecs, size_t count)
+{
+	// writev is limited to IOV_MAX buffers per call, and might write less than requested, so buffers are passed in
+	//   batches, starting from the first one not written out completely
+	const size_t BatchSize = 64;
+
+	size_t i	   = 0; // First buffer not written out completely
+	size_t skipped = 0; // Number of bytes already written from buffer i
+	while (i < count) {
+		iovec		 batch[BatchSize];
+		const size_t batchCount = std::min (count - i, BatchSize);
+		std::copy (pIOVecs + i, pIOVecs + i + batchCount, batch);
+		batch[0].iov_base = static_cast<char*> (batch[0].iov_base) + skipped;
+		batch[0].iov_len -= skipped;
+
+		const ssize_t written = writev (fd, batch, (int) batchCount);
+		if (written == -1) {
+			if (errno == EINTR)
+				continue;
+
+			return false;
+		}
+
+		size_t remaining = written;
+		while (i < count && remaining >= pIOVecs[i].iov_len - skipped) {
+			remaining -= pIOVecs[i].iov_len - skipped;
+			skipped = 0;
+			++i;
+		}
+
+		skipped += remaining;
+	}
+
+	return true;
+}
+
+bool PReadAll (int fd, void* pData, size_t size, size_t offset)
+{
+	char* pCurr = static_cast<char*> (pData);
+	while (size > 0) {
+		const ssize_t nRead = pread (fd, pCurr, size, offset);
+		if (nRead == -1) {
+			if (errno == EINTR)
+				continue;
+
+			return false;
+		}
+
+		if (nRead == 0)
+			return false;
+
+		pCurr += nRead;
+		offset += nRead;
+		size -= nRead;
+	}
+
+	return true;
+}
+
+bool PreallocateAll (int fd, size_t size)
+{
+#if defined __APPLE__
+	struct stat fileInfo;
+	if (fstat (fd, &fileInfo) != 0)
+		return false;
+
+	const size_t currentSize = fileInfo.st_size;
+	if (size <= currentSize)
+		return true;
+
+	// Contiguous allocation is preferred, but is not always possible
+	fstore_t store = { F_ALLOCATECONTIG | F_ALLOCATEALL, F_PEOFPOSMODE, 0, off_t (size - currentSize), 0 };
+	if (fcntl (fd, F_PREALLOCATE, &store) != -1)
+		return true;
+
+	store.fst_flags = F_ALLOCATEALL;
+
+	return fcntl (fd, F_PREALLOCATE, &store) != -1;
+#elif defined __linux__
+	return fallocate (fd, FALLOC_FL_KEEP_SIZE, 0, size) == 0;
+#else
+	return true;
+#endif
+}
+
+} // namespace MMD
@@ -0,0 +1,30 @@
+#include "MMD/IRandomAccessBinaryOStream.hpp"
+
+namespace MMD {
+
+IRandomAccessBinaryOStream::IRandomAccessBinaryOStream ()  = default;
+IRandomAccessBinaryOStream::~IRandomAccessBinaryOStream () = default;
+
+bool IRandomAccessBinaryOStream::WriteAt (const void* pData, size_t size, size_t offset)
+{
+	SetPosition (offset);
+
+	return Write (pData, size);
+}
+
+bool IRandomAccessBinaryOStream::SupportsConcurrentWriteAt () const
+{
+	return false;
+}
+
+bool IRandomAccessBinaryOStream::PunchHole ([[maybe_unused]] size_t offset, [[maybe_unused]] size_t size)
+{
+	return false;
+}
+
+bool IRandomAccessBinaryOStream::Preallocate ([[maybe_unused]] size_t size)
+{
+	return true;
+}
+
+} // namespace MMD
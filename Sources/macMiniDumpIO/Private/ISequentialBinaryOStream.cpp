@@ -0,0 +1,18 @@
+#include "MMD/ISequentialBinaryOStream.hpp"
+
+namespace MMD {
+
+ISequentialBinaryOStream::ISequentialBinaryOStream ()  = default;
+ISequentialBinaryOStream::~ISequentialBinaryOStream () = default;
+
+bool ISequentialBinaryOStream::WriteV (const iovec* pIOVecs, size_t count)
+{
+	for (size_t i = 0; i < count; ++i) {
+		if (!Write (pIOVecs[i].iov_base, pIOVecs[i].iov_len))
+			return false;
+	}
+
+	return true;
+}
+
+} // namespace MMD
@@ -0,0 +1,87 @@
+#ifndef MMD_COREADDRESSINDEX
+#define MMD_COREADDRESSINDEX
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+
+#include "CoreFileReader.hpp"
+
+namespace MMD {
+
+// Translates addresses of the target process to offsets in a core file, for reading its memory. The ranges of memory
+//   stored in the file (the segments) are kept in a flat array sorted by address, and searched without branches. In
+//   the Eytzinger layout, the keys are stored in the order of a breadth-first walk of a binary search tree instead, so
+//   that the first steps of every search hit the same few cache lines. Batched lookups interleave searches, so that
+//   their cache misses overlap. Reads spanning ranges adjacent in memory are supported.
+//   Thread-safe, as nothing is modified after construction.
+class CoreAddressIndex {
+public:
+	enum class Layout {
+		Sorted,
+		Eytzinger
+	};
+
+	// size bytes at address are stored at fileOffset
+	struct Range {
+		uint64_t address;
+		uint64_t size;
+		uint64_t fileOffset;
+	};
+
+	struct ReadRequest {
+		uint64_t address;
+		size_t	 size;
+		void*	 pOut;
+	};
+
+	static const size_t NotFound = SIZE_MAX;
+
+	// Constructors
+	CoreAddressIndex () = delete;
+	// Segments with no data in the file (or with data out of the file) are left out. The reader must outlive the index.
+	explicit CoreAddressIndex (const CoreFileReader& reader, Layout layout = Layout::Sorted);
+	// Ranges must not overlap; ranges of data out of [pFileData, pFileData + fileSize) are left out
+	CoreAddressIndex (const char*  pFileData,
+					  uint64_t	   fileSize,
+					  const Range* pRanges,
+					  size_t	   rangeCount,
+					  Layout	   layout = Layout::Sorted);
+
+	CoreAddressIndex (const CoreAddressIndex& rhs)			  = delete;
+	CoreAddressIndex& operator= (const CoreAddressIndex& rhs) = delete;
+
+	~CoreAddressIndex ();
+
+	bool IsValid () const;
+
+	// Ranges are indexed in the order of their addresses
+	size_t		 GetRangeCount () const;
+	const Range& GetRange (size_t rangeIndex) const;
+
+	// Index of the range containing the address, or NotFound
+	size_t Find (uint64_t address) const;
+	// Same as calling Find for every address, but faster for many addresses
+	void FindBatch (const uint64_t* pAddresses, size_t count, size_t* pRangeIndicesOut) const;
+
+	// Points into the file, if the memory is within a single range (zero-copy), nullptr otherwise
+	const char* GetPointer (uint64_t address, size_t size) const;
+	// Fails if any part of the memory is not in the file
+	bool Read (uint64_t address, size_t size, void* pOut) const;
+	// Returns the number of successful reads; pResultsOut (optional) receives the result of every read
+	size_t ReadBatch (const ReadRequest* pRequests, size_t count, bool* pResultsOut = nullptr) const;
+
+private:
+	struct State;
+
+	std::unique_ptr<State> m_pState;
+
+	void Build (const char* pFileData, uint64_t fileSize, const Range* pRanges, size_t rangeCount, Layout layout);
+	bool ReadFrom (size_t rangeIndex, uint64_t address, size_t size, void* pOut) const;
+};
+
+} // namespace MMD
+
+#endif // MMD_COREADDRESSINDEX
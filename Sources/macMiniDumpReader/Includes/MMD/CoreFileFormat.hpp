@@ -0,0 +1,155 @@
+#ifndef MMD_COREFILEFORMAT
+#define MMD_COREFILEFORMAT
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+namespace MMD {
+namespace CoreFileFormat {
+
+// The parts of the Mach-O format used by core files, defined here (instead of using <mach-o/loader.h>), so that core
+//   files can be read on any platform. Layouts and values are the same as in the system headers.
+
+constexpr uint32_t MachHeaderMagic64 = 0xFEEDFACF; // MH_MAGIC_64
+constexpr uint32_t FileTypeCore		 = 0x4;		   // MH_CORE
+
+constexpr int32_t CPUTypeX86_64 = 0x01000007; // CPU_TYPE_X86_64
+constexpr int32_t CPUTypeARM64	= 0x0100000C; // CPU_TYPE_ARM64
+
+constexpr uint32_t LoadCommandThread	= 0x4;	// LC_THREAD
+constexpr uint32_t LoadCommandSegment64 = 0x19; // LC_SEGMENT_64
+constexpr uint32_t LoadCommandNote		= 0x31; // LC_NOTE
+
+// Owners of the notes written by macMiniDump
+constexpr const char* MainBinSpecOwner	   = "main bin spec";
+constexpr const char* AddrableBitsOwner	   = "addrable bits";
+constexpr const char* AllImageInfosOwner   = "all image infos";
+constexpr const char* ProcessMetadataOwner = "process metadata";
+constexpr const char* DroppedRangesOwner   = "dropped ranges";
+constexpr const char* ChecksumOwner		   = "crc32c digest";
+
+struct MachHeader64 {
+	uint32_t magic;
+	int32_t	 cputype;
+	int32_t	 cpusubtype;
+	uint32_t filetype;
+	uint32_t ncmds;
+	uint32_t sizeofcmds;
+	uint32_t flags;
+	uint32_t reserved;
+};
+
+struct LoadCommand {
+	uint32_t cmd;
+	uint32_t cmdsize;
+};
+
+// Followed by nsects section headers (core files have none)
+struct SegmentCommand64 {
+	uint32_t cmd;
+	uint32_t cmdsize;
+	char	 segname[16];
+	uint64_t vmaddr;
+	uint64_t vmsize;
+	uint64_t fileoff;
+	uint64_t filesize;
+	int32_t	 maxprot;
+	int32_t	 initprot;
+	uint32_t nsects;
+	uint32_t flags;
+};
+
+struct NoteCommand {
+	uint32_t cmd;
+	uint32_t cmdsize;
+	char	 data_owner[16]; // Not null-terminated if all 16 characters are used
+	uint64_t offset;
+	uint64_t size;
+};
+
+// A thread command (LoadCommand) is followed by register sets: a ThreadStateHeader, then count 32-bit words of state
+struct ThreadStateHeader {
+	uint32_t flavor;
+	uint32_t count;
+};
+
+// Register set flavors written by macMiniDump
+constexpr uint32_t X86ThreadState64Flavor	 = 4; // x86_THREAD_STATE64
+constexpr uint32_t X86ExceptionState64Flavor = 6; // x86_EXCEPTION_STATE64
+constexpr uint32_t ARMThreadState64Flavor	 = 6; // ARM_THREAD_STATE64
+constexpr uint32_t ARMExceptionState64Flavor = 7; // ARM_EXCEPTION_STATE64
+
+// Positions of registers in the states above: 64-bit registers are indexed as 64-bit words, 32-bit ones as 32-bit words
+//   (trapno shares its word with cpu, in the low 16 bits)
+constexpr size_t X86ThreadState64RBP		   = 6;
+constexpr size_t X86ThreadState64RSP		   = 7;
+constexpr size_t X86ThreadState64RIP		   = 16;
+constexpr size_t X86ExceptionState64TrapNo	   = 0;
+constexpr size_t X86ExceptionState64Err		   = 1;
+constexpr size_t X86ExceptionState64FaultVAddr = 1;
+constexpr size_t ARMThreadState64FP			   = 29;
+constexpr size_t ARMThreadState64LR			   = 30;
+constexpr size_t ARMThreadState64SP			   = 31;
+constexpr size_t ARMThreadState64PC			   = 32;
+constexpr size_t ARMExceptionState64FAR		   = 0;
+constexpr size_t ARMExceptionState64ESR		   = 2;
+constexpr size_t ARMExceptionState64Exception  = 3;
+
+// "addrable bits" note payload: the number of bits used by addresses (others may hold pointer authentication codes)
+struct AddrableBitsInfo {
+	uint32_t version;
+	uint32_t nBits;
+	uint64_t unused;
+};
+
+// "all image infos" note payload: a header, then imgcount ImageEntry structs at entries_fileoff (an offset in the
+//   file). Image paths and SegmentVMAddr arrays are referred to by file offsets, too.
+struct AllImageInfosHeader {
+	uint32_t version;
+	uint32_t imgcount;
+	uint64_t entries_fileoff;
+	uint32_t entries_size;
+	uint32_t reserved;
+};
+
+struct ImageEntry {
+	uint64_t filepath_offset; // Null-terminated path
+	uint8_t	 uuid[16];
+	uint64_t load_address;
+	uint64_t seg_addrs_offset;
+	uint32_t segment_count;
+	uint32_t reserved;
+};
+
+struct SegmentVMAddr {
+	char	 segname[16];
+	uint64_t vmaddr;
+	uint64_t unused;
+};
+
+// "main bin spec" note payload
+struct MainBinSpec {
+	uint32_t version;
+	uint32_t type;
+	uint64_t address;
+	uint64_t slide;
+	uint8_t	 uuid[16];
+	uint32_t log2_pagesize;
+	uint32_t platform;
+};
+
+static_assert (sizeof (MachHeader64) == 32);
+static_assert (sizeof (SegmentCommand64) == 72);
+static_assert (sizeof (NoteCommand) == 40);
+static_assert (sizeof (AddrableBitsInfo) == 16);
+static_assert (sizeof (AllImageInfosHeader) == 24);
+static_assert (sizeof (ImageEntry) == 48);
+static_assert (sizeof (SegmentVMAddr) == 32);
+static_assert (sizeof (MainBinSpec) == 48);
+
+} // namespace CoreFileFormat
+} // namespace MMD
+
+#endif // MMD_COREFILEFORMAT
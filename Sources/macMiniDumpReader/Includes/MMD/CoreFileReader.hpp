@@ -0,0 +1,83 @@
+#ifndef MMD_COREFILEREADER
+#define MMD_COREFILEREADER
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+
+#include "CoreFileFormat.hpp"
+
+namespace MMD {
+
+// Reads core files written by macMiniDump (or any Mach-O core file) on any platform. The file is memory-mapped, and
+//   the load commands are indexed when it is opened (and checked to be within the file), so everything returned is a
+//   pointer into the mapping: nothing is copied (except for segment and note commands that are not 8-byte aligned in
+//   the file). Pointers stay valid for the lifetime of the reader.
+//   Thread-safe, as nothing is modified after opening.
+class CoreFileReader {
+public:
+	// A register set of a thread; count is the number of 32-bit words in the state
+	struct ThreadState {
+		uint32_t		flavor;
+		uint32_t		count;
+		const uint32_t* pState;
+	};
+
+	// Constructors
+	CoreFileReader () = delete;
+	explicit CoreFileReader (int fd);				// fd must be opened for reading; it is closed once mapped
+	explicit CoreFileReader (const char* filePath); // The file at this path must exist
+
+	CoreFileReader (const CoreFileReader& rhs)			  = delete;
+	CoreFileReader& operator= (const CoreFileReader& rhs) = delete;
+
+	~CoreFileReader ();
+
+	// The file could be mapped, and it is a 64-bit Mach-O core file with well-formed load commands
+	bool IsValid () const;
+
+	// The whole file
+	const char* GetData () const;
+	uint64_t	GetSize () const;
+
+	const CoreFileFormat::MachHeader64* GetHeader () const;
+
+	// Load commands of each kind are indexed in the order they are in the file
+	size_t GetThreadCount () const;
+	size_t GetThreadStateCount (size_t threadIndex) const;
+	bool   GetThreadState (size_t threadIndex, size_t stateIndex, ThreadState* pStateOut) const;
+
+	// The first register set of the given flavor
+	bool FindThreadState (size_t threadIndex, uint32_t flavor, ThreadState* pStateOut) const;
+
+	size_t									GetSegmentCount () const;
+	const CoreFileFormat::SegmentCommand64* GetSegment (size_t segmentIndex) const;
+
+	// Payload of the segment (filesize bytes at fileoff); fails if it's not within the file (e.g. it was truncated)
+	bool GetSegmentData (size_t segmentIndex, const char** ppDataOut, uint64_t* pSizeOut) const;
+
+	size_t							   GetNoteCount () const;
+	const CoreFileFormat::NoteCommand* GetNote (size_t noteIndex) const;
+
+	bool GetNoteData (size_t noteIndex, const char** ppDataOut, uint64_t* pSizeOut) const;
+	// Payload of the first note of the given owner
+	bool FindNoteData (const char* pOwnerName, const char** ppDataOut, uint64_t* pSizeOut) const;
+
+	// Range of the file, if it's within the file
+	bool GetFileRange (uint64_t offset, uint64_t size, const char** ppDataOut) const;
+
+private:
+	struct State;
+
+	std::unique_ptr<State> m_pState;
+
+	bool Map (int fd);
+	bool IndexLoadCommands ();
+	void IndexThreadStates (const CoreFileFormat::LoadCommand* pCommand);
+};
+
+} // namespace MMD
+
+#endif // MMD_COREFILEREADER
@@ -0,0 +1,59 @@
+#ifndef MMD_COREIMAGELIST
+#define MMD_COREIMAGELIST
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+
+#include "CoreFileReader.hpp"
+
+namespace MMD {
+
+// The images (executables and libraries) loaded in the process of a core file, from its "all image infos" note, and
+//   the main executable from its "main bin spec" note (see AddMainImage for where it's taken to be loaded).
+//   Pointers are into the mapping of the file: nothing is copied.
+//   Thread-safe, as nothing is modified after construction.
+class CoreImageList {
+public:
+	struct Image {
+		uint64_t	   loadAddress; // Address of the Mach-O header
+		const uint8_t* pUUID;		// 16 bytes
+		const char*	   pPath;		// Empty if not in the file
+	};
+
+	static const size_t NotFound = SIZE_MAX;
+
+	// Constructors
+	CoreImageList () = delete;
+	explicit CoreImageList (const CoreFileReader& reader); // The reader must outlive the list
+
+	CoreImageList (const CoreImageList& rhs)			= delete;
+	CoreImageList& operator= (const CoreImageList& rhs) = delete;
+
+	~CoreImageList ();
+
+	// The note is well-formed, or there is no such note (then the list is empty)
+	bool IsValid () const;
+
+	// Images are indexed in the order of their load addresses
+	size_t		 GetImageCount () const;
+	const Image& GetImage (size_t imageIndex) const;
+
+	// Index of the image with the highest load address at or below the address, or NotFound. Segments of images are not
+	//   in the note, so the address may be past the end of the image.
+	size_t FindImage (uint64_t address) const;
+
+private:
+	struct State;
+
+	std::unique_ptr<State> m_pState;
+
+	bool IndexImages (const CoreFileReader& reader);
+	bool AddMainImage (const CoreFileReader& reader);
+};
+
+} // namespace MMD
+
+#endif // MMD_COREIMAGELIST
@@ -0,0 +1,59 @@
+#ifndef MMD_CORESTACKWALKER
+#define MMD_CORESTACKWALKER
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+
+#include "CoreFileReader.hpp"
+#include "IProcessMemoryReader.hpp"
+#include "StackWalker.hpp"
+
+namespace MMD {
+
+// Walks the stacks of the threads of a core file (see StackWalker.hpp) from their saved registers, reading memory from
+//   the segments of the file, on any platform. Images are located through the "all image infos" note; their headers
+//   and unwind info are used if they are in the file (usually they are not: then functions are presumed to have stack
+//   frames, as for live processes on x86_64).
+//   Thread-safe, as nothing is modified after construction.
+class CoreStackWalker final : public IProcessMemoryReader {
+public:
+	// Constructors
+	CoreStackWalker () = delete;
+	explicit CoreStackWalker (const CoreFileReader& reader); // The reader must outlive the walker
+
+	~CoreStackWalker () override;
+
+	// The core file is valid, and its architecture is supported
+	bool IsValid () const;
+
+	StackWalkArchitecture GetArchitecture () const;
+
+	size_t GetThreadCount () const;
+	bool   GetThreadRegisters (size_t threadIndex, StackWalkRegisters* pRegistersOut) const;
+
+	// Instruction pointers of the stack of the thread (the top first), with pointer authentication codes stripped (see
+	//   the "addrable bits" note); returns their count
+	size_t WalkThread (size_t threadIndex, uint64_t* pFramesOut, size_t maxFrameCount) const;
+
+	// The Mach-O header of the image loaded at the address, followed by its load commands, if they are all in the file
+	bool GetImageHeader (uint64_t loadAddress, const char** ppHeaderOut) const;
+
+	// IProcessMemoryReader
+	bool Read (uint64_t address, size_t size, void* pOut) const override;
+	bool IsExecutable (uint64_t address) const override;
+	bool FindImage (uint64_t address, uint64_t* pLoadAddressOut, const char** ppHeaderOut) const override;
+
+	using IProcessMemoryReader::Read;
+
+private:
+	struct State;
+
+	std::unique_ptr<State> m_pState;
+};
+
+} // namespace MMD
+
+#endif // MMD_CORESTACKWALKER
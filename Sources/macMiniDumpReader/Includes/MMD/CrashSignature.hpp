@@ -0,0 +1,66 @@
+#ifndef MMD_CRASHSIGNATURE
+#define MMD_CRASHSIGNATURE
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+
+#include "CoreFileReader.hpp"
+
+namespace MMD {
+
+// Signatures of crashes, for telling apart different crashes without symbolication. The top frames of the crashing
+//   thread are normalized to (image UUID, offset in the image) pairs, which are the same for every occurrence of a
+//   crash, wherever images were loaded. These, and the UUID of the main executable (from the "main bin spec" note), so
+//   that crashes of different applications are told apart, are hashed into 128 bits (MurmurHash3, x64_128). The
+//   hashed bytes are fixed (see CrashSignature.cpp), so signatures stay the same across versions and platforms.
+//   Thread-safe, as nothing is modified after construction.
+class CrashSignatureGenerator {
+public:
+	struct Frame {
+		uint8_t	 imageUUID[16]; // All zero if the address is not within a known image
+		uint64_t offset;		// From the load address of the image (or the address, if not within a known image)
+	};
+
+	// The low half alone can be used as a 64-bit signature
+	struct Signature {
+		uint64_t low;
+		uint64_t high;
+	};
+
+	static const size_t NotFound		  = SIZE_MAX;
+	static const size_t DefaultFrameCount = 5;
+
+	// Constructors
+	CrashSignatureGenerator () = delete;
+	explicit CrashSignatureGenerator (const CoreFileReader& reader); // The reader must outlive the generator
+
+	CrashSignatureGenerator (const CrashSignatureGenerator& rhs)			= delete;
+	CrashSignatureGenerator& operator= (const CrashSignatureGenerator& rhs) = delete;
+
+	~CrashSignatureGenerator ();
+
+	bool IsValid () const;
+
+	// The first thread with an exception in its exception state (the crash context, if the core file was created with
+	//   one), or NotFound (e.g. for aborts, and for core files of processes that did not crash)
+	size_t FindCrashedThread () const;
+
+	// The top frames of the stack of the thread, normalized; returns their count
+	size_t GetFrames (size_t threadIndex, Frame* pFramesOut, size_t maxFrameCount) const;
+
+	// Fails if the stack of the thread could not be walked. Stacks with less frames than frameCount are hashed as they
+	//   are.
+	bool Generate (size_t threadIndex, size_t frameCount, Signature* pSignatureOut) const;
+
+private:
+	struct State;
+
+	std::unique_ptr<State> m_pState;
+};
+
+} // namespace MMD
+
+#endif // MMD_CRASHSIGNATURE
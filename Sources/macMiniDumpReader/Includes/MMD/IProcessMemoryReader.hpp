@@ -0,0 +1,45 @@
+#ifndef MMD_IPROCESSMEMORYREADER
+#define MMD_IPROCESSMEMORYREADER
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <type_traits>
+
+namespace MMD {
+
+// Access to the memory of a process, for walking its stacks (see StackWalker.hpp): a live process (through its task
+//   port), or a core file. Implementations must not allocate memory, as they may be used while handling a crash.
+class IProcessMemoryReader {
+public:
+	IProcessMemoryReader ();
+	IProcessMemoryReader (const IProcessMemoryReader& rhs)			  = delete;
+	IProcessMemoryReader& operator= (const IProcessMemoryReader& rhs) = delete;
+
+	virtual bool Read (uint64_t address, size_t size, void* pOut) const = 0;
+
+	template<typename T>
+	bool Read (uint64_t address, T* pOut) const;
+
+	// Fails if the memory is not mapped (or not known to be mapped)
+	virtual bool IsExecutable (uint64_t address) const = 0;
+
+	// Image containing the address: the address of its Mach-O header, and a copy of the header, followed by its load
+	//   commands, valid for the lifetime of the reader
+	virtual bool FindImage (uint64_t address, uint64_t* pLoadAddressOut, const char** ppHeaderOut) const = 0;
+
+	virtual ~IProcessMemoryReader ();
+};
+
+template<typename T>
+bool IProcessMemoryReader::Read (uint64_t address, T* pOut) const
+{
+	static_assert (std::is_trivially_copyable_v<T>);
+
+	return Read (address, sizeof (T), pOut);
+}
+
+} // namespace MMD
+
+#endif // MMD_IPROCESSMEMORYREADER
@@ -0,0 +1,52 @@
+#ifndef MMD_STACKWALKER
+#define MMD_STACKWALKER
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+#include "IProcessMemoryReader.hpp"
+
+namespace MMD {
+
+// Stack walking, independent of where the memory and registers of the process come from (see IProcessMemoryReader),
+//   and of the platform it runs on: the same code walks the stacks of live processes and of core files
+
+enum class StackWalkArchitecture {
+	X86_64,
+	ARM64
+};
+
+// The registers needed for walking a stack
+struct StackWalkRegisters {
+	uint64_t instructionPointer = 0;
+	uint64_t framePointer		= 0;
+	uint64_t linkRegister		= 0; // arm64 only
+	uint32_t exceptionSyndrome	= 0; // arm64 only (esr)
+};
+
+enum class StackFrameLookupResult {
+	HasFrame,
+	Frameless,
+	Unknown
+};
+
+// Whether the function at pc has set up a stack frame, according to the compact unwind info of its image (only
+//   supported on arm64)
+StackFrameLookupResult LookupStackFrameForPC (StackWalkArchitecture		  architecture,
+											  const IProcessMemoryReader& memoryReader,
+											  uint64_t					  pc);
+
+// Writes the instruction pointers of the stack (starting with the one of the registers) to pFramesOut, and returns
+//   their count. Pointers are returned as found, pointer authentication codes are not stripped. Does not allocate
+//   memory.
+size_t WalkStack (StackWalkArchitecture		  architecture,
+				  const IProcessMemoryReader& memoryReader,
+				  const StackWalkRegisters&	  registers,
+				  uint64_t*					  pFramesOut,
+				  size_t					  maxFrameCount);
+
+} // namespace MMD
+
+#endif // MMD_STACKWALKER
@@ -0,0 +1,347 @@
+#include "MMD/CoreAddressIndex.hpp"
+
+#include <algorithm>
+#include <cstring>
+#include <new>
+#include <vector>
+
+namespace MMD {
+
+namespace {
+
+// Searches of a batch are done in lockstep in groups of this size, so that the loads of a step are independent of each
+//   other, and their cache misses overlap
+constexpr size_t BatchGroupSize = 16;
+
+// Stores the keys of the sorted range [*pNextSortedIndex, ...) in the subtree rooted at eytzingerIndex (1-based), in
+//   order. Slots left over (the tree is complete) get the largest possible key, so that searches never go right from
+//   them, and every search takes the same number of steps.
+void FillEytzinger (const std::vector<uint64_t>& sortedKeys,
+					size_t						 eytzingerIndex,
+					size_t*						 pNextSortedIndex,
+					std::vector<uint64_t>*		 pKeysOut,
+					std::vector<uint32_t>*		 pSortedIndicesOut)
+{
+	if (eytzingerIndex >= pKeysOut->size ())
+		return;
+
+	FillEytzinger (sortedKeys, 2 * eytzingerIndex, pNextSortedIndex, pKeysOut, pSortedIndicesOut);
+
+	const size_t sortedIndex			 = (*pNextSortedIndex)++;
+	(*pKeysOut)[eytzingerIndex]			 = sortedIndex < sortedKeys.size () ? sortedKeys[sortedIndex] : UINT64_MAX;
+	(*pSortedIndicesOut)[eytzingerIndex] = uint32_t (std::min (sortedIndex, sortedKeys.size ()));
+
+	FillEytzinger (sortedKeys, 2 * eytzingerIndex + 1, pNextSortedIndex, pKeysOut, pSortedIndicesOut);
+}
+
+bool IsInRange (const CoreAddressIndex::Range& range, uint64_t address)
+{
+	return address >= range.address && address - range.address < range.size;
+}
+
+} // namespace
+
+const size_t CoreAddressIndex::NotFound;
+
+struct CoreAddressIndex::State {
+	const char* pFileData = nullptr;
+	Layout		layout	  = Layout::Sorted;
+	bool		valid	  = false;
+
+	std::vector<Range>	  ranges;	  // Sorted by address
+	std::vector<uint64_t> sortedKeys; // Addresses of the ranges, for the sorted layout
+
+	// Eytzinger layout: keys[1] is the root, the children of keys[i] are keys[2i] and keys[2i + 1]; keys[0] is unused
+	std::vector<uint64_t> eytzingerKeys;
+	std::vector<uint32_t> eytzingerSortedIndices; // Index of the range of each key
+	uint32_t			  eytzingerDepth = 0;
+
+	// Index of the last range starting at or below the address, or NotFound. Without branches, except for the loop,
+	//   which takes the same number of steps for every address.
+	size_t FindCandidate (uint64_t address) const
+	{
+		if (layout == Layout::Sorted) {
+			const uint64_t* pBase  = sortedKeys.data ();
+			size_t			length = sortedKeys.size ();
+			while (length > 1) {
+				const size_t half = length / 2;
+				pBase			  = pBase[half] <= address ? pBase + half : pBase;
+				length -= half;
+			}
+
+			return *pBase <= address ? size_t (pBase - sortedKeys.data ()) : NotFound;
+		} else {
+			size_t k = 1;
+			for (uint32_t i = 0; i < eytzingerDepth; ++i) {
+				PrefetchEytzinger (k);
+				k = 2 * k + (eytzingerKeys[k] <= address);
+			}
+
+			return ToCandidate (k);
+		}
+	}
+
+	// The 16 descendants of k four levels down are adjacent (two cache lines), so single searches fetch them ahead.
+	//   (Batched searches don't: their loads overlap anyway.) A prefetch does not fault, so the address is not checked
+	//   to be within the array.
+	void PrefetchEytzinger (size_t k) const
+	{
+		const uintptr_t descendants = uintptr_t (eytzingerKeys.data ()) + 16 * k * sizeof (uint64_t);
+		__builtin_prefetch (reinterpret_cast<const void*> (descendants));
+	}
+
+	// Takes the final position of an Eytzinger search: its bits are the steps taken (1 is right, to larger keys). The
+	//   last step to the left was from the first key above the address (every step after it was to the right), so
+	//   dropping the trailing steps to the right and that step gives its position (zero, if there is no such key).
+	size_t ToCandidate (size_t k) const
+	{
+		k >>= __builtin_ctzll (~uint64_t (k)) + 1;
+
+		const size_t upperIndex = k == 0 ? ranges.size () : eytzingerSortedIndices[k];
+
+		return upperIndex > 0 ? upperIndex - 1 : NotFound;
+	}
+
+	void FindCandidates (const uint64_t* pAddresses, size_t count, size_t* pIndicesOut) const
+	{
+		if (layout == Layout::Sorted) {
+			const uint64_t* pBases[BatchGroupSize];
+			for (size_t i = 0; i < count; ++i)
+				pBases[i] = sortedKeys.data ();
+
+			size_t length = sortedKeys.size ();
+			while (length > 1) {
+				const size_t half = length / 2;
+				for (size_t i = 0; i < count; ++i)
+					pBases[i] = pBases[i][half] <= pAddresses[i] ? pBases[i] + half : pBases[i];
+
+				length -= half;
+			}
+
+			for (size_t i = 0; i < count; ++i)
+				pIndicesOut[i] = *pBases[i] <= pAddresses[i] ? size_t (pBases[i] - sortedKeys.data ()) : NotFound;
+		} else {
+			size_t k[BatchGroupSize];
+			for (size_t i = 0; i < count; ++i)
+				k[i] = 1;
+
+			for (uint32_t step = 0; step < eytzingerDepth; ++step) {
+				for (size_t i = 0; i < count; ++i)
+					k[i] = 2 * k[i] + (eytzingerKeys[k[i]] <= pAddresses[i]);
+			}
+
+			for (size_t i = 0; i < count; ++i)
+				pIndicesOut[i] = ToCandidate (k[i]);
+		}
+	}
+};
+
+CoreAddressIndex::CoreAddressIndex (const CoreFileReader& reader, Layout layout): m_pState (new State)
+{
+	if (!reader.IsValid ())
+		return;
+
+	std::vector<Range> ranges;
+	try {
+		for (size_t i = 0; i < reader.GetSegmentCount (); ++i) {
+			const CoreFileFormat::SegmentCommand64* pSegment = reader.GetSegment (i);
+
+			ranges.push_back ({ pSegment->vmaddr, pSegment->filesize, pSegment->fileoff });
+		}
+	} catch (const std::bad_alloc&) {
+		return;
+	}
+
+	Build (reader.GetData (), reader.GetSize (), ranges.data (), ranges.size (), layout);
+}
+
+CoreAddressIndex::CoreAddressIndex (const char*	 pFileData,
+									uint64_t	 fileSize,
+									const Range* pRanges,
+									size_t		 rangeCount,
+									Layout		 layout):
+	m_pState (new State)
+{
+	Build (pFileData, fileSize, pRanges, rangeCount, layout);
+}
+
+CoreAddressIndex::~CoreAddressIndex () = default;
+
+bool CoreAddressIndex::IsValid () const
+{
+	return m_pState->valid;
+}
+
+size_t CoreAddressIndex::GetRangeCount () const
+{
+	return m_pState->ranges.size ();
+}
+
+const CoreAddressIndex::Range& CoreAddressIndex::GetRange (size_t rangeIndex) const
+{
+	return m_pState->ranges[rangeIndex];
+}
+
+size_t CoreAddressIndex::Find (uint64_t address) const
+{
+	const State& state = *m_pState;
+	if (state.ranges.empty ())
+		return NotFound;
+
+	const size_t rangeIndex = state.FindCandidate (address);
+
+	return rangeIndex != NotFound && IsInRange (state.ranges[rangeIndex], address) ? rangeIndex : NotFound;
+}
+
+void CoreAddressIndex::FindBatch (const uint64_t* pAddresses, size_t count, size_t* pRangeIndicesOut) const
+{
+	const State& state = *m_pState;
+	if (state.ranges.empty ()) {
+		std::fill (pRangeIndicesOut, pRangeIndicesOut + count, NotFound);
+
+		return;
+	}
+
+	for (size_t groupBegin = 0; groupBegin < count; groupBegin += BatchGroupSize) {
+		const size_t groupSize = std::min (BatchGroupSize, count - groupBegin);
+		state.FindCandidates (pAddresses + groupBegin, groupSize, pRangeIndicesOut + groupBegin);
+
+		for (size_t i = groupBegin; i < groupBegin + groupSize; ++i) {
+			if (pRangeIndicesOut[i] != NotFound && !IsInRange (state.ranges[pRangeIndicesOut[i]], pAddresses[i]))
+				pRangeIndicesOut[i] = NotFound;
+		}
+	}
+}
+
+const char* CoreAddressIndex::GetPointer (uint64_t address, size_t size) const
+{
+	const size_t rangeIndex = Find (address);
+	if (rangeIndex == NotFound)
+		return nullptr;
+
+	const Range&   range  = m_pState->ranges[rangeIndex];
+	const uint64_t offset = address - range.address;
+
+	return size <= range.size - offset ? m_pState->pFileData + range.fileOffset + offset : nullptr;
+}
+
+bool CoreAddressIndex::Read (uint64_t address, size_t size, void* pOut) const
+{
+	const size_t rangeIndex = Find (address);
+
+	return rangeIndex != NotFound && ReadFrom (rangeIndex, address, size, pOut);
+}
+
+size_t CoreAddressIndex::ReadBatch (const ReadRequest* pRequests, size_t count, bool* pResultsOut) const
+{
+	size_t nSucceeded = 0;
+	for (size_t groupBegin = 0; groupBegin < count; groupBegin += BatchGroupSize) {
+		const size_t groupSize = std::min (BatchGroupSize, count - groupBegin);
+
+		uint64_t addresses[BatchGroupSize];
+		size_t	 rangeIndices[BatchGroupSize];
+		for (size_t i = 0; i < groupSize; ++i)
+			addresses[i] = pRequests[groupBegin + i].address;
+
+		FindBatch (addresses, groupSize, rangeIndices);
+
+		for (size_t i = 0; i < groupSize; ++i) {
+			const ReadRequest& request = pRequests[groupBegin + i];
+			const bool		   result =
+				rangeIndices[i] != NotFound && ReadFrom (rangeIndices[i], request.address, request.size, request.pOut);
+			if (result)
+				++nSucceeded;
+
+			if (pResultsOut != nullptr)
+				pResultsOut[groupBegin + i] = result;
+		}
+	}
+
+	return nSucceeded;
+}
+
+// Ranges out of the file and ranges overlapping the previous one are left out. Both layouts are built on the sorted
+//   array of keys.
+void CoreAddressIndex::Build (const char*  pFileData,
+							  uint64_t	   fileSize,
+							  const Range* pRanges,
+							  size_t	   rangeCount,
+							  Layout	   layout)
+{
+	State& state	= *m_pState;
+	state.pFileData = pFileData;
+	state.layout	= layout;
+
+	try {
+		for (size_t i = 0; i < rangeCount; ++i) {
+			const Range& range = pRanges[i];
+			if (range.size == 0 || range.fileOffset > fileSize || range.size > fileSize - range.fileOffset ||
+				range.address + range.size < range.address)
+				continue;
+
+			state.ranges.push_back (range);
+		}
+
+		std::sort (state.ranges.begin (), state.ranges.end (), [] (const Range& lhs, const Range& rhs) {
+			return lhs.address < rhs.address;
+		});
+
+		size_t nKept = 0;
+		for (const Range& range : state.ranges) {
+			if (nKept > 0 && range.address < state.ranges[nKept - 1].address + state.ranges[nKept - 1].size)
+				continue;
+
+			state.ranges[nKept++] = range;
+		}
+		state.ranges.resize (nKept);
+
+		if (state.ranges.size () > UINT32_MAX)
+			return;
+
+		for (const Range& range : state.ranges)
+			state.sortedKeys.push_back (range.address);
+
+		if (layout == Layout::Eytzinger) {
+			while ((size_t (1) << state.eytzingerDepth) - 1 < state.sortedKeys.size ())
+				++state.eytzingerDepth;
+
+			state.eytzingerKeys.resize (size_t (1) << state.eytzingerDepth);
+			state.eytzingerSortedIndices.resize (state.eytzingerKeys.size ());
+
+			size_t nextSortedIndex = 0;
+			FillEytzinger (state.sortedKeys, 1, &nextSortedIndex, &state.eytzingerKeys, &state.eytzingerSortedIndices);
+
+			state.sortedKeys.clear ();
+			state.sortedKeys.shrink_to_fit ();
+		}
+	} catch (const std::bad_alloc&) {
+		return;
+	}
+
+	state.valid = true;
+}
+
+// Continues into the following ranges, as long as they are adjacent in memory
+bool CoreAddressIndex::ReadFrom (size_t rangeIndex, uint64_t address, size_t size, void* pOut) const
+{
+	const State& state = *m_pState;
+
+	char* pCurr = static_cast<char*> (pOut);
+	while (size > 0) {
+		const Range&   range		= state.ranges[rangeIndex];
+		const uint64_t offset		= address - range.address;
+		const size_t   nBytesToCopy = size_t (std::min<uint64_t> (size, range.size - offset));
+		memcpy (pCurr, state.pFileData + range.fileOffset + offset, nBytesToCopy);
+
+		pCurr += nBytesToCopy;
+		address += nBytesToCopy;
+		size -= nBytesToCopy;
+
+		if (size > 0 && (++rangeIndex == state.ranges.size () || state.ranges[rangeIndex].address != address))
+			return false;
+	}
+
+	return true;
+}
+
+} // namespace MMD
@@ -0,0 +1,295 @@
+#include "MMD/CoreFileReader.hpp"
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <cstdint>
+#include <cstring>
+#include <deque>
+#include <new>
+#include <vector>
+
+namespace MMD {
+
+using namespace CoreFileFormat;
+
+namespace {
+
+// Returns the command itself if it can be accessed in place, a copy of it in pCopies otherwise
+template<typename Command>
+const Command* GetAligned (const LoadCommand* pCommand, std::deque<Command>* pCopies)
+{
+	if (reinterpret_cast<uintptr_t> (pCommand) % alignof (Command) == 0)
+		return reinterpret_cast<const Command*> (pCommand);
+
+	pCopies->emplace_back ();
+	memcpy (&pCopies->back (), pCommand, sizeof (Command));
+
+	return &pCopies->back ();
+}
+
+} // namespace
+
+struct CoreFileReader::State {
+	const char* pData = nullptr;
+	uint64_t	size  = 0;
+	bool		valid = false;
+
+	std::vector<const LoadCommand*>		 threads;
+	std::vector<size_t>					 threadStateBegins; // Index of the first state of every thread, and the end
+	std::vector<ThreadState>			 threadStates;
+	std::vector<const SegmentCommand64*> segments;
+	std::vector<const NoteCommand*>		 notes;
+
+	// Copies of the segment and note commands that are not 8-byte aligned in the file
+	std::deque<SegmentCommand64> segmentCopies;
+	std::deque<NoteCommand>		 noteCopies;
+};
+
+CoreFileReader::CoreFileReader (int fd): m_pState (new State)
+{
+	m_pState->valid = Map (fd) && IndexLoadCommands ();
+}
+
+CoreFileReader::CoreFileReader (const char* filePath): m_pState (new State)
+{
+	m_pState->valid = Map (open (filePath, O_RDONLY)) && IndexLoadCommands ();
+}
+
+CoreFileReader::~CoreFileReader ()
+{
+	if (m_pState->pData != nullptr)
+		munmap (const_cast<char*> (m_pState->pData), m_pState->size);
+}
+
+bool CoreFileReader::IsValid () const
+{
+	return m_pState->valid;
+}
+
+const char* CoreFileReader::GetData () const
+{
+	return m_pState->pData;
+}
+
+uint64_t CoreFileReader::GetSize () const
+{
+	return m_pState->size;
+}
+
+const MachHeader64* CoreFileReader::GetHeader () const
+{
+	return m_pState->valid ? reinterpret_cast<const MachHeader64*> (m_pState->pData) : nullptr;
+}
+
+size_t CoreFileReader::GetThreadCount () const
+{
+	return m_pState->threads.size ();
+}
+
+size_t CoreFileReader::GetThreadStateCount (size_t threadIndex) const
+{
+	const State& state = *m_pState;
+	if (threadIndex >= state.threads.size ())
+		return 0;
+
+	return state.threadStateBegins[threadIndex + 1] - state.threadStateBegins[threadIndex];
+}
+
+bool CoreFileReader::GetThreadState (size_t threadIndex, size_t stateIndex, ThreadState* pStateOut) const
+{
+	if (stateIndex >= GetThreadStateCount (threadIndex))
+		return false;
+
+	*pStateOut = m_pState->threadStates[m_pState->threadStateBegins[threadIndex] + stateIndex];
+
+	return true;
+}
+
+bool CoreFileReader::FindThreadState (size_t threadIndex, uint32_t flavor, ThreadState* pStateOut) const
+{
+	const size_t nStates = GetThreadStateCount (threadIndex);
+	for (size_t i = 0; i < nStates; ++i) {
+		const ThreadState& threadState = m_pState->threadStates[m_pState->threadStateBegins[threadIndex] + i];
+		if (threadState.flavor == flavor) {
+			*pStateOut = threadState;
+
+			return true;
+		}
+	}
+
+	return false;
+}
+
+size_t CoreFileReader::GetSegmentCount () const
+{
+	return m_pState->segments.size ();
+}
+
+const SegmentCommand64* CoreFileReader::GetSegment (size_t segmentIndex) const
+{
+	return segmentIndex < m_pState->segments.size () ? m_pState->segments[segmentIndex] : nullptr;
+}
+
+bool CoreFileReader::GetSegmentData (size_t segmentIndex, const char** ppDataOut, uint64_t* pSizeOut) const
+{
+	const SegmentCommand64* pSegment = GetSegment (segmentIndex);
+	if (pSegment == nullptr || !GetFileRange (pSegment->fileoff, pSegment->filesize, ppDataOut))
+		return false;
+
+	*pSizeOut = pSegment->filesize;
+
+	return true;
+}
+
+size_t CoreFileReader::GetNoteCount () const
+{
+	return m_pState->notes.size ();
+}
+
+const NoteCommand* CoreFileReader::GetNote (size_t noteIndex) const
+{
+	return noteIndex < m_pState->notes.size () ? m_pState->notes[noteIndex] : nullptr;
+}
+
+bool CoreFileReader::GetNoteData (size_t noteIndex, const char** ppDataOut, uint64_t* pSizeOut) const
+{
+	const NoteCommand* pNote = GetNote (noteIndex);
+	if (pNote == nullptr || !GetFileRange (pNote->offset, pNote->size, ppDataOut))
+		return false;
+
+	*pSizeOut = pNote->size;
+
+	return true;
+}
+
+bool CoreFileReader::FindNoteData (const char* pOwnerName, const char** ppDataOut, uint64_t* pSizeOut) const
+{
+	const size_t ownerLength = strlen (pOwnerName);
+	if (ownerLength > sizeof NoteCommand::data_owner)
+		return false;
+
+	for (size_t i = 0; i < m_pState->notes.size (); ++i) {
+		const NoteCommand* pNote = m_pState->notes[i];
+		if (strncmp (pNote->data_owner, pOwnerName, sizeof pNote->data_owner) == 0)
+			return GetNoteData (i, ppDataOut, pSizeOut);
+	}
+
+	return false;
+}
+
+bool CoreFileReader::GetFileRange (uint64_t offset, uint64_t size, const char** ppDataOut) const
+{
+	const State& state = *m_pState;
+	if (!state.valid || offset > state.size || size > state.size - offset)
+		return false;
+
+	*ppDataOut = state.pData + offset;
+
+	return true;
+}
+
+// The file descriptor is not needed once the file is mapped
+bool CoreFileReader::Map (int fd)
+{
+	if (fd == -1)
+		return false;
+
+	State& state = *m_pState;
+
+	struct stat fileInfo;
+	if (fstat (fd, &fileInfo) == 0 && fileInfo.st_size >= off_t (sizeof (MachHeader64))) {
+		void* pMapping = mmap (nullptr, fileInfo.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+		if (pMapping != MAP_FAILED) {
+			state.pData = static_cast<const char*> (pMapping);
+			state.size	= fileInfo.st_size;
+		}
+	}
+
+	close (fd);
+
+	return state.pData != nullptr;
+}
+
+// Load commands are meant to be 8-byte aligned in 64-bit Mach-O files, but the kernel only pads them to 4 bytes (e.g.
+//   thread commands with an odd number of register words), which misaligns every command after them. Segment and note
+//   commands (which contain 64-bit fields) are copied in this case, everything else is accessed in place (the mapping
+//   is page-aligned). Unknown load commands are skipped.
+bool CoreFileReader::IndexLoadCommands ()
+{
+	State& state = *m_pState;
+
+	const MachHeader64* pHeader = reinterpret_cast<const MachHeader64*> (state.pData);
+	if (pHeader->magic != MachHeaderMagic64 || pHeader->filetype != FileTypeCore ||
+		pHeader->sizeofcmds > state.size - sizeof (MachHeader64))
+		return false;
+
+	try {
+		state.threadStateBegins.push_back (0);
+
+		const char* pCurr = state.pData + sizeof (MachHeader64);
+		const char* pEnd  = pCurr + pHeader->sizeofcmds;
+		for (uint32_t i = 0; i < pHeader->ncmds; ++i) {
+			if (size_t (pEnd - pCurr) < sizeof (LoadCommand))
+				return false;
+
+			const LoadCommand* pCommand = reinterpret_cast<const LoadCommand*> (pCurr);
+			if (pCommand->cmdsize < sizeof (LoadCommand) || pCommand->cmdsize % 4 != 0 ||
+				pCommand->cmdsize > size_t (pEnd - pCurr))
+				return false;
+
+			switch (pCommand->cmd) {
+				case LoadCommandThread:
+					IndexThreadStates (pCommand);
+
+					state.threads.push_back (pCommand);
+					state.threadStateBegins.push_back (state.threadStates.size ());
+					break;
+				case LoadCommandSegment64:
+					if (pCommand->cmdsize < sizeof (SegmentCommand64))
+						return false;
+
+					state.segments.push_back (GetAligned (pCommand, &state.segmentCopies));
+					break;
+				case LoadCommandNote:
+					if (pCommand->cmdsize < sizeof (NoteCommand))
+						return false;
+
+					state.notes.push_back (GetAligned (pCommand, &state.noteCopies));
+					break;
+			}
+
+			pCurr += pCommand->cmdsize;
+		}
+	} catch (const std::bad_alloc&) {
+		return false;
+	}
+
+	return true;
+}
+
+// A register set running past the end of the command is cut at the end of the command
+void CoreFileReader::IndexThreadStates (const LoadCommand* pCommand)
+{
+	const char* pCurr = reinterpret_cast<const char*> (pCommand) + sizeof (LoadCommand);
+	const char* pEnd  = reinterpret_cast<const char*> (pCommand) + pCommand->cmdsize;
+	while (size_t (pEnd - pCurr) >= sizeof (ThreadStateHeader)) {
+		const ThreadStateHeader* pStateHeader = reinterpret_cast<const ThreadStateHeader*> (pCurr);
+		pCurr += sizeof (ThreadStateHeader);
+
+		const size_t maxCount = size_t (pEnd - pCurr) / sizeof (uint32_t);
+		const size_t count	  = pStateHeader->count < maxCount ? pStateHeader->count : maxCount;
+
+		ThreadState threadState;
+		threadState.flavor = pStateHeader->flavor;
+		threadState.count  = uint32_t (count);
+		threadState.pState = reinterpret_cast<const uint32_t*> (pCurr);
+		m_pState->threadStates.push_back (threadState);
+
+		pCurr += count * sizeof (uint32_t);
+	}
+}
+
+} // namespace MMD
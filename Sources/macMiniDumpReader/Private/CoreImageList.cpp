@@ -0,0 +1,152 @@
+#include "MMD/CoreImageList.hpp"
+
+#include <algorithm>
+#include <cstring>
+#include <new>
+#include <vector>
+
+namespace MMD {
+
+using namespace CoreFileFormat;
+
+namespace {
+
+constexpr uint64_t MaxPathLength		    = 4096;		   // Longer paths are taken as malformed
+constexpr uint64_t Unspecified			    = UINT64_MAX;  // Address or slide in the "main bin spec" note
+constexpr uint64_t DefaultExecutableAddress = 0x100000000; // Of the __TEXT segment, after a 4 GiB __PAGEZERO
+
+} // namespace
+
+const size_t CoreImageList::NotFound;
+
+struct CoreImageList::State {
+	std::vector<Image> images; // Sorted by load address
+	bool			   valid = false;
+};
+
+CoreImageList::CoreImageList (const CoreFileReader& reader): m_pState (new State)
+{
+	if (!reader.IsValid ())
+		return;
+
+	m_pState->valid = IndexImages (reader) && AddMainImage (reader);
+	if (!m_pState->valid)
+		m_pState->images.clear ();
+}
+
+CoreImageList::~CoreImageList () = default;
+
+bool CoreImageList::IsValid () const
+{
+	return m_pState->valid;
+}
+
+size_t CoreImageList::GetImageCount () const
+{
+	return m_pState->images.size ();
+}
+
+const CoreImageList::Image& CoreImageList::GetImage (size_t imageIndex) const
+{
+	return m_pState->images[imageIndex];
+}
+
+size_t CoreImageList::FindImage (uint64_t address) const
+{
+	const std::vector<Image>& images = m_pState->images;
+
+	auto it = std::upper_bound (images.begin (), images.end (), address, [] (uint64_t address, const Image& image) {
+		return address < image.loadAddress;
+	});
+
+	return it == images.begin () ? NotFound : size_t (it - images.begin () - 1);
+}
+
+bool CoreImageList::IndexImages (const CoreFileReader& reader)
+{
+	const char* pData;
+	uint64_t	size;
+	if (!reader.FindNoteData (AllImageInfosOwner, &pData, &size))
+		return true;
+
+	if (size < sizeof (AllImageInfosHeader))
+		return false;
+
+	AllImageInfosHeader header;
+	memcpy (&header, pData, sizeof header);
+
+	const char* pEntries;
+	if (!reader.GetFileRange (header.entries_fileoff, uint64_t (header.imgcount) * sizeof (ImageEntry), &pEntries))
+		return false;
+
+	try {
+		m_pState->images.reserve (header.imgcount);
+		for (uint32_t i = 0; i < header.imgcount; ++i) {
+			const char* pEntry = pEntries + i * sizeof (ImageEntry);
+
+			ImageEntry entry;
+			memcpy (&entry, pEntry, sizeof entry);
+
+			// The path must be null-terminated within the file
+			const char* pPath = "";
+			if (entry.filepath_offset < reader.GetSize ()) {
+				const char*	   pCandidate = reader.GetData () + entry.filepath_offset;
+				const uint64_t maxSize	  = std::min (reader.GetSize () - entry.filepath_offset, MaxPathLength);
+				if (memchr (pCandidate, '\0', maxSize) != nullptr)
+					pPath = pCandidate;
+			}
+
+			const uint8_t* pUUID = reinterpret_cast<const uint8_t*> (pEntry + offsetof (ImageEntry, uuid));
+			m_pState->images.push_back ({ entry.load_address, pUUID, pPath });
+		}
+	} catch (const std::bad_alloc&) {
+		return false;
+	}
+
+	std::sort (m_pState->images.begin (), m_pState->images.end (), [] (const Image& lhs, const Image& rhs) {
+		return lhs.loadAddress < rhs.loadAddress;
+	});
+
+	return true;
+}
+
+// macMiniDump leaves the main executable out of the "all image infos" note. The "main bin spec" note has its UUID, and
+//   either its address, or (as macMiniDump writes it) its slide. Then it's taken to be at the default address of
+//   executables, slid: offsets from there do not depend on the slide either, even if the executable prefers another.
+bool CoreImageList::AddMainImage (const CoreFileReader& reader)
+{
+	const char* pData;
+	uint64_t	size;
+	if (!reader.FindNoteData (MainBinSpecOwner, &pData, &size) || size < sizeof (MainBinSpec))
+		return true;
+
+	MainBinSpec mainBinSpec;
+	memcpy (&mainBinSpec, pData, sizeof mainBinSpec);
+
+	uint64_t loadAddress = mainBinSpec.address;
+	if (loadAddress == Unspecified) {
+		if (mainBinSpec.slide == Unspecified)
+			return true;
+
+		loadAddress = DefaultExecutableAddress + mainBinSpec.slide;
+	}
+
+	const uint8_t*		pUUID  = reinterpret_cast<const uint8_t*> (pData + offsetof (MainBinSpec, uuid));
+	std::vector<Image>& images = m_pState->images;
+
+	auto it = std::lower_bound (images.begin (), images.end (), loadAddress, [] (const Image& image, uint64_t address) {
+		return image.loadAddress < address;
+	});
+	if (it != images.end () && it->loadAddress == loadAddress)
+		return true;
+
+	try {
+		images.insert (it, { loadAddress, pUUID, "" });
+	} catch (const std::bad_alloc&) {
+		return false;
+	}
+
+	return true;
+}
+
+} // namespace MMD
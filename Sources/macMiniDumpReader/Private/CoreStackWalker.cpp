@@ -0,0 +1,209 @@
+#include "MMD/CoreStackWalker.hpp"
+
+#include <cstring>
+#include <vector>
+
+#include "MMD/CoreAddressIndex.hpp"
+#include "MMD/CoreImageList.hpp"
+#include "MachOImage.hpp"
+
+namespace MMD {
+
+using namespace CoreFileFormat;
+
+namespace {
+
+constexpr int32_t ExecutableProtection = 0x4; // VM_PROT_EXECUTE
+
+std::vector<CoreAddressIndex::Range> GetExecutableRanges (const CoreFileReader& reader)
+{
+	std::vector<CoreAddressIndex::Range> ranges;
+	for (size_t i = 0; i < reader.GetSegmentCount (); ++i) {
+		const SegmentCommand64* pSegment = reader.GetSegment (i);
+		if (pSegment->initprot & ExecutableProtection)
+			ranges.push_back ({ pSegment->vmaddr, pSegment->filesize, pSegment->fileoff });
+	}
+
+	return ranges;
+}
+
+} // namespace
+
+struct CoreStackWalker::State {
+	const CoreFileReader&  reader;
+	const CoreAddressIndex memoryIndex;
+	const CoreAddressIndex executableMemoryIndex;
+	const CoreImageList	   imageList;
+
+	StackWalkArchitecture architecture = StackWalkArchitecture::X86_64;
+	uint64_t			  addressMask  = UINT64_MAX;
+	bool				  valid		   = false;
+
+	State (const CoreFileReader& reader, const std::vector<CoreAddressIndex::Range>& executableRanges):
+		reader (reader),
+		memoryIndex (reader),
+		executableMemoryIndex (reader.GetData (),
+							   reader.GetSize (),
+							   executableRanges.data (),
+							   executableRanges.size ()),
+		imageList (reader)
+	{
+	}
+};
+
+CoreStackWalker::CoreStackWalker (const CoreFileReader& reader):
+	m_pState (new State (reader, GetExecutableRanges (reader)))
+{
+	State& state = *m_pState;
+	if (!reader.IsValid ())
+		return;
+
+	switch (reader.GetHeader ()->cputype) {
+		case CPUTypeX86_64:
+			state.architecture = StackWalkArchitecture::X86_64;
+			break;
+		case CPUTypeARM64:
+			state.architecture = StackWalkArchitecture::ARM64;
+			break;
+		default:
+			return;
+	}
+
+	// Only arm64 has pointer authentication
+	const char* pData;
+	uint64_t	size;
+	if (state.architecture == StackWalkArchitecture::ARM64 && reader.FindNoteData (AddrableBitsOwner, &pData, &size) &&
+		size >= sizeof (AddrableBitsInfo)) {
+		AddrableBitsInfo addrableBits;
+		memcpy (&addrableBits, pData, sizeof addrableBits);
+		if (addrableBits.nBits > 0 && addrableBits.nBits < 64)
+			state.addressMask = (uint64_t (1) << addrableBits.nBits) - 1;
+	}
+
+	// Images are optional: without them, frames are looked up without unwind info
+	state.valid = state.memoryIndex.IsValid () && state.executableMemoryIndex.IsValid ();
+}
+
+CoreStackWalker::~CoreStackWalker () = default;
+
+bool CoreStackWalker::IsValid () const
+{
+	return m_pState->valid;
+}
+
+StackWalkArchitecture CoreStackWalker::GetArchitecture () const
+{
+	return m_pState->architecture;
+}
+
+size_t CoreStackWalker::GetThreadCount () const
+{
+	return IsValid () ? m_pState->reader.GetThreadCount () : 0;
+}
+
+bool CoreStackWalker::GetThreadRegisters (size_t threadIndex, StackWalkRegisters* pRegistersOut) const
+{
+	if (!IsValid ())
+		return false;
+
+	const CoreFileReader& reader = m_pState->reader;
+
+	// Register sets are only 4-byte aligned in the file
+	auto getRegister64 = [] (const CoreFileReader::ThreadState& threadState, size_t index) {
+		uint64_t value;
+		memcpy (&value, threadState.pState + 2 * index, sizeof value);
+
+		return value;
+	};
+
+	CoreFileReader::ThreadState gpr;
+	if (m_pState->architecture == StackWalkArchitecture::X86_64) {
+		if (!reader.FindThreadState (threadIndex, X86ThreadState64Flavor, &gpr) ||
+			gpr.count < 2 * (X86ThreadState64RIP + 1))
+			return false;
+
+		*pRegistersOut					  = {};
+		pRegistersOut->instructionPointer = getRegister64 (gpr, X86ThreadState64RIP);
+		pRegistersOut->framePointer		  = getRegister64 (gpr, X86ThreadState64RBP);
+	} else {
+		if (!reader.FindThreadState (threadIndex, ARMThreadState64Flavor, &gpr) ||
+			gpr.count < 2 * (ARMThreadState64PC + 1))
+			return false;
+
+		*pRegistersOut					  = {};
+		pRegistersOut->instructionPointer = getRegister64 (gpr, ARMThreadState64PC);
+		pRegistersOut->framePointer		  = getRegister64 (gpr, ARMThreadState64FP);
+		pRegistersOut->linkRegister		  = getRegister64 (gpr, ARMThreadState64LR);
+
+		CoreFileReader::ThreadState exc;
+		if (reader.FindThreadState (threadIndex, ARMExceptionState64Flavor, &exc) &&
+			exc.count > ARMExceptionState64ESR)
+			pRegistersOut->exceptionSyndrome = exc.pState[ARMExceptionState64ESR];
+	}
+
+	return true;
+}
+
+size_t CoreStackWalker::WalkThread (size_t threadIndex, uint64_t* pFramesOut, size_t maxFrameCount) const
+{
+	StackWalkRegisters registers;
+	if (!GetThreadRegisters (threadIndex, &registers))
+		return 0;
+
+	const size_t nFrames = WalkStack (m_pState->architecture, *this, registers, pFramesOut, maxFrameCount);
+	for (size_t i = 0; i < nFrames; ++i)
+		pFramesOut[i] &= m_pState->addressMask;
+
+	return nFrames;
+}
+
+bool CoreStackWalker::Read (uint64_t address, size_t size, void* pOut) const
+{
+	return m_pState->memoryIndex.Read (address, size, pOut);
+}
+
+bool CoreStackWalker::IsExecutable (uint64_t address) const
+{
+	return m_pState->executableMemoryIndex.Find (address) != CoreAddressIndex::NotFound;
+}
+
+bool CoreStackWalker::GetImageHeader (uint64_t loadAddress, const char** ppHeaderOut) const
+{
+	const CoreAddressIndex& memoryIndex = m_pState->memoryIndex;
+
+	const MachHeader64* pHeader =
+		reinterpret_cast<const MachHeader64*> (memoryIndex.GetPointer (loadAddress, sizeof (MachHeader64)));
+	if (pHeader == nullptr || pHeader->magic != MachHeaderMagic64)
+		return false;
+
+	const char* pHeaderBytes = memoryIndex.GetPointer (loadAddress, sizeof (MachHeader64) + pHeader->sizeofcmds);
+	if (pHeaderBytes == nullptr)
+		return false;
+
+	*ppHeaderOut = pHeaderBytes;
+
+	return true;
+}
+
+// The image with the highest load address at or below the address, if its header is in the file, and the address is
+//   within one of its segments
+bool CoreStackWalker::FindImage (uint64_t address, uint64_t* pLoadAddressOut, const char** ppHeaderOut) const
+{
+	const State& state = *m_pState;
+
+	const size_t imageIndex = state.imageList.FindImage (address);
+	if (imageIndex == CoreImageList::NotFound)
+		return false;
+
+	const uint64_t loadAddress = state.imageList.GetImage (imageIndex).loadAddress;
+	const char*	   pHeaderBytes;
+	if (!GetImageHeader (loadAddress, &pHeaderBytes) || !IsInImage (pHeaderBytes, loadAddress, address))
+		return false;
+
+	*pLoadAddressOut = loadAddress;
+	*ppHeaderOut	 = pHeaderBytes;
+
+	return true;
+}
+
+} // namespace MMD
@@ -0,0 +1,230 @@
+#include "MMD/CrashSignature.hpp"
+
+#include <cstring>
+#include <new>
+#include <vector>
+
+#include "MMD/CoreImageList.hpp"
+#include "MMD/CoreStackWalker.hpp"
+#include "MachOImage.hpp"
+
+namespace MMD {
+
+using namespace CoreFileFormat;
+
+namespace {
+
+uint64_t RotateLeft (uint64_t value, int count)
+{
+	return (value << count) | (value >> (64 - count));
+}
+
+uint64_t FinalMix (uint64_t value)
+{
+	value ^= value >> 33;
+	value *= 0xFF51AFD7ED558CCD;
+	value ^= value >> 33;
+	value *= 0xC4CEB9FE1A85EC53;
+	value ^= value >> 33;
+
+	return value;
+}
+
+uint64_t ReadLittleEndian64 (const uint8_t* pBytes)
+{
+	uint64_t value = 0;
+	for (size_t i = 0; i < 8; ++i)
+		value |= uint64_t (pBytes[i]) << (8 * i);
+
+	return value;
+}
+
+void AppendLittleEndian64 (uint64_t value, std::vector<uint8_t>* pBytesOut)
+{
+	for (size_t i = 0; i < 8; ++i)
+		pBytesOut->push_back (uint8_t (value >> (8 * i)));
+}
+
+// MurmurHash3 (x64_128 variant), as published by Austin Appleby; blocks are read as little-endian on every platform
+CrashSignatureGenerator::Signature MurmurHash3 (const uint8_t* pData, size_t size, uint64_t seed)
+{
+	const uint64_t c1 = 0x87C37B91114253D5;
+	const uint64_t c2 = 0x4CF5AD432745937F;
+
+	uint64_t h1 = seed;
+	uint64_t h2 = seed;
+
+	const size_t blockCount = size / 16;
+	for (size_t i = 0; i < blockCount; ++i) {
+		uint64_t k1 = ReadLittleEndian64 (pData + 16 * i);
+		uint64_t k2 = ReadLittleEndian64 (pData + 16 * i + 8);
+
+		h1 ^= RotateLeft (k1 * c1, 31) * c2;
+		h1 = (RotateLeft (h1, 27) + h2) * 5 + 0x52DCE729;
+
+		h2 ^= RotateLeft (k2 * c2, 33) * c1;
+		h2 = (RotateLeft (h2, 31) + h1) * 5 + 0x38495AB5;
+	}
+
+	const uint8_t* pTail	= pData + 16 * blockCount;
+	const size_t   tailSize = size % 16;
+
+	uint64_t k1 = 0;
+	uint64_t k2 = 0;
+	for (size_t i = 0; i < tailSize; ++i) {
+		if (i < 8)
+			k1 |= uint64_t (pTail[i]) << (8 * i);
+		else
+			k2 |= uint64_t (pTail[i]) << (8 * (i - 8));
+	}
+
+	if (tailSize > 8)
+		h2 ^= RotateLeft (k2 * c2, 33) * c1;
+	if (tailSize > 0)
+		h1 ^= RotateLeft (k1 * c1, 31) * c2;
+
+	h1 ^= size;
+	h2 ^= size;
+	h1 += h2;
+	h2 += h1;
+	h1 = FinalMix (h1);
+	h2 = FinalMix (h2);
+	h1 += h2;
+	h2 += h1;
+
+	return { h1, h2 };
+}
+
+bool HasException (StackWalkArchitecture architecture, const CoreFileReader::ThreadState& exc)
+{
+	if (architecture == StackWalkArchitecture::ARM64) {
+		return exc.count > ARMExceptionState64Exception &&
+			   (exc.pState[ARMExceptionState64Exception] != 0 || exc.pState[ARMExceptionState64ESR] != 0);
+	}
+
+	if (exc.count < 2 * (X86ExceptionState64FaultVAddr + 1))
+		return false;
+
+	uint64_t faultAddress;
+	memcpy (&faultAddress, exc.pState + 2 * X86ExceptionState64FaultVAddr, sizeof faultAddress);
+
+	return (exc.pState[X86ExceptionState64TrapNo] & 0xFFFF) != 0 || exc.pState[X86ExceptionState64Err] != 0 ||
+		   faultAddress != 0;
+}
+
+} // namespace
+
+const size_t CrashSignatureGenerator::NotFound;
+const size_t CrashSignatureGenerator::DefaultFrameCount;
+
+struct CrashSignatureGenerator::State {
+	const CoreFileReader& reader;
+	const CoreStackWalker walker;
+	const CoreImageList	  imageList;
+
+	uint8_t mainImageUUID[16] = {}; // All zero if there is no "main bin spec" note
+
+	explicit State (const CoreFileReader& reader): reader (reader), walker (reader), imageList (reader) {}
+};
+
+CrashSignatureGenerator::CrashSignatureGenerator (const CoreFileReader& reader): m_pState (new State (reader))
+{
+	const char* pData;
+	uint64_t	size;
+	if (reader.FindNoteData (MainBinSpecOwner, &pData, &size) && size >= sizeof (MainBinSpec)) {
+		MainBinSpec mainBinSpec;
+		memcpy (&mainBinSpec, pData, sizeof mainBinSpec);
+		memcpy (m_pState->mainImageUUID, mainBinSpec.uuid, sizeof m_pState->mainImageUUID);
+	}
+}
+
+CrashSignatureGenerator::~CrashSignatureGenerator () = default;
+
+bool CrashSignatureGenerator::IsValid () const
+{
+	return m_pState->walker.IsValid () && m_pState->imageList.IsValid ();
+}
+
+size_t CrashSignatureGenerator::FindCrashedThread () const
+{
+	if (!IsValid ())
+		return NotFound;
+
+	const StackWalkArchitecture architecture = m_pState->walker.GetArchitecture ();
+	const uint32_t				excFlavor	 = architecture == StackWalkArchitecture::ARM64 ?
+												   ARMExceptionState64Flavor :
+												   X86ExceptionState64Flavor;
+	for (size_t i = 0; i < m_pState->reader.GetThreadCount (); ++i) {
+		CoreFileReader::ThreadState exc;
+		if (m_pState->reader.FindThreadState (i, excFlavor, &exc) && HasException (architecture, exc))
+			return i;
+	}
+
+	return NotFound;
+}
+
+size_t CrashSignatureGenerator::GetFrames (size_t threadIndex, Frame* pFramesOut, size_t maxFrameCount) const
+{
+	if (!IsValid ())
+		return 0;
+
+	std::vector<uint64_t> addresses;
+	try {
+		addresses.resize (maxFrameCount);
+	} catch (const std::bad_alloc&) {
+		return 0;
+	}
+
+	const size_t frameCount = m_pState->walker.WalkThread (threadIndex, addresses.data (), addresses.size ());
+	for (size_t i = 0; i < frameCount; ++i) {
+		// Images are found from the notes, which attribute addresses past the end of an image to it. If the header of
+		//   the image happens to be in the file, the address is checked to be within one of its segments, too.
+		Frame&		   frame	  = pFramesOut[i];
+		const uint64_t address	  = addresses[i];
+		size_t		   imageIndex = m_pState->imageList.FindImage (address);
+		if (imageIndex != CoreImageList::NotFound) {
+			const uint64_t loadAddress = m_pState->imageList.GetImage (imageIndex).loadAddress;
+			const char*	   pHeader;
+			if (m_pState->walker.GetImageHeader (loadAddress, &pHeader) && !IsInImage (pHeader, loadAddress, address))
+				imageIndex = CoreImageList::NotFound;
+		}
+
+		if (imageIndex == CoreImageList::NotFound) {
+			memset (frame.imageUUID, 0, sizeof frame.imageUUID);
+			frame.offset = address;
+		} else {
+			const CoreImageList::Image& image = m_pState->imageList.GetImage (imageIndex);
+			memcpy (frame.imageUUID, image.pUUID, sizeof frame.imageUUID);
+			frame.offset = address - image.loadAddress;
+		}
+	}
+
+	return frameCount;
+}
+
+// Hashed bytes: the UUID of the main executable, then the UUID and the offset (64-bit, little-endian) of each frame
+bool CrashSignatureGenerator::Generate (size_t threadIndex, size_t frameCount, Signature* pSignatureOut) const
+{
+	std::vector<Frame>	 frames;
+	std::vector<uint8_t> bytes;
+	try {
+		frames.resize (frameCount);
+		frames.resize (GetFrames (threadIndex, frames.data (), frames.size ()));
+		if (frames.empty ())
+			return false;
+
+		bytes.insert (bytes.end (), m_pState->mainImageUUID, m_pState->mainImageUUID + sizeof m_pState->mainImageUUID);
+		for (const Frame& frame : frames) {
+			bytes.insert (bytes.end (), frame.imageUUID, frame.imageUUID + sizeof frame.imageUUID);
+			AppendLittleEndian64 (frame.offset, &bytes);
+		}
+	} catch (const std::bad_alloc&) {
+		return false;
+	}
+
+	*pSignatureOut = MurmurHash3 (bytes.data (), bytes.size (), 0);
+
+	return true;
+}
+
+} // namespace MMD
@@ -0,0 +1,8 @@
+#include "MMD/IProcessMemoryReader.hpp"
+
+namespace MMD {
+
+IProcessMemoryReader::IProcessMemoryReader ()  = default;
+IProcessMemoryReader::~IProcessMemoryReader () = default;
+
+} // namespace MMD
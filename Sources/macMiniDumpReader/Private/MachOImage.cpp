@@ -0,0 +1,67 @@
+#include "MachOImage.hpp"
+
+#include <algorithm>
+#include <cstring>
+
+#include "MMD/CoreFileFormat.hpp"
+
+namespace MMD {
+
+using namespace CoreFileFormat;
+
+namespace {
+
+// Calls function with each load command, until it returns false. Fails if a load command is malformed. Load commands
+//   of 64-bit images are 8-byte aligned (unlike those of some core files), so their structs can be used in place.
+template<typename Function>
+bool ForEachLoadCommand (const char* pHeaderBytes, Function&& function)
+{
+	const MachHeader64* pHeader = reinterpret_cast<const MachHeader64*> (pHeaderBytes);
+
+	const char* pCurr = pHeaderBytes + sizeof (MachHeader64);
+	const char* pEnd  = pCurr + pHeader->sizeofcmds;
+	for (uint32_t i = 0; i < pHeader->ncmds && size_t (pEnd - pCurr) >= sizeof (LoadCommand); ++i) {
+		const LoadCommand* pCommand = reinterpret_cast<const LoadCommand*> (pCurr);
+		if (pCommand->cmdsize < sizeof (LoadCommand) || pCommand->cmdsize > size_t (pEnd - pCurr) ||
+			pCommand->cmdsize % 8 != 0)
+			return false;
+
+		if (!function (pCommand))
+			return true;
+
+		pCurr += pCommand->cmdsize;
+	}
+
+	return true;
+}
+
+} // namespace
+
+bool IsInImage (const char* pHeaderBytes, uint64_t loadAddress, uint64_t address)
+{
+	const SegmentCommand64* pSegments[64];
+	size_t					nSegments = 0;
+
+	const bool wellFormed = ForEachLoadCommand (pHeaderBytes, [&] (const LoadCommand* pCommand) {
+		if (pCommand->cmd == LoadCommandSegment64 && pCommand->cmdsize >= sizeof (SegmentCommand64))
+			pSegments[nSegments++] = reinterpret_cast<const SegmentCommand64*> (pCommand);
+
+		return nSegments < sizeof pSegments / sizeof pSegments[0];
+	});
+	if (!wellFormed)
+		return false;
+
+	const SegmentCommand64* const* pText = std::find_if (pSegments, pSegments + nSegments, [] (auto pSegment) {
+		return strncmp (pSegment->segname, "__TEXT", sizeof pSegment->segname) == 0;
+	});
+	if (pText == pSegments + nSegments)
+		return false;
+
+	const uint64_t slide = loadAddress - (*pText)->vmaddr;
+
+	return std::any_of (pSegments, pSegments + nSegments, [&] (auto pSegment) {
+		return address - (pSegment->vmaddr + slide) < pSegment->vmsize;
+	});
+}
+
+} // namespace MMD
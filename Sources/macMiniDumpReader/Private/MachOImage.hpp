@@ -0,0 +1,18 @@
+#ifndef MMD_MACHOIMAGE
+#define MMD_MACHOIMAGE
+
+#pragma once
+
+#include <cstdint>
+
+namespace MMD {
+
+// Helpers for the Mach-O headers of images found in core files. pHeaderBytes points to a header, followed by all of
+//   its load commands (sizeofcmds bytes); malformed load commands are not followed.
+
+// Whether the address is within a segment of the image, slid to where it was loaded
+bool IsInImage (const char* pHeaderBytes, uint64_t loadAddress, uint64_t address);
+
+} // namespace MMD
+
+#endif // MMD_MACHOIMAGE
@@ -0,0 +1,401 @@
+#include "MMD/StackWalker.hpp"
+
+#include <cstring>
+
+#include "MMD/CoreFileFormat.hpp"
+#include "UnwindInfoFormat.hpp"
+
+namespace MMD {
+
+using namespace UnwindInfoFormat;
+
+namespace {
+
+uint64_t DerefPtr (const IProcessMemoryReader& memoryReader, uint64_t ptr)
+{
+	uint64_t result = 0;
+	memoryReader.Read (ptr, &result);
+
+	return result;
+}
+
+bool ExceptionMightBeControlTransferRelated (uint32_t esr)
+{
+	// Decode exception class from esr; we are interested in instruction abort and data abort
+	const uint32_t exceptionClass = (esr >> 26) & 0x3F;
+
+	// See: aarch64/exceptions/exceptions/AArch64.ExceptionClass in the corresponding ARM Reference Manual
+	switch (exceptionClass) {
+		case 0x20: // Instruction Abort
+		case 0x24: // Data Abort
+			return true;
+		default:
+			return false;
+	}
+}
+
+bool IsPreviousInstructionBLKind (const IProcessMemoryReader& memoryReader, uint64_t instructionPointer)
+{
+	// arm64 instructions are fixed 4-bytes in size
+	constexpr size_t instructionSize = 4;
+	uint32_t		 instruction;
+	if (!memoryReader.Read (instructionPointer - instructionSize, &instruction))
+		return false;
+
+	// BL: bits [31:26]; see:
+	// https://developer.arm.com/documentation/ddi0602/2024-09/Base-Instructions/BL--Branch-with-link-
+	const uint32_t blMask	= 0b111111;
+	const uint32_t blOpcode = (instruction >> 26) & blMask;
+	if (blOpcode == 0b100101)
+		return true;
+
+	// BLR: bits [31:10]; see:
+	// https://developer.arm.com/documentation/ddi0602/2024-09/Base-Instructions/BLR--Branch-with-link-to-register-
+	const uint32_t blrMask	 = 0b1111111111111111111111;
+	const uint32_t blrOpcode = (instruction >> 10) & blrMask;
+
+	if (blrOpcode == 0b1101011000111111000000)
+		return true;
+
+	// BLRA*: bits [31:11], where bit 24 (Z) is either 0 or 1 see:
+	// https://developer.arm.com/documentation/ddi0602/2024-09/Base-Instructions/BLRAA--BLRAAZ--BLRAB--BLRABZ--Branch-with-link-to-register--with-pointer-authentication-
+	const uint32_t blraMask	  = 0b111111101111111111111;
+	const uint32_t blraOpcode = (instruction >> 11) & blraMask;
+
+	return blraOpcode == 0b110101100011111100001;
+}
+
+bool IsPreviousInstructionSVC (const IProcessMemoryReader& memoryReader, uint64_t instructionPointer)
+{
+	// arm64 instructions are fixed 4-bytes in size
+	constexpr size_t instructionSize = 4;
+	uint32_t		 instruction;
+	if (!memoryReader.Read (instructionPointer - instructionSize, &instruction))
+		return false;
+
+	// Check if instruction is SVC; see:
+	// SVC: bits [31:21] = 0b11010100000
+	const uint32_t svcOpcode = (instruction >> 21) & 0x7FF;
+
+	return svcOpcode == 0b11010100000;
+}
+
+// Finds the __unwind_info section and the __TEXT segment in the load commands of an image. The header and load
+//   commands are a copy provided by the memory reader, so they are accessed in place.
+bool FindUnwindInfo (const char* pHeaderBytes, uint64_t* pUnwindInfoAddrOut, uint64_t* pTextVmAddrOut)
+{
+	const CoreFileFormat::MachHeader64* pHeader = reinterpret_cast<const CoreFileFormat::MachHeader64*> (pHeaderBytes);
+	if (pHeader->magic != CoreFileFormat::MachHeaderMagic64)
+		return false;
+
+	uint64_t unwindInfoAddr = 0;
+	bool	 foundText		= false;
+
+	const char* pCurr = pHeaderBytes + sizeof (CoreFileFormat::MachHeader64);
+	const char* pEnd  = pCurr + pHeader->sizeofcmds;
+	for (uint32_t i = 0; i < pHeader->ncmds; ++i) {
+		if (size_t (pEnd - pCurr) < sizeof (CoreFileFormat::LoadCommand))
+			return false;
+
+		const CoreFileFormat::LoadCommand* pCommand = reinterpret_cast<const CoreFileFormat::LoadCommand*> (pCurr);
+		if (pCommand->cmdsize < sizeof (CoreFileFormat::LoadCommand) || pCommand->cmdsize > size_t (pEnd - pCurr))
+			return false;
+
+		if (pCommand->cmd == CoreFileFormat::LoadCommandSegment64 &&
+			pCommand->cmdsize >= sizeof (CoreFileFormat::SegmentCommand64)) {
+			const CoreFileFormat::SegmentCommand64* pSegment =
+				reinterpret_cast<const CoreFileFormat::SegmentCommand64*> (pCommand);
+			if (strncmp (pSegment->segname, "__TEXT", 16) == 0) {
+				*pTextVmAddrOut = pSegment->vmaddr;
+				foundText		= true;
+			}
+
+			const size_t	 maxSectionCount = (pCommand->cmdsize - sizeof *pSegment) / sizeof (Section64);
+			const Section64* pSections		 = reinterpret_cast<const Section64*> (pSegment + 1);
+			for (uint32_t j = 0; j < pSegment->nsects && j < maxSectionCount; ++j) {
+				if (strncmp (pSections[j].sectname, "__unwind_info", 16) == 0)
+					unwindInfoAddr = pSections[j].addr;
+			}
+		}
+
+		pCurr += pCommand->cmdsize;
+	}
+
+	*pUnwindInfoAddrOut = unwindInfoAddr;
+
+	return unwindInfoAddr != 0 && foundText;
+}
+
+StackFrameLookupResult LookupStackFrameForPCImplArm64 (const IProcessMemoryReader& memoryReader, uint64_t pc)
+{
+	// Try to use compact unwind info (if present) to see if there is a stack frame
+	uint64_t	loadAddress;
+	const char* pHeaderBytes;
+	if (!memoryReader.FindImage (pc, &loadAddress, &pHeaderBytes))
+		return StackFrameLookupResult::Unknown;
+
+	uint64_t unwindInfoAddr = 0;
+	uint64_t textVmAddr		= 0;
+	if (!FindUnwindInfo (pHeaderBytes, &unwindInfoAddr, &textVmAddr))
+		return StackFrameLookupResult::Unknown;
+
+	uint64_t slide				= loadAddress - textVmAddr;
+	uint64_t unwindInfoLoadAddr = unwindInfoAddr + slide;
+
+	// Reference: https://faultlore.com/blah/compact-unwinding/
+	// The compact unwind info format uses a two-level page table. The first level is an index
+	// mapping function start addresses to second-level pages. Each second-level page then contains concrete unwind
+	// information. A second level page is either a so-called regular page or a compressed page.
+
+	SectionHeader unwindHeader;
+	if (!memoryReader.Read (unwindInfoLoadAddr, &unwindHeader))
+		return StackFrameLookupResult::Unknown;
+
+	// Calculate offset of index section
+	uint64_t indexSectionAddr = unwindInfoLoadAddr + unwindHeader.indexSectionOffset;
+	uint32_t indexCount		  = unwindHeader.indexCount;
+
+	uint32_t pcOffset = uint32_t (pc - loadAddress);
+
+	uint32_t low  = 0;
+	uint32_t high = indexCount;
+
+	while (low < high) {
+		uint32_t mid	   = low + (high - low) / 2;
+		uint64_t entryAddr = indexSectionAddr + mid * sizeof (IndexEntry);
+
+		IndexEntry midEntry;
+		if (!memoryReader.Read (entryAddr, &midEntry))
+			return StackFrameLookupResult::Unknown;
+
+		if (midEntry.functionOffset <= pcOffset) {
+			low = mid + 1;
+		} else {
+			high = mid;
+		}
+	}
+
+	if (low == 0)
+		return StackFrameLookupResult::Unknown;
+
+	uint32_t   targetIndex = low - 1;
+	uint64_t   entryAddr   = indexSectionAddr + targetIndex * sizeof (IndexEntry);
+	IndexEntry entry;
+	if (!memoryReader.Read (entryAddr, &entry))
+		return StackFrameLookupResult::Unknown;
+
+	if (entry.secondLevelPagesSectionOffset == 0)
+		return StackFrameLookupResult::Unknown;
+
+	uint64_t secondLevelAddr = unwindInfoLoadAddr + entry.secondLevelPagesSectionOffset;
+
+	uint32_t kind;
+	if (!memoryReader.Read (secondLevelAddr, &kind))
+		return StackFrameLookupResult::Unknown;
+
+	uint32_t encoding = 0;
+
+	if (kind == SecondLevelRegular) {
+		RegularSecondLevelPageHeader pageHeader;
+		if (!memoryReader.Read (secondLevelAddr, &pageHeader))
+			return StackFrameLookupResult::Unknown;
+
+		uint64_t entriesAddr	= secondLevelAddr + sizeof (RegularSecondLevelPageHeader);
+		uint32_t pageEntryCount = pageHeader.entryCount;
+
+		uint32_t pLow  = 0;
+		uint32_t pHigh = pageEntryCount;
+
+		// See comment above about zero-length entries
+		while (pLow < pHigh) {
+			uint32_t pMid		= pLow + (pHigh - pLow) / 2;
+			uint64_t pEntryAddr = entriesAddr + pMid * sizeof (RegularSecondLevelEntry);
+
+			RegularSecondLevelEntry pEntry;
+			if (!memoryReader.Read (pEntryAddr, &pEntry))
+				return StackFrameLookupResult::Unknown;
+
+			if (pEntry.functionOffset <= pcOffset) {
+				pLow = pMid + 1;
+			} else {
+				pHigh = pMid;
+			}
+		}
+
+		if (pLow == 0)
+			return StackFrameLookupResult::Unknown;
+
+		uint32_t				pTargetIndex = pLow - 1;
+		uint64_t				pEntryAddr	 = entriesAddr + pTargetIndex * sizeof (RegularSecondLevelEntry);
+		RegularSecondLevelEntry pEntry;
+		if (!memoryReader.Read (pEntryAddr, &pEntry))
+			return StackFrameLookupResult::Unknown;
+
+		encoding = pEntry.encoding;
+
+	} else if (kind == SecondLevelCompressed) {
+		CompressedSecondLevelPageHeader pageHeader;
+		if (!memoryReader.Read (secondLevelAddr, &pageHeader))
+			return StackFrameLookupResult::Unknown;
+
+		uint64_t entriesAddr	= secondLevelAddr + sizeof (CompressedSecondLevelPageHeader);
+		uint32_t pageEntryCount = pageHeader.entryCount;
+
+		uint32_t baseFunctionOffset = entry.functionOffset;
+
+		uint32_t pLow  = 0;
+		uint32_t pHigh = pageEntryCount;
+
+		// See comment above about zero-length entries
+		while (pLow < pHigh) {
+			uint32_t pMid		= pLow + (pHigh - pLow) / 2;
+			uint64_t pEntryAddr = entriesAddr + pMid * sizeof (uint32_t);
+
+			uint32_t pEntryVal;
+			if (!memoryReader.Read (pEntryAddr, &pEntryVal))
+				return StackFrameLookupResult::Unknown;
+
+			uint32_t entryFuncOffset = CompressedEntryFunctionOffset (pEntryVal);
+
+			if (entryFuncOffset <= (pcOffset - baseFunctionOffset)) {
+				pLow = pMid + 1;
+			} else {
+				pHigh = pMid;
+			}
+		}
+
+		if (pLow == 0)
+			return StackFrameLookupResult::Unknown;
+
+		uint32_t pTargetIndex = pLow - 1;
+		uint64_t pEntryAddr	  = entriesAddr + pTargetIndex * sizeof (uint32_t);
+		uint32_t pEntryVal;
+		if (!memoryReader.Read (pEntryAddr, &pEntryVal))
+			return StackFrameLookupResult::Unknown;
+
+		uint32_t encodingIndex = CompressedEntryEncodingIndex (pEntryVal);
+
+		if (encodingIndex < unwindHeader.commonEncodingsArrayCount) {
+			uint64_t commonEncodingsAddr = unwindInfoLoadAddr + unwindHeader.commonEncodingsArraySectionOffset +
+										   encodingIndex * sizeof (uint32_t);
+			if (!memoryReader.Read (commonEncodingsAddr, &encoding))
+				return StackFrameLookupResult::Unknown;
+		} else {
+			uint32_t pageEncodingIndex = encodingIndex - unwindHeader.commonEncodingsArrayCount;
+			uint64_t pageEncodingsAddr =
+				secondLevelAddr + pageHeader.encodingsPageOffset + pageEncodingIndex * sizeof (uint32_t);
+			if (!memoryReader.Read (pageEncodingsAddr, &encoding))
+				return StackFrameLookupResult::Unknown;
+		}
+	} else {
+		return StackFrameLookupResult::Unknown;
+	}
+
+	const uint32_t mode = encoding & ARM64ModeMask;
+	switch (mode) {
+		case ARM64ModeFrame:
+			return StackFrameLookupResult::HasFrame;
+		case ARM64ModeFrameless:
+			return StackFrameLookupResult::Frameless;
+		default:
+			return StackFrameLookupResult::Unknown;
+	}
+}
+
+} // namespace
+
+StackFrameLookupResult LookupStackFrameForPC (StackWalkArchitecture		  architecture,
+											  const IProcessMemoryReader& memoryReader,
+											  uint64_t					  pc)
+{
+	// Not supported on x86_64, and probably never will be
+	if (architecture != StackWalkArchitecture::ARM64)
+		return StackFrameLookupResult::Unknown;
+
+	return LookupStackFrameForPCImplArm64 (memoryReader, pc);
+}
+
+size_t WalkStack (StackWalkArchitecture		  architecture,
+				  const IProcessMemoryReader& memoryReader,
+				  const StackWalkRegisters&	  registers,
+				  uint64_t*					  pFramesOut,
+				  size_t					  maxFrameCount)
+{
+	const uint64_t basePointer		  = registers.framePointer;
+	const uint64_t instructionPointer = registers.instructionPointer;
+
+	// Seems to happen in weird scenarios (LLDB is also incapable of stackwalks for these threads); maybe when a thread
+	//   is being launched/stopped?
+	if (basePointer == 0 || maxFrameCount == 0)
+		return 0;
+
+	size_t nFrames		  = 0;
+	pFramesOut[nFrames++] = instructionPointer;
+
+	// While this function implements a very basic "frame pointer chasing" algorithm, it also does some best-effort
+	// handling (on arm64) of two special cases revolving around stack frames of
+	// the top function: 1.) "partial" stack frames
+	//					 2.) frameless (~leaf) functions
+	// These cases most likely would result in a function being skipped in the stack trace.
+
+	// 1.) is e.g. when an invalid pointer is call'd, the call instruction "starts" building a new stack frame, but the
+	// frame pointer hasn't been updated yet, because the function prologue hasn't executed. There are a dozen
+	// variations of this, such as partially executed prologues and epilogues. A 100% correct solution would need a
+	// full-blown stack unwinding library with parsing compact and DWARF unwind info, instruction emulation, etc.
+
+	// For 2.), we parse the compact unwind info (if present) for the top instruction pointer to see if the function is
+	// frameless. We also handle a tiny edge case: syscall wrappers (see the explanation below)
+	bool topPCNoStackFrame = false;
+	if (architecture == StackWalkArchitecture::ARM64) {
+		if (ExceptionMightBeControlTransferRelated (registers.exceptionSyndrome) &&
+			!memoryReader.IsExecutable (instructionPointer)) {
+			// Instruction pointer points to not mapped or non-executable memory
+			topPCNoStackFrame = IsPreviousInstructionBLKind (memoryReader, registers.linkRegister);
+		}
+
+		if (!topPCNoStackFrame) {
+			auto frameLookupResult = LookupStackFrameForPC (architecture, memoryReader, instructionPointer);
+
+			// Edge case: syscall wrappers in libsystem_kernel.dylib are frameless, but they do not have corresponding
+			// unwind info. We detect this and go with "frameless" in these cases. This isn't perfect, as the PC might
+			// reside inside such a function pointing to a different instruction, but it's quite easy to cherry-pick
+			// this case. The chance of the PC being ~on the SVC instruction is somewhat high, as:
+			// - kernel to user mode and vice versa transitions take a non-trivial amount of time
+			// - syscalls themselves take a non-trivial amount of time
+			// - quite a few syscalls are for waiting on something
+			if (frameLookupResult == StackFrameLookupResult::Unknown) {
+				frameLookupResult = IsPreviousInstructionSVC (memoryReader, instructionPointer) ?
+										StackFrameLookupResult::Frameless :
+										frameLookupResult;
+			}
+			// In case of StackFrameLookupResult::Unknown, we also presume there is a frame (the safer assumption)
+			topPCNoStackFrame = frameLookupResult == StackFrameLookupResult::Frameless;
+		}
+	}
+
+	uint64_t prevBasePointer		= basePointer;
+	uint64_t nextBasePointer		= 0;
+	uint64_t nextInstructionPointer = 0;
+
+	size_t frameIndex = 0;
+	while (nFrames < maxFrameCount) {
+		const bool framelessTop = topPCNoStackFrame && frameIndex == 0;
+
+		nextInstructionPointer = framelessTop ? registers.linkRegister :
+												DerefPtr (memoryReader, prevBasePointer + sizeof prevBasePointer);
+		nextBasePointer		   = framelessTop ? prevBasePointer : DerefPtr (memoryReader, prevBasePointer);
+
+		if (nextBasePointer == 0)
+			break; // Stack walk finished
+
+		pFramesOut[nFrames++] = nextInstructionPointer;
+
+		prevBasePointer = nextBasePointer;
+
+		++frameIndex;
+	}
+
+	return nFrames;
+}
+
+} // namespace MMD
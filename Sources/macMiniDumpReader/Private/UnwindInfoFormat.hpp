@@ -0,0 +1,95 @@
+#ifndef MMD_UNWINDINFOFORMAT
+#define MMD_UNWINDINFOFORMAT
+
+#pragma once
+
+#include <cstdint>
+
+namespace MMD {
+namespace UnwindInfoFormat {
+
+// The parts of the compact unwind info format (the __unwind_info section of images) used for stack walking, defined
+//   here (instead of using <mach-o/compact_unwind_encoding.h>), so that stacks can be walked on any platform. Layouts
+//   and values are the same as in the system headers.
+
+// Followed by nsects of these in a segment command
+struct Section64 {
+	char	 sectname[16];
+	char	 segname[16];
+	uint64_t addr;
+	uint64_t size;
+	uint32_t offset;
+	uint32_t align;
+	uint32_t reloff;
+	uint32_t nreloc;
+	uint32_t flags;
+	uint32_t reserved1;
+	uint32_t reserved2;
+	uint32_t reserved3;
+};
+
+struct SectionHeader {
+	uint32_t version;
+	uint32_t commonEncodingsArraySectionOffset;
+	uint32_t commonEncodingsArrayCount;
+	uint32_t personalityArraySectionOffset;
+	uint32_t personalityArrayCount;
+	uint32_t indexSectionOffset;
+	uint32_t indexCount;
+};
+
+struct IndexEntry {
+	uint32_t functionOffset;
+	uint32_t secondLevelPagesSectionOffset;
+	uint32_t lsdaIndexArraySectionOffset;
+};
+
+constexpr uint32_t SecondLevelRegular	 = 2; // UNWIND_SECOND_LEVEL_REGULAR
+constexpr uint32_t SecondLevelCompressed = 3; // UNWIND_SECOND_LEVEL_COMPRESSED
+
+struct RegularSecondLevelPageHeader {
+	uint32_t kind;
+	uint16_t entryPageOffset;
+	uint16_t entryCount;
+};
+
+struct RegularSecondLevelEntry {
+	uint32_t functionOffset;
+	uint32_t encoding;
+};
+
+// Followed by entryCount 32-bit entries: a function offset (relative to the one of the index entry) in the low 24
+//   bits, and an index into the common encodings, then the encodings of the page, in the high 8 bits
+struct CompressedSecondLevelPageHeader {
+	uint32_t kind;
+	uint16_t entryPageOffset;
+	uint16_t entryCount;
+	uint16_t encodingsPageOffset;
+	uint16_t encodingsCount;
+};
+
+constexpr uint32_t CompressedEntryFunctionOffset (uint32_t entry)
+{
+	return entry & 0x00FFFFFF;
+}
+
+constexpr uint32_t CompressedEntryEncodingIndex (uint32_t entry)
+{
+	return (entry >> 24) & 0xFF;
+}
+
+constexpr uint32_t ARM64ModeMask	  = 0x0F000000; // UNWIND_ARM64_MODE_MASK
+constexpr uint32_t ARM64ModeFrameless = 0x02000000; // UNWIND_ARM64_MODE_FRAMELESS
+constexpr uint32_t ARM64ModeFrame	  = 0x04000000; // UNWIND_ARM64_MODE_FRAME
+
+static_assert (sizeof (Section64) == 80);
+static_assert (sizeof (SectionHeader) == 28);
+static_assert (sizeof (IndexEntry) == 12);
+static_assert (sizeof (RegularSecondLevelPageHeader) == 8);
+static_assert (sizeof (RegularSecondLevelEntry) == 8);
+static_assert (sizeof (CompressedSecondLevelPageHeader) == 12);
+
+} // namespace UnwindInfoFormat
+} // namespace MMD
+
+#endif // MMD_UNWINDINFOFORMAT
@@ -394,7 +394,7 @@ def add_testcase(fixture, name, operation, oop: bool, background_thread: bool, e
         testcases[fixture] = []
     testcases[fixture].append({"name": name, "operation": operation, "oop": oop, "background_thread": background_thread, "expectation": expectation})
 
-operations = ["CreateCore", "CreateCoreFromC", "CrashInvalidPtrWrite", "CrashInvalidPtrWriteFromObjC", "CrashNullPtrCall", "CrashInvalidPtrCall", "CrashNonExecutablePtrCall", "AbortPureVirtualCall", "AbortUnhandledObjCException"]
+operations = ["CreateCore", "CreateCoreSequential", "CreateCorePipelined", "CreateCoreParallel", "CreateCorePageAligned", "CreateCoreSparse", "CreateCoreDeduplicated", "EstimateSizeThenCreateCore", "CreateCoreWithMemoryBudget", "CreateCoreMemoryMapped", "CreateCoreInMemory", "CreateCoreBuffered", "CreateCoreChecksummed", "CreateCoreCompressed", "CreateCoreRateLimited", "CreateCoreDirectIO", "CreateCoreAsync", "CreateCoreInDumpFilePool", "CreateCoreSpooled", "CreateCoreThenRead", "CreateCoreThenReadMemory", "CreateCoreThenWalkStacks", "CreateCoreThenListImages", "CreateCoresThenCompareSignatures", "CreateCoreThenFindFaultingThread", "CreateCoreFromC", "CrashInvalidPtrWrite", "CrashInvalidPtrWriteFromObjC", "CrashNullPtrCall", "CrashInvalidPtrCall", "CrashNonExecutablePtrCall", "AbortPureVirtualCall", "AbortUnhandledObjCException"]
 operation_expectation_overrides = {
     "CrashInvalidPtrWriteFromObjC": CoreFileTestExpectation(relevant_func_name="crashInvalidPtrWrite"),
 }
@@ -1,22 +1,48 @@
 #include <mach-o/dyld.h>
+#include <mach-o/loader.h>
 #include <mach/mach.h>
 #include <malloc/malloc.h>
 
+#include <cstdio>
 #include <cstring>
+#include <dlfcn.h>
 #include <fcntl.h>
 #include <inttypes.h>
 #include <spawn.h>
+#include <sys/stat.h>
 #include <syslog.h>
 #include <unistd.h>
 
+#include <algorithm>
+#include <chrono>
 #include <functional>
 #include <iostream>
 #include <map>
 #include <string>
 #include <thread>
-
+#include <vector>
+
+#include "MMD/AsyncFileOStream.hpp"
+#include "MMD/BufferedOStream.hpp"
+#include "MMD/CRC32C.hpp"
+#include "MMD/CompressedFileReader.hpp"
+#include "MMD/CompressedOStream.hpp"
+#include "MMD/CoreAddressIndex.hpp"
+#include "MMD/CoreFileReader.hpp"
+#include "MMD/CoreImageList.hpp"
+#include "MMD/CoreStackWalker.hpp"
+#include "MMD/CrashSignature.hpp"
+#include "MMD/DirectFileOStream.hpp"
+#include "MMD/DumpFilePool.hpp"
 #include "MMD/FileOStream.hpp"
+#include "MMD/LocalDirectorySpoolTransport.hpp"
 #include "MMD/MacMiniDump.hpp"
+#include "MMD/MemoryOStream.hpp"
+#include "MMD/MmapOStream.hpp"
+#include "MMD/PipeOStream.hpp"
+#include "MMD/RateLimitedOStream.hpp"
+#include "MMD/SpoolOStream.hpp"
+#include "MMD/SpoolUploader.hpp"
 
 #define NOINLINE __attribute__ ((noinline))
 
@@ -183,6 +209,776 @@ NOINLINE bool CreateCoreFile (const std::string& corePath)
 	return CreateCoreFileImpl (mach_task_self (), corePath);
 }
 
+NOINLINE bool CreateCoreFilePipelined (const std::string& corePath)
+{
+	int fd = open (corePath.c_str (), O_WRONLY | O_CREAT | O_TRUNC, 0666);
+	if (fd < 0)
+		return false;
+
+	MMD::FileOStream fos (fd);
+
+	MMD::Options options = {};
+
+	// Small chunks, so that stacks span multiple of them
+	options.payloadChunkSize	 = 4'096;
+	options.payloadPipelineDepth = 3;
+
+	return MiniDumpWriteDump (mach_task_self (), &fos, nullptr, &options);
+}
+
+NOINLINE bool CreateCoreFileInParallel (const std::string& corePath)
+{
+	int fd = open (corePath.c_str (), O_WRONLY | O_CREAT | O_TRUNC, 0666);
+	if (fd < 0)
+		return false;
+
+	MMD::FileOStream fos (fd);
+
+	MMD::Options options = {};
+
+	// Small chunks, so that each writer thread has to write stacks in multiple steps
+	options.payloadChunkSize  = 4'096;
+	options.writerThreadCount = 4;
+
+	return MiniDumpWriteDump (mach_task_self (), &fos, nullptr, &options);
+}
+
+NOINLINE bool CreateCoreFilePageAligned (const std::string& corePath)
+{
+	int fd = open (corePath.c_str (), O_RDWR | O_CREAT | O_TRUNC, 0666);
+	if (fd < 0)
+		return false;
+
+	MMD::FileOStream fos (fd);
+
+	MMD::Statistics statistics = {};
+	MMD::Options	options	   = {};
+
+	options.segmentPageAlignment = 16'384;
+	options.pStatistics			 = &statistics;
+
+	if (!MiniDumpWriteDump (mach_task_self (), &fos, nullptr, &options))
+		return false;
+
+	// The reported size must match reality
+	struct stat fileInfo;
+	if (fstat (fd, &fileInfo) != 0)
+		return false;
+
+	return uint64_t (fileInfo.st_size) == statistics.coreFileSize &&
+		   statistics.segmentAlignmentOverhead < statistics.coreFileSize;
+}
+
+NOINLINE bool CreateCoreFileSparse (const std::string& corePath)
+{
+	int fd = open (corePath.c_str (), O_WRONLY | O_CREAT | O_TRUNC, 0666);
+	if (fd < 0)
+		return false;
+
+	MMD::FileOStream fos (fd);
+
+	MMD::Options options = {};
+	options.sparseOutput = 1;
+
+	return MiniDumpWriteDump (mach_task_self (), &fos, nullptr, &options);
+}
+
+NOINLINE bool CreateCoreFileDeduplicated (const std::string& corePath)
+{
+	int fd = open (corePath.c_str (), O_WRONLY | O_CREAT | O_TRUNC, 0666);
+	if (fd < 0)
+		return false;
+
+	MMD::FileOStream fos (fd);
+
+	MMD::Options options	  = {};
+	options.pageDeduplication = 1;
+
+	return MiniDumpWriteDump (mach_task_self (), &fos, nullptr, &options);
+}
+
+NOINLINE bool EstimateSizeThenCreateCoreFile (const std::string& corePath)
+{
+	MMD::Statistics estimate = {};
+	if (!MMD::MiniDumpEstimateSize (mach_task_self (), &estimate) || estimate.coreFileSize == 0 ||
+		estimate.segmentCount == 0)
+		return false;
+
+	int fd = open (corePath.c_str (), O_RDWR | O_CREAT | O_TRUNC, 0666);
+	if (fd < 0)
+		return false;
+
+	MMD::FileOStream fos (fd);
+
+	MMD::Statistics statistics = {};
+	MMD::Options	options	   = {};
+	options.preallocate		   = 1;
+	options.pStatistics		   = &statistics;
+
+	if (!MiniDumpWriteDump (mach_task_self (), &fos, nullptr, &options))
+		return false;
+
+	// Stacks are not frozen between the two calls (e.g. this one is deeper during the second), so the sizes might
+	//   differ a bit
+	const uint64_t larger  = std::max (statistics.coreFileSize, estimate.coreFileSize);
+	const uint64_t smaller = std::min (statistics.coreFileSize, estimate.coreFileSize);
+
+	return larger - smaller <= estimate.coreFileSize / 10;
+}
+
+NOINLINE bool CreateCoreFileWithMemoryBudget (const std::string& corePath)
+{
+	// A tiny budget has to drop ranges (the stack walk of LLDB would not work with such a core, so it is not written)
+	MMD::Statistics unlimited = {};
+	MMD::Statistics tiny	  = {};
+	MMD::Options	options	  = {};
+	options.memoryBudget	  = 4'096;
+	if (!MMD::MiniDumpEstimateSize (mach_task_self (), &unlimited) ||
+		!MMD::MiniDumpEstimateSize (mach_task_self (), &tiny, nullptr, &options))
+		return false;
+
+	if (unlimited.droppedRangeCount != 0 || tiny.droppedRangeCount == 0 || tiny.coreFileSize >= unlimited.coreFileSize)
+		return false;
+
+	int fd = open (corePath.c_str (), O_WRONLY | O_CREAT | O_TRUNC, 0666);
+	if (fd < 0)
+		return false;
+
+	MMD::FileOStream fos (fd);
+
+	// A generous budget drops nothing, but the (empty) list of dropped ranges is still recorded
+	MMD::Statistics statistics = {};
+	options.memoryBudget	   = 64 * 1'024 * 1'024;
+	options.pStatistics		   = &statistics;
+
+	if (!MiniDumpWriteDump (mach_task_self (), &fos, nullptr, &options))
+		return false;
+
+	return statistics.droppedRangeCount == 0 && statistics.droppedBytes == 0;
+}
+
+NOINLINE bool CreateCoreFileMemoryMapped (const std::string& corePath)
+{
+	int fd = open (corePath.c_str (), O_RDWR | O_CREAT | O_TRUNC, 0666);
+	if (fd < 0)
+		return false;
+
+	MMD::Statistics statistics = {};
+	MMD::Options	options	   = {};
+	options.writerThreadCount  = 4;
+	options.pStatistics		   = &statistics;
+
+	{
+		MMD::MmapOStream mos (dup (fd));
+		if (!MiniDumpWriteDump (mach_task_self (), &mos, nullptr, &options))
+			return false;
+	}
+
+	// Storage is allocated in large steps while writing, but the file must not have grown past the core
+	struct stat fileInfo;
+	const bool	trimmed = fstat (fd, &fileInfo) == 0 && uint64_t (fileInfo.st_size) == statistics.coreFileSize;
+	close (fd);
+
+	return trimmed;
+}
+
+NOINLINE bool CreateCoreFileInMemory (const std::string& corePath)
+{
+	// Small chunks, so that many writes cross chunk boundaries
+	MMD::MemoryOStream mos (4'096);
+	if (!MiniDumpWriteDump (mach_task_self (), &mos))
+		return false;
+
+	int fd = open (corePath.c_str (), O_WRONLY | O_CREAT | O_TRUNC, 0666);
+	if (fd < 0)
+		return false;
+
+	// Hand the chunks over as they are, like a sender would
+	MMD::FileOStream fos (fd);
+
+	return fos.WriteV (mos.GetIOVecs (), mos.GetIOVecCount ());
+}
+
+NOINLINE bool CreateCoreFileBuffered (const std::string& corePath)
+{
+	int fd = open (corePath.c_str (), O_WRONLY | O_CREAT | O_TRUNC, 0666);
+	if (fd < 0)
+		return false;
+
+	MMD::FileOStream fos (fd);
+	// Smaller than some stacks, so that both buffered writes and ones bypassing the buffer happen
+	MMD::BufferedOStream bos (&fos, 16'384);
+
+	return MiniDumpWriteDump (mach_task_self (), &bos) && bos.Flush ();
+}
+
+NOINLINE bool CreateCoreFileChecksummed (const std::string& corePath)
+{
+	int fd = open (corePath.c_str (), O_RDWR | O_CREAT | O_TRUNC, 0666);
+	if (fd < 0)
+		return false;
+
+	MMD::FileOStream fos (fd);
+
+	// Parallel writing, so that the checksummed data is not written in order
+	MMD::Statistics statistics = {};
+	MMD::Options	options	   = {};
+	options.payloadChunkSize   = 4'096;
+	options.writerThreadCount  = 4;
+	options.checksum		   = 1;
+	options.pStatistics		   = &statistics;
+
+	if (!MiniDumpWriteDump (mach_task_self (), &fos, nullptr, &options))
+		return false;
+
+	// Read the file back, and verify the digest in the "crc32c digest" note
+	struct stat fileInfo;
+	if (fstat (fd, &fileInfo) != 0 || uint64_t (fileInfo.st_size) != statistics.coreFileSize)
+		return false;
+
+	std::vector<char> content (fileInfo.st_size);
+	if (pread (fd, content.data (), content.size (), 0) != ssize_t (content.size ()))
+		return false;
+
+	const mach_header_64* pHeader	= reinterpret_cast<const mach_header_64*> (content.data ());
+	const char*			  pCommand	= content.data () + sizeof *pHeader;
+	const note_command*	  pDigestNc = nullptr;
+	for (uint32_t i = 0; i < pHeader->ncmds; ++i) {
+		const load_command* pLc = reinterpret_cast<const load_command*> (pCommand);
+		if (pLc->cmd == LC_NOTE) {
+			const note_command* pNc = reinterpret_cast<const note_command*> (pCommand);
+			if (strncmp (pNc->data_owner, "crc32c digest", sizeof pNc->data_owner) == 0)
+				pDigestNc = pNc;
+		}
+
+		pCommand += pLc->cmdsize;
+	}
+
+	struct {
+		uint32_t version;
+		uint32_t crc32c;
+		uint64_t checksummedSize;
+	} digest;
+
+	if (pDigestNc == nullptr || pDigestNc->size != sizeof digest)
+		return false;
+
+	// Nothing may follow the digest
+	if (pDigestNc->offset + sizeof digest != content.size ())
+		return false;
+
+	memcpy (&digest, content.data () + pDigestNc->offset, sizeof digest);
+
+	return digest.version == 1 && digest.checksummedSize == pDigestNc->offset && digest.crc32c == statistics.crc32c &&
+		   MMD::CRC32C (content.data (), digest.checksummedSize) == digest.crc32c;
+}
+
+NOINLINE bool CreateCoreFileCompressed (const std::string& corePath)
+{
+	const std::string containerPath = corePath + ".mmdz";
+	{
+		int fd = open (containerPath.c_str (), O_WRONLY | O_CREAT | O_TRUNC | O_APPEND, 0666);
+		if (fd < 0)
+			return false;
+
+		MMD::PipeOStream	   pos (fd);
+		MMD::CompressedOStream cos (&pos, 4, 65'536);
+		if (!MiniDumpWriteDump (mach_task_self (), &cos) || !cos.Finish ())
+			return false;
+	}
+
+	// Recreate the core file from the container (for the checks of the test), with reads in reverse order
+	MMD::CompressedFileReader reader (containerPath.c_str ());
+	unlink (containerPath.c_str ());
+	if (!reader.IsValid ())
+		return false;
+
+	// Reading a few bytes should only decompress the frame covering them
+	char header[sizeof (mach_header_64)];
+	if (!reader.Read (0, sizeof header, header) || reader.GetDecompressedFrameCount () != 1)
+		return false;
+
+	int fd = open (corePath.c_str (), O_WRONLY | O_CREAT | O_TRUNC, 0666);
+	if (fd < 0)
+		return false;
+
+	MMD::FileOStream fos (fd);
+
+	const uint64_t	  pieceSize = 100'000;
+	std::vector<char> piece (pieceSize);
+	for (uint64_t end = reader.GetSize (); end > 0;) {
+		const uint64_t begin = end > pieceSize ? end - pieceSize : 0;
+		if (!reader.Read (begin, end - begin, piece.data ()) || !fos.WriteAt (piece.data (), end - begin, begin))
+			return false;
+
+		end = begin;
+	}
+
+	return true;
+}
+
+NOINLINE bool CreateCoreFileRateLimited (const std::string& corePath)
+{
+	// The burst is a fraction of the core, so that most of it has to be paced whatever the size of the process
+	MMD::Statistics estimate = {};
+	if (!MMD::MiniDumpEstimateSize (mach_task_self (), &estimate) || estimate.coreFileSize == 0)
+		return false;
+
+	int fd = open (corePath.c_str (), O_WRONLY | O_CREAT | O_TRUNC, 0666);
+	if (fd < 0)
+		return false;
+
+	const uint64_t BytesPerSecond = 512 * 1'024 * 1'024;
+	const size_t   BurstSize	  = std::max<size_t> (estimate.coreFileSize / 4, 4'096);
+
+	MMD::FileOStream		fos (fd);
+	MMD::RateLimitedOStream rlos (&fos, BytesPerSecond, BurstSize, 100);
+
+	// Parallel writing, so that writers share the bucket
+	MMD::Statistics statistics = {};
+	MMD::Options	options	   = {};
+	options.writerThreadCount  = 4;
+	options.pStatistics		   = &statistics;
+
+	const auto start = std::chrono::steady_clock::now ();
+	if (!MiniDumpWriteDump (mach_task_self (), &rlos, nullptr, &options))
+		return false;
+
+	const auto elapsed = std::chrono::steady_clock::now () - start;
+
+	// Everything beyond the initial burst has to be paced
+	if (statistics.coreFileSize <= BurstSize)
+		return false;
+
+	const double minSeconds = double (statistics.coreFileSize - BurstSize) / BytesPerSecond;
+
+	return std::chrono::duration<double> (elapsed).count () >= minSeconds * 0.95 && rlos.GetThrottledNanoseconds () > 0;
+}
+
+NOINLINE bool CreateCoreFileWithDirectIO (const std::string& corePath)
+{
+	int fd = open (corePath.c_str (), O_RDWR | O_CREAT | O_TRUNC, 0666);
+	if (fd < 0)
+		return false;
+
+	MMD::DirectFileOStream dfos (fd);
+
+	// Page-aligned segments, so that both block-aligned and unaligned writes happen
+	MMD::Statistics statistics	 = {};
+	MMD::Options	options		 = {};
+	options.segmentPageAlignment = 4'096;
+	options.pStatistics			 = &statistics;
+
+	return MiniDumpWriteDump (mach_task_self (), &dfos, nullptr, &options) && dfos.Flush () &&
+		   dfos.GetSize () == statistics.coreFileSize;
+}
+
+NOINLINE bool CreateCoreFileAsynchronously (const std::string& corePath)
+{
+	int fd = open (corePath.c_str (), O_WRONLY | O_CREAT | O_TRUNC, 0666);
+	if (fd < 0)
+		return false;
+
+	// Few, small buffers, so that submissions have to wait for completions, while writer threads write concurrently
+	MMD::AsyncFileOStream afos (fd, 4, 16 * 1'024);
+
+	MMD::Statistics statistics = {};
+	MMD::Options	options	   = {};
+	options.writerThreadCount  = 4;
+	options.pStatistics		   = &statistics;
+
+	return MiniDumpWriteDump (mach_task_self (), &afos, nullptr, &options) && afos.Flush () &&
+		   afos.GetSize () == statistics.coreFileSize && afos.GetSubmissionCount () > 1;
+}
+
+NOINLINE bool CreateCoreFileInDumpFilePool (const std::string& corePath)
+{
+	MMD::Statistics estimate = {};
+	if (!MMD::MiniDumpEstimateSize (mach_task_self (), &estimate))
+		return false;
+
+	const std::string poolPath = corePath + ".pool";
+	if (mkdir (poolPath.c_str (), 0777) != 0)
+		return false;
+
+	const size_t SlotCount = 2;
+	const size_t SlotSize  = estimate.coreFileSize * 2;
+
+	bool succeeded = false;
+	{
+		MMD::DumpFilePool pool (poolPath.c_str (), SlotCount, SlotSize);
+
+		// Fill the first slot with something, so that the core file goes into the second (oldest first), and has to
+		//   replace what the first one had
+		MMD::IRandomAccessBinaryOStream* pOStream = pool.AcquireSlot ();
+		if (pool.IsValid () && pOStream != nullptr && pOStream->Write ("placeholder", 11) && pool.CommitSlot ()) {
+			pOStream = pool.AcquireSlot ();
+			if (pOStream != nullptr && MiniDumpWriteDump (mach_task_self (), pOStream) && pool.CommitSlot ())
+				succeeded = true;
+		}
+	}
+
+	// Retrieve the most recent core file with a new pool object, just like after a relaunch
+	if (succeeded) {
+		MMD::DumpFilePool pool (poolPath.c_str (), SlotCount, SlotSize);
+
+		uint64_t sequence;
+		uint64_t size;
+		int		 fd = open (corePath.c_str (), O_WRONLY | O_CREAT | O_TRUNC, 0666);
+		if (fd < 0) {
+			succeeded = false;
+		} else {
+			MMD::PipeOStream pos (fd);
+			succeeded = pool.GetSlotInfo (1, &sequence, &size) && sequence == 2 && pool.CopySlot (1, &pos);
+		}
+	}
+
+	for (size_t i = 0; i < SlotCount; ++i)
+		unlink ((poolPath + "/slot" + std::to_string (i) + ".mmdslot").c_str ());
+
+	rmdir (poolPath.c_str ());
+
+	return succeeded;
+}
+
+// Stands in for a connection lost in the middle of an upload
+class FailingSpoolTransport : public MMD::LocalDirectorySpoolTransport {
+public:
+	FailingSpoolTransport (const char* directoryPath, uint64_t chunksBeforeFailure):
+		LocalDirectorySpoolTransport (directoryPath),
+		m_chunksLeft (chunksBeforeFailure)
+	{
+	}
+
+	virtual bool SendChunk (uint64_t spoolId, uint64_t chunkIndex, const void* pData, size_t size, uint32_t crc32c)
+		override
+	{
+		if (m_chunksLeft == 0)
+			return false;
+
+		--m_chunksLeft;
+
+		return LocalDirectorySpoolTransport::SendChunk (spoolId, chunkIndex, pData, size, crc32c);
+	}
+
+private:
+	uint64_t m_chunksLeft;
+};
+
+void RemoveSpool (const std::string& spoolPath)
+{
+	// Chunks are numbered from 0, without gaps
+	for (uint64_t i = 0;; ++i) {
+		char chunkName[32];
+		snprintf (chunkName, sizeof chunkName, "/chunk%06" PRIu64 ".mmdchunk", i);
+		if (unlink ((spoolPath + chunkName).c_str ()) != 0)
+			break;
+	}
+
+	unlink ((spoolPath + "/manifest.mmdspool").c_str ());
+	unlink ((spoolPath + "/progress.mmdspool").c_str ());
+	rmdir (spoolPath.c_str ());
+}
+
+NOINLINE bool CreateCoreFileSpooled (const std::string& corePath)
+{
+	const std::string spoolPath	   = corePath + ".spool";
+	const std::string receivedPath = corePath + ".received";
+	if (mkdir (spoolPath.c_str (), 0777) != 0 || mkdir (receivedPath.c_str (), 0777) != 0)
+		return false;
+
+	// Small chunks, so that there are many of them
+	bool succeeded = false;
+	{
+		MMD::SpoolOStream sos (spoolPath.c_str (), 256 * 1'024);
+		succeeded = MiniDumpWriteDump (mach_task_self (), &sos) && sos.Finish ();
+	}
+
+	// The first upload fails midway, the second one has to pick up where it left off
+	const uint64_t ChunksBeforeFailure = 3;
+	uint64_t	   chunkCount		   = 0;
+	if (succeeded) {
+		FailingSpoolTransport failingTransport (receivedPath.c_str (), ChunksBeforeFailure);
+		MMD::SpoolUploader	  uploader (spoolPath.c_str (), &failingTransport);
+		chunkCount = uploader.GetChunkCount ();
+		succeeded  = chunkCount > ChunksBeforeFailure && !uploader.Upload () &&
+					 uploader.GetAcknowledgedChunkCount () == ChunksBeforeFailure;
+	}
+
+	if (succeeded) {
+		MMD::LocalDirectorySpoolTransport transport (receivedPath.c_str ());
+		MMD::SpoolUploader				  uploader (spoolPath.c_str (), &transport);
+		succeeded = uploader.Upload () && uploader.GetSentChunkCount () == chunkCount - ChunksBeforeFailure;
+	}
+
+	if (succeeded) {
+		int fd = open (corePath.c_str (), O_WRONLY | O_CREAT | O_TRUNC, 0666);
+		if (fd < 0) {
+			succeeded = false;
+		} else {
+			MMD::PipeOStream pos (fd);
+			succeeded = MMD::AssembleSpool (receivedPath.c_str (), &pos);
+		}
+	}
+
+	RemoveSpool (spoolPath);
+	RemoveSpool (receivedPath);
+
+	return succeeded;
+}
+
+// Reads the core file back: every thread has registers, every segment and note payload is within the file
+NOINLINE bool CreateCoreFileThenRead (const std::string& corePath)
+{
+	if (!CreateCoreFileImpl (mach_task_self (), corePath))
+		return false;
+
+	MMD::CoreFileReader reader (corePath.c_str ());
+	if (!reader.IsValid () || reader.GetThreadCount () == 0 || reader.GetSegmentCount () == 0)
+		return false;
+
+#ifdef __x86_64__
+	const int32_t  CPUType	 = MMD::CoreFileFormat::CPUTypeX86_64;
+	const uint32_t GPRFlavor = MMD::CoreFileFormat::X86ThreadState64Flavor;
+#elif defined __arm64__
+	const int32_t  CPUType	 = MMD::CoreFileFormat::CPUTypeARM64;
+	const uint32_t GPRFlavor = MMD::CoreFileFormat::ARMThreadState64Flavor;
+#endif
+
+	if (reader.GetHeader ()->cputype != CPUType)
+		return false;
+
+	for (size_t i = 0; i < reader.GetThreadCount (); ++i) {
+		MMD::CoreFileReader::ThreadState gpr;
+		if (!reader.FindThreadState (i, GPRFlavor, &gpr) || gpr.count == 0)
+			return false;
+	}
+
+	for (size_t i = 0; i < reader.GetSegmentCount (); ++i) {
+		const char* pData;
+		uint64_t	size;
+		if (!reader.GetSegmentData (i, &pData, &size))
+			return false;
+	}
+
+	const char* pData;
+	uint64_t	size;
+
+	return reader.FindNoteData (MMD::CoreFileFormat::AllImageInfosOwner, &pData, &size) &&
+		   size >= sizeof (MMD::CoreFileFormat::AllImageInfosHeader) &&
+		   reader.FindNoteData (MMD::CoreFileFormat::MainBinSpecOwner, &pData, &size) &&
+		   size == sizeof (MMD::CoreFileFormat::MainBinSpec);
+}
+
+NOINLINE bool CreateCoreFileThenReadMemory (const std::string& corePath)
+{
+	// Stacks are always in the core file, so this local should be, too
+	volatile uint64_t marker[4] = { 0x20250425, 0xFEEDFACF, 0x12345678, 0x0BADC0DE };
+
+	if (!CreateCoreFileImpl (mach_task_self (), corePath))
+		return false;
+
+	MMD::CoreFileReader reader (corePath.c_str ());
+	if (!reader.IsValid ())
+		return false;
+
+	const uint64_t markerAddress = reinterpret_cast<uintptr_t> (&marker[0]);
+	for (MMD::CoreAddressIndex::Layout layout :
+		 { MMD::CoreAddressIndex::Layout::Sorted, MMD::CoreAddressIndex::Layout::Eytzinger }) {
+		MMD::CoreAddressIndex index (reader, layout);
+		if (!index.IsValid () || index.GetRangeCount () == 0)
+			return false;
+
+		uint64_t values[4] = {};
+		if (!index.Read (markerAddress, sizeof values, values))
+			return false;
+
+		uint64_t										batchValues[4] = {};
+		std::vector<MMD::CoreAddressIndex::ReadRequest> requests;
+		for (size_t i = 0; i < 4; ++i)
+			requests.push_back ({ markerAddress + i * sizeof (uint64_t), sizeof (uint64_t), &batchValues[i] });
+
+		if (index.ReadBatch (requests.data (), requests.size ()) != requests.size ())
+			return false;
+
+		for (size_t i = 0; i < 4; ++i) {
+			if (values[i] != marker[i] || batchValues[i] != marker[i])
+				return false;
+		}
+
+		// Nothing is mapped at address zero
+		if (index.Find (0) != MMD::CoreAddressIndex::NotFound || index.GetPointer (0, 1) != nullptr)
+			return false;
+	}
+
+	return true;
+}
+
+// The images of the process are listed, and the one of this function is found by address
+NOINLINE bool CreateCoreFileThenListImages (const std::string& corePath)
+{
+	if (!CreateCoreFileImpl (mach_task_self (), corePath))
+		return false;
+
+	MMD::CoreFileReader reader (corePath.c_str ());
+	MMD::CoreImageList	imageList (reader);
+	if (!imageList.IsValid () || imageList.GetImageCount () == 0)
+		return false;
+
+	Dl_info info;
+	if (dladdr (reinterpret_cast<const void*> (&CreateCoreFileThenListImages), &info) == 0)
+		return false;
+
+	const size_t imageIndex = imageList.FindImage (reinterpret_cast<uintptr_t> (&CreateCoreFileThenListImages));
+	if (imageIndex == MMD::CoreImageList::NotFound)
+		return false;
+
+	return imageList.GetImage (imageIndex).loadAddress == reinterpret_cast<uintptr_t> (info.dli_fbase);
+}
+
+// Walks the stacks of the threads in the core file, as the offline tools do
+NOINLINE bool CreateCoreFileThenWalkStacks (const std::string& corePath)
+{
+	if (!CreateCoreFileImpl (mach_task_self (), corePath))
+		return false;
+
+	MMD::CoreFileReader reader (corePath.c_str ());
+	if (!reader.IsValid ())
+		return false;
+
+	MMD::CoreStackWalker walker (reader);
+	if (!walker.IsValid () || walker.GetThreadCount () == 0)
+		return false;
+
+	// The state of the thread creating the core file is not reliable, but the other threads of this process are blocked
+	//   deep enough in libsystem
+	size_t				  maxFrameCount = 0;
+	std::vector<uint64_t> frames (1024);
+	for (size_t i = 0; i < walker.GetThreadCount (); ++i) {
+		const size_t nFrames = walker.WalkThread (i, frames.data (), frames.size ());
+		maxFrameCount		 = std::max (maxFrameCount, nFrames);
+	}
+
+	return maxFrameCount >= 3;
+}
+
+bool LaunchOOPWorkerForOperation (const std::string& operation,
+								  bool				 onBackgroundThread,
+								  const std::string& corePath,
+								  MMDCrashContext*	 pCrashContextOut = nullptr);
+
+// A worker process (loaded at a different address, because of ASLR) creates a core file, too. Each of its threads
+//   blocked in a system call is fully walked, its frames are all within images, and it has the same signature as a
+//   thread of this process. The thread spinning in the main executable is skipped, as it stopped at an arbitrary
+//   instruction.
+NOINLINE bool CreateCoreFilesThenCompareSignatures (const std::string& corePath)
+{
+	const std::string workerCorePath = corePath + ".worker";
+
+	const bool created = CreateCoreFileImpl (mach_task_self (), corePath) &&
+						 LaunchOOPWorkerForOperation ("CreateCore", false, workerCorePath);
+
+	MMD::CoreFileReader reader (corePath.c_str ());
+	MMD::CoreFileReader workerReader (workerCorePath.c_str ());
+	unlink (workerCorePath.c_str ());
+
+	if (!created)
+		return false;
+
+	MMD::CrashSignatureGenerator generator (reader);
+	MMD::CrashSignatureGenerator workerGenerator (workerReader);
+	MMD::CoreImageList			 imageList (reader);
+	if (!generator.IsValid () || !workerGenerator.IsValid () || !imageList.IsValid ())
+		return false;
+
+	const size_t mainImageIndex = imageList.FindImage (reinterpret_cast<uintptr_t> (&Spin));
+	if (mainImageIndex == MMD::CoreImageList::NotFound)
+		return false;
+
+	const uint8_t* pMainImageUUID = imageList.GetImage (mainImageIndex).pUUID;
+
+	std::vector<MMD::CrashSignatureGenerator::Signature> signatures;
+	for (size_t i = 0; i < reader.GetThreadCount (); ++i) {
+		MMD::CrashSignatureGenerator::Signature signature;
+		if (generator.Generate (i, MMD::CrashSignatureGenerator::DefaultFrameCount, &signature))
+			signatures.push_back (signature);
+	}
+
+	size_t matchCount = 0;
+	for (size_t i = 0; i < workerReader.GetThreadCount (); ++i) {
+		MMD::CrashSignatureGenerator::Frame frames[MMD::CrashSignatureGenerator::DefaultFrameCount];
+		if (workerGenerator.GetFrames (i, frames, std::size (frames)) != std::size (frames) ||
+			memcmp (frames[0].imageUUID, pMainImageUUID, sizeof frames[0].imageUUID) == 0)
+			continue;
+
+		const uint8_t noUUID[16] = {};
+		for (const MMD::CrashSignatureGenerator::Frame& frame : frames) {
+			if (memcmp (frame.imageUUID, noUUID, sizeof noUUID) == 0)
+				return false;
+		}
+
+		MMD::CrashSignatureGenerator::Signature signature;
+		if (!workerGenerator.Generate (i, std::size (frames), &signature))
+			return false;
+
+		const bool matches = std::any_of (signatures.begin (), signatures.end (), [&signature] (const auto& other) {
+			return other.low == signature.low && other.high == signature.high;
+		});
+		if (!matches)
+			return false;
+
+		++matchCount;
+	}
+
+	return matchCount > 0;
+}
+
+// A worker process crashes, and the thread found to have crashed in its core file is the one that faulted
+NOINLINE bool CreateCoreFileThenFindFaultingThread (const std::string& corePath)
+{
+	const std::string workerCorePath = corePath + ".worker";
+
+	MMDCrashContext crashContext;
+	const bool		created =
+		CreateCoreFileImpl (mach_task_self (), corePath) &&
+		LaunchOOPWorkerForOperation ("CrashInvalidPtrWrite", false, workerCorePath, &crashContext);
+
+	MMD::CoreFileReader reader (workerCorePath.c_str ());
+	unlink (workerCorePath.c_str ());
+
+	if (!created)
+		return false;
+
+	MMD::CrashSignatureGenerator generator (reader);
+	MMD::CoreStackWalker		 walker (reader);
+	const size_t				 crashedThreadIndex = generator.FindCrashedThread ();
+	if (crashedThreadIndex == MMD::CrashSignatureGenerator::NotFound)
+		return false;
+
+#ifdef __x86_64__
+	const uint64_t faultingPC = crashContext.mcontext.__ss.__rip;
+#else
+	const uint64_t faultingPC = crashContext.mcontext.__ss.__pc;
+#endif
+
+	uint64_t pc;
+
+	return walker.WalkThread (crashedThreadIndex, &pc, 1) == 1 && pc == faultingPC;
+}
+
+NOINLINE bool CreateCoreFileSequentially (const std::string& corePath)
+{
+	// Sequential writing is meant for pipes, sockets, etc. A file opened in append mode is a good stand-in: should the
+	//   library seek, the core file would end up corrupted
+	int fd = open (corePath.c_str (), O_WRONLY | O_CREAT | O_TRUNC | O_APPEND, 0666);
+	if (fd < 0)
+		return false;
+
+	MMD::PipeOStream pos (fd);
+
+	return MiniDumpWriteDump (mach_task_self (), &pos);
+}
+
 NOINLINE bool CorruptHeapThenCreateCoreFile (const std::string& corePath)
 {
 	[[maybe_unused]] volatile int local = 20250425;
@@ -312,7 +1108,11 @@ bool CreateOOPWorker (const std::string& operation,
 	return true;
 }
 
-bool LaunchOOPWorkerForOperation (const std::string& operation, bool onBackgroundThread, const std::string& corePath)
+// The crash context is only sent by workers that crash
+bool LaunchOOPWorkerForOperation (const std::string& operation,
+								  bool				 onBackgroundThread,
+								  const std::string& corePath,
+								  MMDCrashContext*	 pCrashContextOut /*= nullptr*/)
 {
 	const bool crash = (operation.find ("Crash") != std::string::npos) || (operation.find ("Abort") != std::string::npos);
 	pid_t	   pid;
@@ -343,6 +1143,9 @@ bool LaunchOOPWorkerForOperation (const std::string& operation, bool onBackgroun
 
 	close (stdOutFd);
 
+	if (pCrashContextOut != nullptr)
+		*pCrashContextOut = crashContext;
+
 	if (!CreateCoreFileImpl (task, corePath, &crashContext))
 		return false;
 
@@ -402,6 +1205,30 @@ void SetupMiscThreads ()
 
 std::map<std::string, std::function<bool (const std::string&)>> g_operations = {
 	{ "CreateCore", CreateCoreFile },
+	{ "CreateCoreSequential", CreateCoreFileSequentially },
+	{ "CreateCorePipelined", CreateCoreFilePipelined },
+	{ "CreateCoreParallel", CreateCoreFileInParallel },
+	{ "CreateCorePageAligned", CreateCoreFilePageAligned },
+	{ "CreateCoreSparse", CreateCoreFileSparse },
+	{ "CreateCoreDeduplicated", CreateCoreFileDeduplicated },
+	{ "EstimateSizeThenCreateCore", EstimateSizeThenCreateCoreFile },
+	{ "CreateCoreWithMemoryBudget", CreateCoreFileWithMemoryBudget },
+	{ "CreateCoreMemoryMapped", CreateCoreFileMemoryMapped },
+	{ "CreateCoreInMemory", CreateCoreFileInMemory },
+	{ "CreateCoreBuffered", CreateCoreFileBuffered },
+	{ "CreateCoreChecksummed", CreateCoreFileChecksummed },
+	{ "CreateCoreCompressed", CreateCoreFileCompressed },
+	{ "CreateCoreRateLimited", CreateCoreFileRateLimited },
+	{ "CreateCoreDirectIO", CreateCoreFileWithDirectIO },
+	{ "CreateCoreAsync", CreateCoreFileAsynchronously },
+	{ "CreateCoreInDumpFilePool", CreateCoreFileInDumpFilePool },
+	{ "CreateCoreSpooled", CreateCoreFileSpooled },
+	{ "CreateCoreThenRead", CreateCoreFileThenRead },
+	{ "CreateCoreThenReadMemory", CreateCoreFileThenReadMemory },
+	{ "CreateCoreThenWalkStacks", CreateCoreFileThenWalkStacks },
+	{ "CreateCoreThenListImages", CreateCoreFileThenListImages },
+	{ "CreateCoresThenCompareSignatures", CreateCoreFilesThenCompareSignatures },
+	{ "CreateCoreThenFindFaultingThread", CreateCoreFileThenFindFaultingThread },
 	{ "CorruptHeapThenCreateCoreFile", CorruptHeapThenCreateCoreFile },
 	{ "CreateCoreFromC", CreateCoreFromC },
 	{ "CrashInvalidPtrWrite", CrashInvalidPtrWrite },
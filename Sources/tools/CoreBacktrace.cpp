@@ -0,0 +1,160 @@
+// Walks the stacks of every thread of core files, offline, and writes the instruction pointers of their frames
+//   Usage: coreBacktrace [-b] [-o outputPath] [corePath...]
+//   Paths of core files are read from the standard input (one per line) if none are given. Exits with 1 if any of the
+//   core files could not be processed (they are still listed).
+//
+//   Text output (default), per core file:
+//     <path> <x86_64|arm64|invalid> <threadCount>
+//     <threadIndex> <frame> <frame> ...   (one line per thread, frames in hexadecimal, the top first)
+//   Binary output (-b): the magic "MMDBT001", then per core file (all integers little-endian):
+//     uint32_t pathLength, char path[pathLength], uint32_t cputype (0 if invalid), uint32_t threadCount,
+//     then per thread: uint32_t frameCount, uint64_t frames[frameCount]
+
+#include <cstdio>
+#include <cstring>
+
+#include <string>
+#include <vector>
+
+#include "MMD/CoreFileReader.hpp"
+#include "MMD/CoreStackWalker.hpp"
+
+namespace {
+
+using MMD::CoreFileReader;
+using MMD::CoreStackWalker;
+using MMD::StackWalkArchitecture;
+
+constexpr size_t MaxStackFrameCount = 8192;
+constexpr size_t OutputBufferSize	= 1024 * 1024;
+
+const char BinaryMagic[8] = { 'M', 'M', 'D', 'B', 'T', '0', '0', '1' };
+
+// Output is written in large chunks, as it is small per core file; never freed, as stdout is flushed at exit
+char g_outputBuffer[OutputBufferSize];
+
+static_assert (__BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__, "the binary output is written in host byte order");
+
+class BacktraceWriter {
+public:
+	BacktraceWriter (FILE* pFile, bool binary);
+
+	bool Write (const char* pCorePath);
+
+private:
+	FILE*				  m_pFile;
+	bool				  m_binary;
+	std::vector<uint64_t> m_frames; // Reused for every thread
+
+	void WriteUInt32 (uint32_t value);
+};
+
+BacktraceWriter::BacktraceWriter (FILE* pFile, bool binary):
+	m_pFile (pFile),
+	m_binary (binary),
+	m_frames (MaxStackFrameCount)
+{
+	if (m_binary)
+		fwrite (BinaryMagic, sizeof BinaryMagic, 1, m_pFile);
+}
+
+bool BacktraceWriter::Write (const char* pCorePath)
+{
+	const CoreFileReader  reader (pCorePath);
+	const CoreStackWalker walker (reader);
+
+	const bool	   valid	   = walker.IsValid ();
+	const uint32_t threadCount = uint32_t (walker.GetThreadCount ());
+	if (m_binary) {
+		WriteUInt32 (uint32_t (strlen (pCorePath)));
+		fwrite (pCorePath, strlen (pCorePath), 1, m_pFile);
+		WriteUInt32 (valid ? uint32_t (reader.GetHeader ()->cputype) : 0);
+		WriteUInt32 (threadCount);
+	} else {
+		const char* pArchitectureName = "invalid";
+		if (valid)
+			pArchitectureName = walker.GetArchitecture () == StackWalkArchitecture::ARM64 ? "arm64" : "x86_64";
+
+		fprintf (m_pFile, "%s %s %u\n", pCorePath, pArchitectureName, threadCount);
+	}
+
+	for (uint32_t i = 0; i < threadCount; ++i) {
+		const size_t nFrames = walker.WalkThread (i, m_frames.data (), m_frames.size ());
+		if (m_binary) {
+			WriteUInt32 (uint32_t (nFrames));
+			fwrite (m_frames.data (), sizeof (uint64_t), nFrames, m_pFile);
+		} else {
+			fprintf (m_pFile, "%u", i);
+			for (size_t j = 0; j < nFrames; ++j)
+				fprintf (m_pFile, " %llx", static_cast<unsigned long long> (m_frames[j]));
+			fputc ('\n', m_pFile);
+		}
+	}
+
+	return valid;
+}
+
+void BacktraceWriter::WriteUInt32 (uint32_t value)
+{
+	fwrite (&value, sizeof value, 1, m_pFile);
+}
+
+} // namespace
+
+int main (int argc, char* argv[])
+{
+	bool		binary		= false;
+	const char* pOutputPath = nullptr;
+	int			argIndex	= 1;
+	for (; argIndex < argc && argv[argIndex][0] == '-'; ++argIndex) {
+		if (strcmp (argv[argIndex], "-b") == 0) {
+			binary = true;
+		} else if (strcmp (argv[argIndex], "-o") == 0 && argIndex + 1 < argc) {
+			pOutputPath = argv[++argIndex];
+		} else {
+			fprintf (stderr, "Usage: %s [-b] [-o outputPath] [corePath...]\n", argv[0]);
+
+			return 2;
+		}
+	}
+
+	FILE* pOutputFile = pOutputPath != nullptr ? fopen (pOutputPath, binary ? "wb" : "w") : stdout;
+	if (pOutputFile == nullptr) {
+		fprintf (stderr, "Failed to open %s\n", pOutputPath);
+
+		return 2;
+	}
+
+	setvbuf (pOutputFile, g_outputBuffer, _IOFBF, sizeof g_outputBuffer);
+
+	BacktraceWriter writer (pOutputFile, binary);
+
+	bool succeeded = true;
+	if (argIndex < argc) {
+		for (; argIndex < argc; ++argIndex)
+			succeeded = writer.Write (argv[argIndex]) && succeeded;
+	} else {
+		std::string path;
+		for (int c = getchar (); c != EOF; c = getchar ()) {
+			if (c != '\n') {
+				path += char (c);
+				continue;
+			}
+
+			if (!path.empty ())
+				succeeded = writer.Write (path.c_str ()) && succeeded;
+			path.clear ();
+		}
+
+		if (!path.empty ())
+			succeeded = writer.Write (path.c_str ()) && succeeded;
+	}
+
+	if (fflush (pOutputFile) != 0 || (pOutputFile != stdout && fclose (pOutputFile) != 0)) {
+		fprintf (stderr, "Failed to write the output\n");
+
+		return 2;
+	}
+
+	return succeeded ? 0 : 1;
+}
@@ -0,0 +1,114 @@
+// Prints the crash signatures of core files (see CrashSignature.hpp), for deduplicating crashes before processing them
+//   any further
+//   Usage: coreSignature [-n frameCount] [-t threadIndex] [-v] [corePath...]
+//   Paths of core files are read from the standard input (one per line) if none are given. The crashed thread is found
+//   from the exception states of threads, unless given; if none is found, the first thread is used. Exits with 1 if the
+//   signature of any of the core files could not be generated.
+//
+//   Output per core file:
+//     <signature> <path>   (the signature in hexadecimal, high half first; "-" if it could not be generated)
+//   followed by the normalized frames, if -v is given:
+//     <image UUID> <offset>
+
+#include <cinttypes>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include "MMD/CrashSignature.hpp"
+
+namespace {
+
+using MMD::CoreFileReader;
+using MMD::CrashSignatureGenerator;
+
+struct Settings {
+	size_t frameCount  = CrashSignatureGenerator::DefaultFrameCount;
+	size_t threadIndex = CrashSignatureGenerator::NotFound; // Found from exception states
+	bool   verbose	   = false;
+};
+
+void PrintUUID (const uint8_t* pUUID)
+{
+	for (size_t i = 0; i < 16; ++i)
+		printf (i == 4 || i == 6 || i == 8 || i == 10 ? "-%02X" : "%02X", pUUID[i]);
+}
+
+bool PrintSignature (const char* pCorePath, const Settings& settings)
+{
+	const CoreFileReader		  reader (pCorePath);
+	const CrashSignatureGenerator generator (reader);
+
+	size_t threadIndex = settings.threadIndex;
+	if (threadIndex == CrashSignatureGenerator::NotFound)
+		threadIndex = generator.FindCrashedThread ();
+	if (threadIndex == CrashSignatureGenerator::NotFound)
+		threadIndex = 0;
+
+	CrashSignatureGenerator::Signature signature;
+	if (!generator.Generate (threadIndex, settings.frameCount, &signature)) {
+		printf ("- %s\n", pCorePath);
+
+		return false;
+	}
+
+	printf ("%016" PRIx64 "%016" PRIx64 " %s\n", signature.high, signature.low, pCorePath);
+
+	if (settings.verbose) {
+		std::vector<CrashSignatureGenerator::Frame> frames (settings.frameCount);
+		frames.resize (generator.GetFrames (threadIndex, frames.data (), frames.size ()));
+		for (const CrashSignatureGenerator::Frame& frame : frames) {
+			printf ("  ");
+			PrintUUID (frame.imageUUID);
+			printf (" %" PRIx64 "\n", frame.offset);
+		}
+	}
+
+	return true;
+}
+
+} // namespace
+
+int main (int argc, char* argv[])
+{
+	Settings settings;
+
+	int argIndex = 1;
+	for (; argIndex < argc && argv[argIndex][0] == '-'; ++argIndex) {
+		const bool hasValue = argIndex + 1 < argc;
+		if (strcmp (argv[argIndex], "-n") == 0 && hasValue) {
+			settings.frameCount = strtoull (argv[++argIndex], nullptr, 10);
+		} else if (strcmp (argv[argIndex], "-t") == 0 && hasValue) {
+			settings.threadIndex = strtoull (argv[++argIndex], nullptr, 10);
+		} else if (strcmp (argv[argIndex], "-v") == 0) {
+			settings.verbose = true;
+		} else {
+			fprintf (stderr, "Usage: %s [-n frameCount] [-t threadIndex] [-v] [corePath...]\n", argv[0]);
+
+			return 2;
+		}
+	}
+
+	if (settings.frameCount == 0) {
+		fprintf (stderr, "At least one frame is needed\n");
+
+		return 2;
+	}
+
+	bool succeeded = true;
+	if (argIndex < argc) {
+		for (; argIndex < argc; ++argIndex)
+			succeeded = PrintSignature (argv[argIndex], settings) && succeeded;
+	} else {
+		for (std::string path; std::getline (std::cin, path);) {
+			if (!path.empty ())
+				succeeded = PrintSignature (path.c_str (), settings) && succeeded;
+		}
+	}
+
+	return succeeded ? 0 : 1;
+}
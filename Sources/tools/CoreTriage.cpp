@@ -0,0 +1,429 @@
+// Triages batches of core files in parallel: walks the stacks of their threads, and lists their images (from the "all
+//   image infos" note). Core files are processed on a work-stealing thread pool; results are streamed to a single
+//   output, in the order core files are done (output files are written asynchronously, see AsyncFileOStream.hpp).
+//   Throughput and the distribution of the latency per core file are reported to the standard error at the end.
+//   Usage: coreTriage [-j threadCount] [-o outputPath] [-l listPath] [directory | corePath]...
+//   The thread count defaults to the number of hardware threads, and is at most 256.
+//   Directories are expanded to the regular files in them (not recursively). List files hold paths of core files, one
+//   per line ("-" is the standard input). Exits with 1 if any of the core files could not be processed.
+//
+//   Output per core file:
+//     core <path> <x86_64|arm64|invalid> <threadCount> <imageCount> <microseconds>
+//     thread <threadIndex> <frame> <frame> ...   (frames in hexadecimal, the top first)
+//     image <loadAddress> <uuid> <path>
+
+#include <dirent.h>
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <cinttypes>
+#include <cstdio>
+#include <cstring>
+
+#include <algorithm>
+#include <chrono>
+#include <fstream>
+#include <iostream>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "MMD/AsyncFileOStream.hpp"
+#include "MMD/CoreFileReader.hpp"
+#include "MMD/CoreImageList.hpp"
+#include "MMD/CoreStackWalker.hpp"
+#include "MMD/FileDescriptorIO.hpp"
+
+#include "WorkStealingPool.hpp"
+
+namespace {
+
+using MMD::CoreFileReader;
+using MMD::CoreImageList;
+using MMD::CoreStackWalker;
+using MMD::ISequentialBinaryOStream;
+using MMD::StackWalkArchitecture;
+
+constexpr size_t MaxStackFrameCount = 8192;
+constexpr size_t OutputChunkSize	= 256 * 1024; // Output of a worker is written once this much is collected
+constexpr size_t LatencyBucketCount = 40;		  // Bucket i holds latencies in [2^(i-1), 2^i) microseconds
+constexpr size_t MaxThreadCount		= 256;		  // -j is clamped to this, each thread gets its own output chunk
+
+// Per worker, merged at the end. On separate cache lines, as workers update theirs for every core file.
+struct alignas (64) WorkerStatistics {
+	uint64_t coreCount		 = 0;
+	uint64_t failedCoreCount = 0;
+	uint64_t byteCount		 = 0;
+	uint64_t threadCount	 = 0;
+	uint64_t frameCount		 = 0;
+	uint64_t imageCount		 = 0;
+	uint64_t maxLatency		 = 0; // Microseconds
+
+	uint64_t latencyBuckets[LatencyBucketCount] = {};
+
+	void Add (const WorkerStatistics& other);
+};
+
+void WorkerStatistics::Add (const WorkerStatistics& other)
+{
+	coreCount += other.coreCount;
+	failedCoreCount += other.failedCoreCount;
+	byteCount += other.byteCount;
+	threadCount += other.threadCount;
+	frameCount += other.frameCount;
+	imageCount += other.imageCount;
+	maxLatency = std::max (maxLatency, other.maxLatency);
+
+	for (size_t i = 0; i < LatencyBucketCount; ++i)
+		latencyBuckets[i] += other.latencyBuckets[i];
+}
+
+size_t GetLatencyBucket (uint64_t microseconds)
+{
+	size_t bucket = 0;
+	while (microseconds != 0 && bucket < LatencyBucketCount - 1) {
+		microseconds >>= 1;
+		++bucket;
+	}
+
+	return bucket;
+}
+
+// In the usual form (as printed by dwarfdump --uuid)
+void AppendUUID (const uint8_t* pUUID, std::string* pOutput)
+{
+	const char Digits[] = "0123456789ABCDEF";
+	for (size_t i = 0; i < 16; ++i) {
+		if (i == 4 || i == 6 || i == 8 || i == 10)
+			*pOutput += '-';
+
+		*pOutput += Digits[pUUID[i] >> 4];
+		*pOutput += Digits[pUUID[i] & 0xF];
+	}
+}
+
+// The standard output might be a pipe, which can't be written at offsets (asynchronously)
+class StandardOutputStream : public ISequentialBinaryOStream {
+public:
+	bool Write (const void* pData, size_t size) override;
+	bool Flush () override;
+};
+
+bool StandardOutputStream::Write (const void* pData, size_t size)
+{
+	return MMD::WriteAll (STDOUT_FILENO, pData, size);
+}
+
+bool StandardOutputStream::Flush ()
+{
+	return true;
+}
+
+class Triage {
+public:
+	Triage (ISequentialBinaryOStream* pOutput, size_t workerCount);
+
+	void ProcessCore (const std::string& corePath, size_t workerIndex);
+	bool Finish (); // Writes the rest of the output
+
+	WorkerStatistics GetStatistics () const;
+
+private:
+	struct Worker {
+		std::string			  output;
+		std::vector<uint64_t> frames = std::vector<uint64_t> (MaxStackFrameCount);
+		WorkerStatistics	  statistics;
+	};
+
+	ISequentialBinaryOStream* m_pOutput;
+	std::mutex				  m_outputMutex; // The position of the output is not thread-safe
+	bool					  m_outputFailed = false;
+	std::vector<Worker>		  m_workers;
+
+	void AppendCore (const std::string& corePath, Worker* pWorker, uint64_t* pLatencyOut);
+	void WriteOutput (std::string* pOutput);
+};
+
+Triage::Triage (ISequentialBinaryOStream* pOutput, size_t workerCount): m_pOutput (pOutput), m_workers (workerCount)
+{
+}
+
+void Triage::ProcessCore (const std::string& corePath, size_t workerIndex)
+{
+	Worker& worker = m_workers[workerIndex];
+
+	uint64_t latency;
+	AppendCore (corePath, &worker, &latency);
+
+	worker.statistics.maxLatency = std::max (worker.statistics.maxLatency, latency);
+	++worker.statistics.latencyBuckets[GetLatencyBucket (latency)];
+
+	if (worker.output.size () >= OutputChunkSize)
+		WriteOutput (&worker.output);
+}
+
+bool Triage::Finish ()
+{
+	for (Worker& worker : m_workers)
+		WriteOutput (&worker.output);
+
+	return !m_outputFailed && m_pOutput->Flush ();
+}
+
+WorkerStatistics Triage::GetStatistics () const
+{
+	WorkerStatistics statistics;
+	for (const Worker& worker : m_workers)
+		statistics.Add (worker.statistics);
+
+	return statistics;
+}
+
+// Everything from opening the core file to formatting its results counts towards the latency
+void Triage::AppendCore (const std::string& corePath, Worker* pWorker, uint64_t* pLatencyOut)
+{
+	const auto start = std::chrono::steady_clock::now ();
+
+	const CoreFileReader  reader (corePath.c_str ());
+	const CoreStackWalker walker (reader);
+	const CoreImageList	  imageList (reader);
+
+	WorkerStatistics& statistics = pWorker->statistics;
+	std::string&	  output	 = pWorker->output;
+
+	const bool valid = walker.IsValid () && imageList.IsValid ();
+	++statistics.coreCount;
+	if (!valid)
+		++statistics.failedCoreCount;
+	if (reader.IsValid ())
+		statistics.byteCount += reader.GetSize ();
+
+	const char* pArchitectureName = "invalid";
+	if (valid)
+		pArchitectureName = walker.GetArchitecture () == StackWalkArchitecture::ARM64 ? "arm64" : "x86_64";
+
+	// The header is written last, once the latency is known; its place is kept
+	const size_t headerPosition = output.size ();
+
+	char buffer[64];
+	for (size_t i = 0; i < walker.GetThreadCount (); ++i) {
+		const size_t nFrames = walker.WalkThread (i, pWorker->frames.data (), pWorker->frames.size ());
+
+		snprintf (buffer, sizeof buffer, "thread %zu", i);
+		output += buffer;
+		for (size_t j = 0; j < nFrames; ++j) {
+			snprintf (buffer, sizeof buffer, " %" PRIx64, pWorker->frames[j]);
+			output += buffer;
+		}
+		output += '\n';
+
+		++statistics.threadCount;
+		statistics.frameCount += nFrames;
+	}
+
+	for (size_t i = 0; i < imageList.GetImageCount (); ++i) {
+		const CoreImageList::Image& image = imageList.GetImage (i);
+		snprintf (buffer, sizeof buffer, "image %" PRIx64 " ", image.loadAddress);
+		output += buffer;
+		AppendUUID (image.pUUID, &output);
+		output += ' ';
+		output += image.pPath;
+		output += '\n';
+
+		++statistics.imageCount;
+	}
+
+	const auto end = std::chrono::steady_clock::now ();
+	*pLatencyOut   = uint64_t (std::chrono::duration_cast<std::chrono::microseconds> (end - start).count ());
+
+	const std::string header = "core " + corePath + " " + pArchitectureName + " " +
+							   std::to_string (walker.GetThreadCount ()) + " " +
+							   std::to_string (imageList.GetImageCount ()) + " " + std::to_string (*pLatencyOut) + "\n";
+	output.insert (headerPosition, header);
+}
+
+void Triage::WriteOutput (std::string* pOutput)
+{
+	{
+		std::lock_guard<std::mutex> lock (m_outputMutex);
+		if (!pOutput->empty () && !m_pOutput->Write (pOutput->data (), pOutput->size ()))
+			m_outputFailed = true;
+	}
+
+	pOutput->clear ();
+}
+
+// Bounds of the latency buckets holding the given fraction of the core files
+uint64_t GetLatencyPercentile (const WorkerStatistics& statistics, double fraction)
+{
+	const uint64_t target = uint64_t (statistics.coreCount * fraction);
+
+	uint64_t count = 0;
+	for (size_t i = 0; i < LatencyBucketCount; ++i) {
+		count += statistics.latencyBuckets[i];
+		if (count > target)
+			return i == 0 ? 1 : uint64_t (1) << i;
+	}
+
+	return statistics.maxLatency;
+}
+
+void ReportStatistics (const WorkerStatistics& statistics, double seconds, size_t threadCount)
+{
+	fprintf (stderr,
+			 "Triaged %" PRIu64 " core files (%" PRIu64 " failed) in %.3f s on %zu threads: %.1f files/s, %.1f MB/s\n",
+			 statistics.coreCount,
+			 statistics.failedCoreCount,
+			 seconds,
+			 threadCount,
+			 statistics.coreCount / seconds,
+			 statistics.byteCount / seconds / (1024.0 * 1024.0));
+	fprintf (stderr,
+			 "  %" PRIu64 " threads, %" PRIu64 " frames, %" PRIu64 " images\n",
+			 statistics.threadCount,
+			 statistics.frameCount,
+			 statistics.imageCount);
+
+	fprintf (stderr, "Latency per core file (microseconds):\n");
+	for (size_t i = 0; i < LatencyBucketCount; ++i) {
+		if (statistics.latencyBuckets[i] == 0)
+			continue;
+
+		const uint64_t lowerBound = i == 0 ? 0 : uint64_t (1) << (i - 1);
+		const uint64_t upperBound = i == 0 ? 1 : uint64_t (1) << i;
+		fprintf (stderr,
+				 "  [%8" PRIu64 ", %8" PRIu64 ") %10" PRIu64 "\n",
+				 lowerBound,
+				 upperBound,
+				 statistics.latencyBuckets[i]);
+	}
+
+	fprintf (stderr,
+			 "  p50 < %" PRIu64 ", p90 < %" PRIu64 ", p99 < %" PRIu64 ", max %" PRIu64 "\n",
+			 GetLatencyPercentile (statistics, 0.5),
+			 GetLatencyPercentile (statistics, 0.9),
+			 GetLatencyPercentile (statistics, 0.99),
+			 statistics.maxLatency);
+}
+
+// Directories are expanded to the regular files in them, in no particular order
+bool AddCorePaths (const char* pPath, std::vector<std::string>* pCorePathsOut)
+{
+	struct stat info;
+	if (stat (pPath, &info) != 0 || !S_ISDIR (info.st_mode)) {
+		pCorePathsOut->push_back (pPath);
+
+		return true;
+	}
+
+	DIR* pDirectory = opendir (pPath);
+	if (pDirectory == nullptr)
+		return false;
+
+	const std::string directoryPath = pPath;
+	while (const dirent* pEntry = readdir (pDirectory)) {
+		const std::string path = directoryPath + "/" + pEntry->d_name;
+		if (stat (path.c_str (), &info) == 0 && S_ISREG (info.st_mode))
+			pCorePathsOut->push_back (path);
+	}
+
+	closedir (pDirectory);
+
+	return true;
+}
+
+bool AddCorePathsFromList (const char* pListPath, std::vector<std::string>* pCorePathsOut)
+{
+	std::ifstream listFile;
+	if (strcmp (pListPath, "-") != 0) {
+		listFile.open (pListPath);
+		if (!listFile)
+			return false;
+	}
+
+	std::istream& list = strcmp (pListPath, "-") == 0 ? std::cin : listFile;
+	for (std::string path; std::getline (list, path);) {
+		if (!path.empty ())
+			pCorePathsOut->push_back (path);
+	}
+
+	return true;
+}
+
+} // namespace
+
+int main (int argc, char* argv[])
+{
+	size_t					 threadCount = std::max (std::thread::hardware_concurrency (), 1u);
+	const char*				 pOutputPath = nullptr;
+	std::vector<std::string> corePaths;
+
+	int argIndex = 1;
+	for (; argIndex < argc; ++argIndex) {
+		const bool hasValue = argIndex + 1 < argc;
+		if (strcmp (argv[argIndex], "-j") == 0 && hasValue) {
+			threadCount = std::clamp<size_t> (strtoull (argv[++argIndex], nullptr, 10), 1, MaxThreadCount);
+		} else if (strcmp (argv[argIndex], "-o") == 0 && hasValue) {
+			pOutputPath = argv[++argIndex];
+		} else if (strcmp (argv[argIndex], "-l") == 0 && hasValue) {
+			if (!AddCorePathsFromList (argv[++argIndex], &corePaths)) {
+				fprintf (stderr, "Failed to read the list %s\n", argv[argIndex]);
+
+				return 2;
+			}
+		} else if (argv[argIndex][0] == '-') {
+			fprintf (stderr,
+					 "Usage: %s [-j threadCount] [-o outputPath] [-l listPath] [directory | corePath]...\n",
+					 argv[0]);
+
+			return 2;
+		} else if (!AddCorePaths (argv[argIndex], &corePaths)) {
+			fprintf (stderr, "Failed to list the directory %s\n", argv[argIndex]);
+
+			return 2;
+		}
+	}
+
+	// Output files are written asynchronously, so that workers only wait for each other while copying their output
+	StandardOutputStream				   standardOutput;
+	std::unique_ptr<MMD::AsyncFileOStream> pOutputFile;
+	ISequentialBinaryOStream*			   pOutput = &standardOutput;
+	if (pOutputPath != nullptr) {
+		pOutputFile.reset (new MMD::AsyncFileOStream (open (pOutputPath, O_WRONLY | O_CREAT | O_TRUNC, 0666)));
+		if (!pOutputFile->IsValid ()) {
+			fprintf (stderr, "Failed to open %s\n", pOutputPath);
+
+			return 2;
+		}
+
+		pOutput = pOutputFile.get ();
+	}
+
+	const auto start = std::chrono::steady_clock::now ();
+
+	Triage triage (pOutput, threadCount);
+	{
+		MMD::WorkStealingPool pool (threadCount);
+		pool.Run (corePaths.size (), [&] (size_t itemIndex, size_t workerIndex) {
+			triage.ProcessCore (corePaths[itemIndex], workerIndex);
+		});
+	}
+
+	const bool outputSucceeded = triage.Finish ();
+
+	const auto end = std::chrono::steady_clock::now ();
+
+	const WorkerStatistics statistics = triage.GetStatistics ();
+	ReportStatistics (statistics, std::chrono::duration<double> (end - start).count (), threadCount);
+
+	if (!outputSucceeded) {
+		fprintf (stderr, "Failed to write the output\n");
+
+		return 2;
+	}
+
+	return statistics.failedCoreCount == 0 ? 0 : 1;
+}
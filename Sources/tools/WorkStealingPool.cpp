@@ -0,0 +1,162 @@
+#include "WorkStealingPool.hpp"
+
+#include <algorithm>
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace MMD {
+
+namespace {
+
+// Items [begin, end) not taken yet: the owner takes them from the front, thieves from the back. On separate cache
+//   lines, as owners update theirs for every item.
+struct alignas (64) ItemRange {
+	std::mutex mutex;
+	size_t	   begin = 0;
+	size_t	   end	 = 0;
+};
+
+} // namespace
+
+struct WorkStealingPool::State {
+	std::vector<std::thread> threads;
+	std::vector<ItemRange>	 ranges; // One per worker
+
+	std::mutex				mutex;
+	std::condition_variable batchStarted;
+	std::condition_variable batchFinished;
+	const Function*			pFunction		   = nullptr;
+	uint64_t				batchNumber		   = 0;
+	size_t					runningWorkerCount = 0;
+	bool					stopping		   = false;
+
+	explicit State (size_t threadCount): ranges (threadCount) {}
+};
+
+WorkStealingPool::WorkStealingPool (size_t threadCount): m_pState (new State (std::max<size_t> (threadCount, 1)))
+{
+	for (size_t i = 0; i < m_pState->ranges.size (); ++i)
+		m_pState->threads.emplace_back (&WorkStealingPool::WorkerMain, this, i);
+}
+
+WorkStealingPool::~WorkStealingPool ()
+{
+	{
+		std::lock_guard<std::mutex> lock (m_pState->mutex);
+		m_pState->stopping = true;
+	}
+	m_pState->batchStarted.notify_all ();
+
+	for (std::thread& thread : m_pState->threads)
+		thread.join ();
+}
+
+size_t WorkStealingPool::GetThreadCount () const
+{
+	return m_pState->threads.size ();
+}
+
+void WorkStealingPool::Run (size_t itemCount, const Function& function)
+{
+	State& state = *m_pState;
+
+	std::unique_lock<std::mutex> lock (state.mutex);
+
+	// Workers are all waiting for the batch at this point, so their ranges can be set without locking them
+	const size_t workerCount = state.ranges.size ();
+	for (size_t i = 0; i < workerCount; ++i) {
+		state.ranges[i].begin = itemCount * i / workerCount;
+		state.ranges[i].end	  = itemCount * (i + 1) / workerCount;
+	}
+
+	state.pFunction			 = &function;
+	state.runningWorkerCount = workerCount;
+	++state.batchNumber;
+	state.batchStarted.notify_all ();
+
+	state.batchFinished.wait (lock, [&state] () { return state.runningWorkerCount == 0; });
+	state.pFunction = nullptr;
+}
+
+void WorkStealingPool::WorkerMain (size_t workerIndex)
+{
+	State& state = *m_pState;
+
+	uint64_t lastBatchNumber = 0;
+	while (true) {
+		const Function* pFunction;
+		{
+			std::unique_lock<std::mutex> lock (state.mutex);
+			state.batchStarted.wait (lock, [&] () { return state.stopping || state.batchNumber != lastBatchNumber; });
+			if (state.stopping)
+				return;
+
+			lastBatchNumber = state.batchNumber;
+			pFunction		= state.pFunction;
+		}
+
+		// Stolen items may be stolen again before they are taken, so only stop once nothing is left to steal
+		size_t itemIndex;
+		while (true) {
+			if (TakeItem (workerIndex, &itemIndex))
+				(*pFunction) (itemIndex, workerIndex);
+			else if (!StealItems (workerIndex))
+				break;
+		}
+
+		{
+			std::lock_guard<std::mutex> lock (state.mutex);
+			if (--state.runningWorkerCount == 0)
+				state.batchFinished.notify_one ();
+		}
+	}
+}
+
+bool WorkStealingPool::TakeItem (size_t workerIndex, size_t* pItemIndexOut)
+{
+	ItemRange& range = m_pState->ranges[workerIndex];
+
+	std::lock_guard<std::mutex> lock (range.mutex);
+	if (range.begin == range.end)
+		return false;
+
+	*pItemIndexOut = range.begin++;
+
+	return true;
+}
+
+// Moves the upper half of the items left to another worker (the first one found with any) to this worker. Items are
+//   only ever removed from other workers: once all ranges are empty, they stay empty until the next batch.
+bool WorkStealingPool::StealItems (size_t workerIndex)
+{
+	const size_t workerCount = m_pState->ranges.size ();
+	for (size_t i = 1; i < workerCount; ++i) {
+		ItemRange& victim = m_pState->ranges[(workerIndex + i) % workerCount];
+
+		size_t begin;
+		size_t end;
+		{
+			std::lock_guard<std::mutex> lock (victim.mutex);
+			if (victim.begin == victim.end)
+				continue;
+
+			begin	   = victim.begin + (victim.end - victim.begin) / 2;
+			end		   = victim.end;
+			victim.end = begin;
+		}
+
+		// Not nested in the lock of the victim: thieves of each other would deadlock otherwise
+		ItemRange&					own = m_pState->ranges[workerIndex];
+		std::lock_guard<std::mutex> lock (own.mutex);
+		own.begin = begin;
+		own.end	  = end;
+
+		return true;
+	}
+
+	return false;
+}
+
+} // namespace MMD
@@ -0,0 +1,46 @@
+#ifndef MMD_WORKSTEALINGPOOL
+#define MMD_WORKSTEALINGPOOL
+
+#pragma once
+
+#include <cstddef>
+#include <functional>
+#include <memory>
+
+namespace MMD {
+
+// Runs batches of items on a fixed set of threads. Each worker starts with an equal share of the items of a batch; one
+//   that runs out steals the upper half of the remaining items of another, so that workers stay busy even if the cost
+//   of items varies a lot (as the sizes of core files do).
+class WorkStealingPool {
+public:
+	// Called with the index of the item, and the index of the worker running it (less than GetThreadCount ())
+	using Function = std::function<void (size_t itemIndex, size_t workerIndex)>;
+
+	// Constructors
+	WorkStealingPool () = delete;
+	explicit WorkStealingPool (size_t threadCount); // At least one thread is started
+
+	WorkStealingPool (const WorkStealingPool& rhs)			  = delete;
+	WorkStealingPool& operator= (const WorkStealingPool& rhs) = delete;
+
+	~WorkStealingPool ();
+
+	size_t GetThreadCount () const;
+
+	// Runs function for items [0, itemCount), and returns once all of them are done
+	void Run (size_t itemCount, const Function& function);
+
+private:
+	struct State;
+
+	std::unique_ptr<State> m_pState;
+
+	void WorkerMain (size_t workerIndex);
+	bool TakeItem (size_t workerIndex, size_t* pItemIndexOut);
+	bool StealItems (size_t workerIndex);
+};
+
+} // namespace MMD
+
+#endif // MMD_WORKSTEALINGPOOL